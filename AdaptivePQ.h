@@ -0,0 +1,336 @@
+//  AdaptivePQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A priority queue that picks its own implementation from the workload it
+    observes, and migrates when the workload changes.
+
+    - UnorderedFastPQ while the queue is small: a linear scan over a few
+      cache lines beats maintaining any structure.
+    - BinaryPQ once it grows, for a mix of pushes and pops.
+    - SortedPQ when pops dominate writes (push() and updatePriorities()):
+      its pops are O(1), but each push that a pop reaches costs an O(n)
+      merge. top() is O(1) in all three, so it does not move the choice,
+      and being const it is not counted at all.
+
+    The queue counts its operations over a window of max(MIN_WINDOW,
+    n / WINDOW_DIVISOR) mutating calls. At the end of each window it picks
+    the representation the counters favor. Migrating lists the elements in
+    pop order and builds the new representation from that range, in
+    O(n log n). A migration takes at least two windows, so this adds
+    O(log n) amortized per call.
+
+    Listing the elements is O(n) for SortedPQ, which reads its sorted run
+    backwards, and for a non-stable BinaryPQ, whose heap order is as good a
+    range as any. Otherwise the old representation is drained with pops.
+
+    Two kinds of hysteresis keep the queue from flapping:
+    - Every threshold has a separate enter and leave level.
+    - A migration only happens after two windows in a row ask for the same
+      new representation.
+
+*/
+
+#ifndef ADAPTIVEPQ_H
+#define ADAPTIVEPQ_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "Eecs281PQ.h"
+#include "BinaryPQ.h"
+#include "SortedPQ.h"
+#include "UnorderedFastPQ.h"
+
+// A priority queue facade that forwards to UnorderedFastPQ, BinaryPQ or
+// SortedPQ, whichever suits the recent workload.
+// With STABLE = true, elements of equal priority come out in FIFO order; a
+// migration keeps that order, because the drained range lists equal
+// elements oldest first.
+template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+         bool STABLE = false>
+class AdaptivePQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
+{
+    // This is a way to refer to the base class object.
+    using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
+
+public:
+
+    // The implementations the queue can switch between.
+    enum class Representation { UNORDERED, BINARY, SORTED };
+
+    // Counts of the mutating operations, either over the whole lifetime or
+    // over one window.
+    struct Counters
+    {
+        std::size_t pushes = 0;
+        std::size_t pops = 0;
+        std::size_t updates = 0;
+    }; // Counters
+
+
+    // Description: Construct an empty heap with an optional comparison functor.
+    // Runtime: O(1)
+    explicit AdaptivePQ(COMP_FUNCTOR comp = COMP_FUNCTOR()) :
+    BaseClass{ comp }
+    {
+        std::vector<TYPE> none;
+        rep = make(Representation::UNORDERED, none);
+    } // AdaptivePQ
+
+
+    // Description: Construct a heap out of an iterator range with an optional
+    //              comparison functor. The first representation is chosen
+    //              from the size alone.
+    // Runtime: O(n) where n is number of elements in range.
+    template<typename InputIterator>
+    AdaptivePQ(InputIterator start, InputIterator end,
+            COMP_FUNCTOR comp = COMP_FUNCTOR()) :
+            BaseClass{ comp }
+    {
+        std::vector<TYPE> all{ start, end };
+        kind = all.size() > SMALL_SIZE ? Representation::BINARY : Representation::UNORDERED;
+        pending = kind;
+        rep = make(kind, all);
+        windowLength = std::max(MIN_WINDOW, all.size() / WINDOW_DIVISOR);
+    } // AdaptivePQ
+
+
+    // The representation cannot be copied through the base class.
+    AdaptivePQ(const AdaptivePQ &) = delete;
+    AdaptivePQ &operator=(const AdaptivePQ &) = delete;
+
+
+    // Description: Destructor doesn't need any code, the representation
+    //              will be destroyed automatically.
+    virtual ~AdaptivePQ()
+    {} // ~AdaptivePQ()
+
+
+    // Description: Add a new element to the heap.
+    // Runtime: That of the current representation, plus O(log(n)) amortized.
+    virtual void push(const TYPE &val)
+    {
+        rep->push(val);
+        ++window.pushes;
+        ++total.pushes;
+        endOfCall();
+    } // push()
+
+
+    // Description: Remove the most extreme (defined by 'compare') element from
+    //              the heap.
+    // Runtime: That of the current representation, plus O(log(n)) amortized.
+    virtual void pop()
+    {
+        rep->pop();
+        ++window.pops;
+        ++total.pops;
+        endOfCall();
+    } // pop()
+
+
+    // Description: Return the most extreme (defined by 'compare') element of
+    //              the heap. Neither counted nor migrating, since it is const.
+    // Runtime: That of the current representation.
+    virtual const TYPE &top() const
+    {
+        return rep->top();
+    } // top()
+
+
+    // Description: Get the number of elements in the heap.
+    // Runtime: O(1)
+    virtual std::size_t size() const
+    {
+        return rep->size();
+    } // size()
+
+
+    // Description: Return true if the heap is empty.
+    // Runtime: O(1)
+    virtual bool empty() const
+    {
+        return rep->empty();
+    } // empty()
+
+
+    // Description: Assumes that all elements inside the heap are out of order and
+    //              'rebuilds' the heap by fixing the heap invariant.
+    // Runtime: That of the current representation.
+    virtual void updatePriorities()
+    {
+        rep->updatePriorities();
+        ++window.updates;
+        ++total.updates;
+        endOfCall();
+    } // updatePriorities()
+
+
+    // Description: The representation currently in use.
+    // Runtime: O(1)
+    Representation representation() const
+    {
+        return kind;
+    } // representation()
+
+
+    // Description: Operation counts since construction.
+    // Runtime: O(1)
+    const Counters &counters() const
+    {
+        return total;
+    } // counters()
+
+
+    // Description: The number of migrations so far.
+    // Runtime: O(1)
+    std::size_t migrations() const
+    {
+        return numMigrations;
+    } // migrations()
+
+
+private:
+
+    // Queues of at most this many elements stay unordered. Leaving the
+    // unordered representation takes twice as many.
+    static constexpr std::size_t SMALL_SIZE = 32;
+
+    // The shortest window, in mutating calls, and the fraction of the size
+    // that longer windows span.
+    static constexpr std::size_t MIN_WINDOW = 64;
+    static constexpr std::size_t WINDOW_DIVISOR = 16;
+
+    // Switching to SortedPQ needs ENTER_SORTED pops per write in a window.
+    // Staying with it needs only LEAVE_SORTED pops per write. Random pushes
+    // soon reach the top of a shrinking sorted run, and each one that does
+    // costs an O(n) merge, so SortedPQ only wins when pushes are rare.
+    static constexpr std::size_t ENTER_SORTED = 512;
+    static constexpr std::size_t LEAVE_SORTED = 128;
+
+    std::unique_ptr<BaseClass> rep;
+    Representation kind = Representation::UNORDERED;
+
+    // the representation the previous window asked for
+    Representation pending = Representation::UNORDERED;
+
+    // counts for the current window and for the whole lifetime
+    Counters window;
+    Counters total;
+    std::size_t windowCalls = 0;
+    std::size_t windowLength = MIN_WINDOW;
+    std::size_t numMigrations = 0;
+
+
+    // Description: Build a representation holding elts. elts lists equal
+    //              elements oldest first, which is what every range
+    //              constructor expects in stable mode.
+    // Runtime: O(n) for unordered and binary, O(n log n) at worst for sorted.
+    std::unique_ptr<BaseClass> make(Representation to, const std::vector<TYPE> &elts) const
+    {
+        switch (to)
+        {
+        case Representation::BINARY:
+            return std::make_unique<BinaryPQ<TYPE, COMP_FUNCTOR, STABLE>>(
+                elts.begin(), elts.end(), this->compare);
+        case Representation::SORTED:
+            return std::make_unique<SortedPQ<TYPE, COMP_FUNCTOR, STABLE>>(
+                elts.begin(), elts.end(), this->compare);
+        default:
+            return std::make_unique<UnorderedFastPQ<TYPE, COMP_FUNCTOR, STABLE>>(
+                elts.begin(), elts.end(), this->compare);
+        } // switch
+    } // make()
+
+
+    // Description: The representation the last window's counters favor.
+    //              The bands between enter and leave levels make the choice
+    //              depend on the current representation.
+    // Runtime: O(1)
+    Representation choose() const
+    {
+        const std::size_t n = rep->size();
+        if (n <= SMALL_SIZE ||
+            (kind == Representation::UNORDERED && n <= 2 * SMALL_SIZE))
+            return Representation::UNORDERED;
+
+        const std::size_t writes = window.pushes + window.updates;
+        const std::size_t ratio = kind == Representation::SORTED ? LEAVE_SORTED : ENTER_SORTED;
+        return window.pops >= ratio * writes ? Representation::SORTED : Representation::BINARY;
+    } // choose()
+
+
+    // Description: Count a mutating call, and at the end of a window decide
+    //              whether to migrate.
+    // Runtime: O(1), or O(n log n) when migrating.
+    void endOfCall()
+    {
+        if (++windowCalls < windowLength)
+            return;
+
+        const Representation wanted = choose();
+        if (wanted != kind && wanted == pending)
+            migrate(wanted);
+        pending = wanted;
+
+        window = Counters{};
+        windowCalls = 0;
+        windowLength = std::max(MIN_WINDOW, rep->size() / WINDOW_DIVISOR);
+    } // endOfCall()
+
+
+    // Description: Move every element into a new representation.
+    // Runtime: O(n log n)
+    void migrate(Representation to)
+    {
+        std::vector<TYPE> all;
+        all.reserve(rep->size());
+        list(all);
+        rep = make(to, all);
+        kind = to;
+        ++numMigrations;
+    } // migrate()
+
+
+    // Description: Append every element to all, in pop order, which lists
+    //              equal elements oldest first. Without STABLE any order
+    //              will do.
+    // Runtime: O(n) for sorted and non-stable binary, O(n log n) otherwise.
+    void list(std::vector<TYPE> &all)
+    {
+        if (kind == Representation::SORTED)
+        {
+            const auto &sorted =
+                static_cast<SortedPQ<TYPE, COMP_FUNCTOR, STABLE> *>(rep.get())->sorted_view();
+            all.assign(std::make_reverse_iterator(sorted.end()),
+                       std::make_reverse_iterator(sorted.begin()));
+            return;
+        } // if
+
+        if constexpr (!STABLE)
+        {
+            if (kind == Representation::BINARY)
+            {
+                auto heap = static_cast<BinaryPQ<TYPE, COMP_FUNCTOR> *>(rep.get())->heap_order();
+                all.assign(heap.begin(), heap.end());
+                return;
+            } // if
+        } // if
+
+        while (!rep->empty())
+        {
+            all.push_back(rep->top());
+            rep->pop();
+        } // while
+    } // list()
+
+
+}; // AdaptivePQ
+
+#endif // ADAPTIVEPQ_H
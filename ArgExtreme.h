@@ -0,0 +1,161 @@
+//  ArgExtreme.h
+//  p2b-priority-queues
+//
+
+/*
+
+    The index of the most extreme element of an unsorted array, i.e. the
+    scan behind top() in the unordered priority queues.
+
+    The kernel is picked at compile time from the element type and the
+    comparison functor:
+
+    - Arithmetic keys under std::less / std::greater: the max (or min) is
+      reduced into LANES independent accumulators, a loop the compiler maps
+      onto SIMD registers (SSE2 by default, AVX2 or AVX-512 under -mavx2,
+      -mavx512f or -march=native), then a second pass finds the first
+      element equal to it.
+    - Any other functor: CHUNKS interleaved running bests, so that the
+      comparisons of neighboring elements do not wait on each other.
+
+    Above parallel::PARALLEL_THRESHOLD elements argExtreme() also splits the
+    array across threads (see Parallel.h) and reduces the per-thread
+    results. Every variant returns what the plain scalar loop would: the
+    first index among equally extreme elements.
+
+*/
+
+#ifndef ARGEXTREME_H
+#define ARGEXTREME_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+#include "Parallel.h"
+
+namespace argextreme
+{
+
+// Accumulators in the SIMD kernel; 16 fills an AVX-512 register of 32-bit
+// keys, or two AVX2 registers.
+constexpr std::size_t LANES = 16;
+
+// Independent running bests in the generic kernel.
+constexpr std::size_t CHUNKS = 4;
+
+// True when the SIMD kernel applies.
+template <typename TYPE, typename COMP_FUNCTOR>
+constexpr bool IS_SIMD = std::is_arithmetic_v<TYPE> &&
+    (std::is_same_v<COMP_FUNCTOR, std::less<TYPE>> ||
+     std::is_same_v<COMP_FUNCTOR, std::greater<TYPE>>);
+
+
+// Description: The max (std::less) or min (std::greater) of a non-empty
+//              array, reduced in LANES independent accumulators.
+// Runtime: O(n)
+template <typename TYPE, typename COMP_FUNCTOR>
+TYPE extremeValue(const TYPE *data, std::size_t n)
+{
+    constexpr bool isMax = std::is_same_v<COMP_FUNCTOR, std::less<TYPE>>;
+    auto better = [](TYPE a, TYPE b) { return isMax ? (a < b ? b : a) : (b < a ? b : a); };
+
+    TYPE lanes[LANES];
+    for (std::size_t k = 0; k < LANES; ++k)
+        lanes[k] = data[0];
+
+    std::size_t i = 0;
+    for (; i + LANES <= n; i += LANES)
+        for (std::size_t k = 0; k < LANES; ++k)
+            lanes[k] = better(lanes[k], data[i + k]);
+    // a pointer loop, since GCC -O3 misreads an index loop here once it is
+    // inlined with a constant n
+    for (const TYPE *rest = data + i; rest != data + n; ++rest)
+        lanes[0] = better(lanes[0], *rest);
+
+    TYPE best = lanes[0];
+    for (std::size_t k = 1; k < LANES; ++k)
+        best = better(best, lanes[k]);
+    return best;
+} // extremeValue()
+
+
+// Description: First index of the most extreme element of a non-empty
+//              array, on the calling thread.
+// Runtime: O(n)
+template <typename TYPE, typename COMP_FUNCTOR>
+std::size_t serialArgExtreme(const TYPE *data, std::size_t n, const COMP_FUNCTOR &compare)
+{
+    if constexpr (IS_SIMD<TYPE, COMP_FUNCTOR>)
+    {
+        // a value that compares equal to itself is found again exactly
+        const TYPE best = extremeValue<TYPE, COMP_FUNCTOR>(data, n);
+        std::size_t i = 0;
+        while (i + 1 < n && !(data[i] == best))
+            ++i;
+        return i;
+    } // if
+    else
+    {
+        // chunk k tracks the best of indices k, k + CHUNKS, k + 2*CHUNKS, ...
+        std::size_t best[CHUNKS] = {};
+        const std::size_t chunks = std::min(CHUNKS, n);
+        for (std::size_t k = 0; k < chunks; ++k)
+            best[k] = k;
+
+        std::size_t i = chunks;
+        for (; i + CHUNKS <= n; i += CHUNKS)
+            for (std::size_t k = 0; k < CHUNKS; ++k)
+                if (compare(data[best[k]], data[i + k]))
+                    best[k] = i + k;
+        for (std::size_t k = 0; i < n; ++i, ++k)
+            if (compare(data[best[k]], data[i]))
+                best[k] = i;
+
+        // combine, breaking ties toward the smaller index
+        std::size_t top = best[0];
+        for (std::size_t k = 1; k < chunks; ++k)
+            if (compare(data[top], data[best[k]]) ||
+                (!compare(data[best[k]], data[top]) && best[k] < top))
+                top = best[k];
+        return top;
+    } // else
+} // serialArgExtreme()
+
+} // namespace argextreme
+
+
+// Description: First index of the most extreme (defined by 'compare')
+//              element of an array; 0 if the array is empty.
+// Runtime: O(n), split across threads above parallel::PARALLEL_THRESHOLD.
+template <typename TYPE, typename COMP_FUNCTOR>
+std::size_t argExtreme(const TYPE *data, std::size_t n, const COMP_FUNCTOR &compare)
+{
+    using namespace argextreme;
+    if (n == 0)
+        return 0;
+
+    const std::size_t threads = parallel::threadsFor(n);
+    if (threads < 2)
+        return serialArgExtreme(data, n, compare);
+
+    // each thread scans one slice
+    const std::size_t slice = (n + threads - 1) / threads;
+    std::vector<std::size_t> found(threads);
+    parallel::run(threads, [&](std::size_t t)
+    {
+        std::size_t first = t * slice;
+        std::size_t len = std::min(slice, n - first);
+        found[t] = first + serialArgExtreme(data + first, len, compare);
+    });
+
+    // slices are in index order, so a strict comparison keeps the first
+    std::size_t top = found[0];
+    for (std::size_t t = 1; t < threads; ++t)
+        if (compare(data[top], data[found[t]]))
+            top = found[t];
+    return top;
+} // argExtreme()
+
+#endif // ARGEXTREME_H
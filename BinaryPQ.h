@@ -18,17 +18,31 @@
 #define BINARYPQ_H
 
 #include <algorithm>
+#include <bit>
+#include <ranges>
 #include <utility>
+#include <vector>
 #include "Eecs281PQ.h"
+#include "Parallel.h"
+#include "SmallVector.h"
+#include "TieBreak.h"
 
 // A specialized version of the 'heap' ADT
 // (abstract data type) implemented as a binary heap.
-template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+// With STABLE = true, elements of equal priority come out in FIFO order.
+// With INLINE > 0, the first INLINE elements are stored inside the object,
+// so a heap that never grows past that never allocates.
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+          bool STABLE = false, std::size_t INLINE = 0>
 class BinaryPQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
 {
     // This is a way to refer to the base class object.
     using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
 
+    // Tie-break policy, and what the heap stores per element.
+    using Ties = TieBreak<TYPE, COMP_FUNCTOR, STABLE>;
+    using Slot = typename Ties::Slot;
+
 public:
 
     // Description: Construct an empty heap with an optional comparison functor.
@@ -43,8 +57,10 @@ public:
     template <typename InputIterator>
     BinaryPQ(InputIterator start, InputIterator end,
              COMP_FUNCTOR comp = COMP_FUNCTOR())
-        : BaseClass{comp}, data{start, end}
+        : BaseClass{comp}
     {
+        while (start != end)
+            data.push_back(ties.wrap(*start++));
         updatePriorities();
     } // BinaryPQ
 
@@ -57,12 +73,54 @@ public:
 
     // Description: Assumes that all elements inside the heap are out of order and
     //              'rebuilds' the heap by fixing the heap invariant, i.e., the heapify approach.
+    //              Large heaps are rebuilt on several threads.
     // Runtime: O(n)
     virtual void updatePriorities()
     {
-        // Heapify: proceed from bottom, repeatidly calling fixDown()
-        // no need calling it on leaves. ∆ Tree height = size() / 2
-        for (size_t i = (size() / NUM_CHILDREN); i >= ROOT; i--)
+        updatePriorities(parallel::threadsFor(size()));
+    } // updatePriorities()
+
+
+    // Description: updatePriorities() on 'threads' threads. The subtrees
+    //              below one level of the heap are heapified in parallel,
+    //              then the levels above them on this thread. Heapifying
+    //              disjoint subtrees commutes, so the heap comes out slot for
+    //              slot the same as the serial rebuild.
+    // Runtime: O(n / threads + threads log(n))
+    void updatePriorities(std::size_t threads)
+    {
+        // split at the first level with four subtrees per thread, so that
+        // uneven bottom levels even out
+        std::size_t roots = 1;
+        while (roots < 4 * threads)
+            roots *= NUM_CHILDREN;
+
+        const std::size_t lastParent = size() / NUM_CHILDREN;
+        if (threads < 2 || roots > lastParent)
+        {
+            // Heapify: proceed from bottom, repeatidly calling fixDown()
+            // no need calling it on leaves. ∆ Tree height = size() / 2
+            for (size_t i = lastParent; i >= ROOT; i--)
+                fixDown(i);
+            return;
+        } // if
+
+        // each thread takes a block of the roots [roots, 2 * roots); k levels
+        // below them, the block's descendants are the slots
+        // [first << k, last << k), fixed deepest level first
+        parallel::run(threads, [this, roots, threads, lastParent](std::size_t t)
+        {
+            const std::size_t first = roots + roots * t / threads;
+            const std::size_t last = roots + roots * (t + 1) / threads;
+            std::size_t depth = 0;
+            while ((first << (depth + 1)) <= lastParent)
+                ++depth;
+            for (std::size_t k = depth + 1; k-- > 0;)
+                for (std::size_t i = std::min((last << k) - 1, lastParent); i >= (first << k); i--)
+                    fixDown(i);
+        });
+
+        for (size_t i = roots - 1; i >= ROOT; i--)
             fixDown(i);
     } // updatePriorities()
 
@@ -73,11 +131,39 @@ public:
     {
         // Insert val at the back, then call fixUp() on 
         // val to bubble it up to its correct position.
-        data.push_back(val);
+        data.push_back(ties.wrap(val));
         fixUp(data.size());
     } // push()
 
 
+    // Description: Add every element of an iterator range. They are
+    //              appended as a block, then only the slots above the block
+    //              are fixed, deepest level first, as heapify would: the
+    //              block's parents, their parents, and so on up to the root.
+    //              Each level up holds half as many of them.
+    // Runtime: O(k + log(k) log(n)) for k new elements.
+    template <typename InputIterator>
+    void push_range(InputIterator start, InputIterator end)
+    {
+        std::size_t first = size() + 1;
+        while (start != end)
+            data.push_back(ties.wrap(*start++));
+        std::size_t last = size();
+        if (first > last)
+            return;
+
+        // the first level up also covers new slots that have children
+        while ((last /= NUM_CHILDREN) >= ROOT)
+        {
+            first = std::max(first / NUM_CHILDREN, ROOT);
+            for (std::size_t i = last; i >= first; i--)
+                fixDown(i);
+            if (first == ROOT)
+                break;
+        } // while
+    } // push_range()
+
+
     // Description: Remove the most extreme (defined by 'compare') element from
     //              the heap.
     // Note: Do not run tests on your code that would require it to pop an
@@ -94,13 +180,105 @@ public:
     } // pop()
 
 
+    // Description: Remove the k most extreme elements (all of them if there
+    //              are fewer) and return them, most extreme first. Large
+    //              batches are split across threads.
+    // Runtime: O(min(k log(n), n + k log(k))), on as many threads as a
+    //          rebuild of n elements would use.
+    std::vector<TYPE> pop_batch(std::size_t k)
+    {
+        return pop_batch(k, parallel::threadsFor(size()));
+    } // pop_batch()
+
+
+    // Description: pop_batch(k) on 'threads' threads. A batch of at least
+    //              1 / BATCH_FRACTION of the heap is not popped one by one:
+    //              1. nth_element() moves the k most extreme elements to the
+    //                 front.
+    //              2. They are sorted, one slice per thread, and the slices
+    //                 merged pairwise in parallel, then copied out.
+    //              3. The rest is rebuilt by the parallel heapify of
+    //                 updatePriorities(threads).
+    //              Every step is deterministic and the sort is stable, so the
+    //              batch and the heap left behind are the same for any
+    //              number of threads.
+    // Runtime: O(k log(n)) for a small batch, otherwise
+    //          O(n + (k log(k)) / threads + k log(threads) + n / threads).
+    std::vector<TYPE> pop_batch(std::size_t k, std::size_t threads)
+    {
+        k = std::min(k, size());
+        std::vector<TYPE> best;
+        best.reserve(k);
+        if (k == 0 || k < size() / BATCH_FRACTION)
+        {
+            while (best.size() < k)
+            {
+                best.push_back(top());
+                pop();
+            } // while
+            return best;
+        } // if
+
+        // 1. the batch goes to [0, k), in no order
+        auto higher = [this](const Slot &a, const Slot &b) { return isLower(b, a); };
+        auto at = [this](std::size_t i) { return data.begin() + static_cast<std::ptrdiff_t>(i); };
+        std::nth_element(data.begin(), at(k), data.end(), higher);
+
+        // 2. sort it, most extreme first, and copy it out
+        const std::size_t slices = std::max(std::size_t{1}, std::min(threads, k / BATCH_MIN_SLICE));
+        std::vector<std::size_t> bounds;
+        for (std::size_t t = 0; t <= slices; ++t)
+            bounds.push_back(k * t / slices);
+        parallel::run(slices, [&](std::size_t t)
+        {
+            std::stable_sort(at(bounds[t]), at(bounds[t + 1]), higher);
+        });
+        while (bounds.size() > 2)
+        {
+            const std::size_t pairs = (bounds.size() - 1) / 2;
+            parallel::run(pairs, [&](std::size_t i)
+            {
+                std::inplace_merge(at(bounds[2 * i]), at(bounds[2 * i + 1]), at(bounds[2 * i + 2]), higher);
+            });
+            std::vector<std::size_t> merged;
+            for (std::size_t i = 0; i < bounds.size(); i += 2)
+                merged.push_back(bounds[i]);
+            if (merged.back() != k)
+                merged.push_back(k);
+            bounds.swap(merged);
+        } // while
+        for (std::size_t i = 0; i < k; ++i)
+            best.push_back(Ties::elt(data[i]));
+
+        // 3. fill its slots from the back, and rebuild the rest
+        const std::size_t moved = std::min(k, size() - k);
+        for (std::size_t i = 0; i < moved; ++i)
+            data[i] = std::move(data[size() - moved + i]);
+        for (std::size_t i = 0; i < k; ++i)
+            data.pop_back();
+        updatePriorities(threads);
+        return best;
+    } // pop_batch()
+
+
+    // Description: Replace the most extreme element with val. This is the same
+    //              as pop() followed by push(val), but it costs a single
+    //              fixDown() from the root instead of a fixDown() and a fixUp().
+    // Runtime: O(log(n))
+    void replace_top(const TYPE &val)
+    {
+        getElement(ROOT) = ties.wrap(val);
+        fixDown(ROOT);
+    } // replace_top()
+
+
     // Description: Return the most extreme (defined by 'compare') element of
     //              the heap. This should be a reference for speed. It MUST be
     //              const because we cannot allow it to be modified, as that
     //              might make it no longer be the most extreme element.
     // Runtime: O(1)
     virtual const TYPE &top() const
-    { return getElement(ROOT); } 
+    { return Ties::elt(getElement(ROOT)); } 
     // top()
 
 
@@ -118,14 +296,69 @@ public:
     // empty()
 
 
+    // Description: A view of every element in heap order (level by level,
+    //              so only the first one is known to be top()). No copy is
+    //              made; it stays valid until the heap is next changed.
+    // Runtime: O(1), O(n) to traverse.
+    auto heap_order() const
+    {
+        return data | std::views::transform(
+            [](const Slot &slot) -> const TYPE & { return Ties::elt(slot); });
+    } // heap_order()
+
+
+    // Description: Return copies of the k most extreme elements (all of them
+    //              if there are fewer), most extreme first, without popping.
+    //              A small side heap holds the frontier of the walk down
+    //              from the root; only the children of an element that was
+    //              taken can be next, so the heap is never fully sorted.
+    // Runtime: O(k log(k))
+    std::vector<TYPE> top_n(std::size_t k) const
+    {
+        std::vector<TYPE> best;
+        if (empty() || k == 0)
+            return best;
+        best.reserve(std::min(k, size()));
+
+        auto lowerIndex = [this](std::size_t a, std::size_t b)
+        { return isLower(getElement(a), getElement(b)); };
+        std::vector<std::size_t> frontier{ ROOT };
+
+        while (!frontier.empty() && best.size() < k)
+        {
+            std::pop_heap(frontier.begin(), frontier.end(), lowerIndex);
+            std::size_t index = frontier.back();
+            frontier.pop_back();
+            best.push_back(Ties::elt(getElement(index)));
+
+            for (std::size_t child = index * NUM_CHILDREN;
+                 child < index * NUM_CHILDREN + NUM_CHILDREN && child <= size(); ++child)
+            {
+                frontier.push_back(child);
+                std::push_heap(frontier.begin(), frontier.end(), lowerIndex);
+            } // for
+        } // while
+
+        return best;
+    } // top_n()
+
+
 private:
 
     // Constants for the root and number of children.
     const size_t ROOT = 1;
     const size_t NUM_CHILDREN = 2;
 
+    // pop_batch() pops batches of less than 1 / BATCH_FRACTION of the heap
+    // one by one, and sorts at least BATCH_MIN_SLICE elements per thread
+    static constexpr std::size_t BATCH_FRACTION = 8;
+    static constexpr std::size_t BATCH_MIN_SLICE = 4096;
+
     // Under the hood data structure.
-    std::vector<TYPE> data;
+    InlineStorage<Slot, INLINE> data;
+
+    // Hands out sequence numbers in stable mode; empty otherwise.
+    [[no_unique_address]] Ties ties;
 
 
     /// NOTE: This is from lecture slides 08, pg. 19
@@ -139,7 +372,7 @@ private:
         size_t child = index,
                parent = (child / NUM_CHILDREN); // tree ∆ structure math
         while ((child != ROOT) &&               // root = 1
-               (this->compare(getElement(parent), getElement(child))))
+               (isLower(getElement(parent), getElement(child))))
         {
             std::swap(getElement(child), getElement(parent));
 
@@ -164,7 +397,7 @@ private:
 
             // If still in the heaps range i.e. there is a right child, then
             // compare with right child and switch if right is higher priority
-            if (j < heapSize && this->compare(getElement(j), getElement(j + 1)))
+            if (j < heapSize && isLower(getElement(j), getElement(j + 1)))
                 j++;
 
             // If the larger child (j) is less than or equal (≤) to the
@@ -182,7 +415,7 @@ private:
 
             // Then, if we reduce the logic eq again, we get: [a ∨ ¬b] ≡ ¬b.
             // If j is not greater than index, then we break.
-            if (!this->compare(getElement(index), getElement(j)))
+            if (!isLower(getElement(index), getElement(j)))
                 break;
 
             // O/W, swap the larger child and parent, then move down to
@@ -194,19 +427,27 @@ private:
 
 
     // Translates base-zero indexing to base-one.
-    TYPE &getElement(std::size_t i)
+    Slot &getElement(std::size_t i)
     {
         return data[i - 1];
     } // getElement()
 
 
     // Translates base-zero indexing to base-one.
-    const TYPE &getElement(std::size_t i) const
+    const Slot &getElement(std::size_t i) const
     {
         return data[i - 1];
     } // getElement()
 
 
+    // Is a lower priority than b? Plain this->compare unless STABLE,
+    // in which case ties go to the element pushed first.
+    bool isLower(const Slot &a, const Slot &b) const
+    {
+        return Ties::lower(this->compare, a, b);
+    } // isLower()
+
+
 }; // BinaryPQ
 
 #endif // BINARYPQ_H
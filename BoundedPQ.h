@@ -0,0 +1,650 @@
+//  BoundedPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    Priority queues with a fixed capacity that never allocate after
+    construction, for paths where allocation is not allowed.
+
+    - BoundedPQ: a binary heap in a preallocated array.
+    - BoundedPairingPQ: a pairing heap whose nodes come from a preallocated
+      pool and go back to a free list when popped. It keeps the node handles
+      and updateElt() of PairingPQ.
+
+    CAPACITY > 0 fixes the capacity at compile time, and the array or pool is
+    part of the object. CAPACITY = 0 takes the capacity as a constructor
+    argument and allocates the array or pool once, there.
+
+    try_push() reports whether the element went in. What happens when the
+    queue is full depends on KEEP_BEST:
+
+    - false: try_push() returns false and the queue is unchanged. Calling
+      push() on a full queue is a precondition violation, like pop() on an
+      empty one.
+    - true: the queue keeps the CAPACITY most extreme elements seen. A push
+      into a full queue evicts the least extreme element if the new one is
+      more extreme, and is dropped otherwise. The least extreme element of a
+      heap is one of its leaves, or of a full pool any node, so eviction is
+      an O(n) scan. Arithmetic keys under std::less / std::greater use the
+      SIMD kernel of ArgExtreme.h for that scan in BoundedPQ.
+
+    Elements are stored in a preallocated array, so TYPE must be default
+    constructible.
+
+*/
+
+#ifndef BOUNDEDPQ_H
+#define BOUNDEDPQ_H
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Eecs281PQ.h"
+#include "ArgExtreme.h"
+
+namespace bounded
+{
+
+// A fixed array for a compile-time capacity, a vector sized once otherwise.
+template <typename TYPE, std::size_t CAPACITY>
+using Storage = std::conditional_t<CAPACITY == 0, std::vector<TYPE>, std::array<TYPE, CAPACITY>>;
+
+// compare with its arguments swapped, so that the most extreme element
+// under it is the least extreme under compare
+template <typename TYPE, typename COMP_FUNCTOR>
+struct Reversed
+{
+    COMP_FUNCTOR compare;
+    bool operator()(const TYPE &a, const TYPE &b) const { return compare(b, a); }
+};
+
+// Reversed, except that std::less and std::greater swap into each other,
+// so that argExtreme() still sees a functor its SIMD kernel knows
+template <typename TYPE, typename COMP_FUNCTOR>
+using Lowest = std::conditional_t<
+    std::is_same_v<COMP_FUNCTOR, std::less<TYPE>>, std::greater<TYPE>,
+    std::conditional_t<std::is_same_v<COMP_FUNCTOR, std::greater<TYPE>>,
+                       std::less<TYPE>, Reversed<TYPE, COMP_FUNCTOR>>>;
+
+// The Lowest functor for comp.
+template <typename TYPE, typename COMP_FUNCTOR>
+Lowest<TYPE, COMP_FUNCTOR> lowest(const COMP_FUNCTOR &comp)
+{
+    if constexpr (std::is_same_v<Lowest<TYPE, COMP_FUNCTOR>, Reversed<TYPE, COMP_FUNCTOR>>)
+        return Reversed<TYPE, COMP_FUNCTOR>{ comp };
+    else
+        return Lowest<TYPE, COMP_FUNCTOR>{};
+} // lowest()
+
+} // namespace bounded
+
+
+// A specialized version of the 'heap' ADT implemented as a binary heap in a
+// fixed-size array.
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+          std::size_t CAPACITY = 0, bool KEEP_BEST = false>
+class BoundedPQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
+{
+    // This is a way to refer to the base class object.
+    using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
+
+public:
+
+    // Description: Construct an empty heap with a compile-time capacity and
+    //              an optional comparison functor.
+    // Runtime: O(1)
+    explicit BoundedPQ(COMP_FUNCTOR comp = COMP_FUNCTOR()) : BaseClass{comp}
+    {
+        static_assert(CAPACITY > 0, "pass the capacity to the constructor");
+    } // BoundedPQ
+
+
+    // Description: Construct an empty heap with room for 'capacity'
+    //              elements, allocated here and never again.
+    // Runtime: O(capacity)
+    explicit BoundedPQ(std::size_t capacity, COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : BaseClass{comp}
+    {
+        static_assert(CAPACITY == 0, "the capacity is a template argument");
+        data.resize(capacity);
+    } // BoundedPQ
+
+
+    // Description: Construct a heap out of an iterator range with a
+    //              compile-time capacity and an optional comparison functor.
+    //              Elements that do not fit are handled as by try_push().
+    // Runtime: O(n log(n)) where n is number of elements in range.
+    template <typename InputIterator,
+              typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    BoundedPQ(InputIterator start, InputIterator end, COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : BoundedPQ{ comp }
+    {
+        while (start != end)
+            try_push(*start++);
+    } // BoundedPQ
+
+
+    // Description: Destructor doesn't need any code, the array will be
+    //              destroyed automatically.
+    virtual ~BoundedPQ()
+    {} // ~BoundedPQ()
+
+
+    // Description: Add a new element to the heap if there is room or, with
+    //              KEEP_BEST, if it is more extreme than the least extreme
+    //              element, which it replaces.
+    // Runtime: O(log(n)), O(n) when evicting
+    // Returns: true if val is now in the heap
+    bool try_push(const TYPE &val)
+    {
+        if (count < capacity())
+        {
+            data[count] = val;
+            fixUp(count++);
+            return true;
+        } // if
+
+        if constexpr (KEEP_BEST)
+        {
+            // the least extreme element is a leaf, one of the last half
+            if (count == 0)
+                return false;
+            const std::size_t firstLeaf = count / 2;
+            const std::size_t worst = firstLeaf +
+                argExtreme(data.data() + firstLeaf, count - firstLeaf,
+                           bounded::lowest<TYPE>(this->compare));
+            if (!this->compare(data[worst], val))
+                return false;
+            data[worst] = val;
+            fixUp(worst);
+            return true;
+        } // if
+        else
+            return false;
+    } // try_push()
+
+
+    // Description: Add a new element to the heap. Without KEEP_BEST, the
+    //              heap must not be full.
+    // Runtime: O(log(n)), O(n) when evicting
+    virtual void push(const TYPE &val)
+    {
+        [[maybe_unused]] bool pushed = try_push(val);
+        assert((KEEP_BEST || pushed) && "push() into a full BoundedPQ");
+    } // push()
+
+
+    // Description: Remove the most extreme (defined by 'compare') element from
+    //              the heap.
+    // Runtime: O(log(n))
+    virtual void pop()
+    {
+        if (--count == 0)
+            return;
+        data[ROOT] = std::move(data[count]);
+        fixDown(ROOT);
+    } // pop()
+
+
+    // Description: Return the most extreme (defined by 'compare') element of
+    //              the heap.
+    // Runtime: O(1)
+    virtual const TYPE &top() const
+    {
+        return data[ROOT];
+    } // top()
+
+
+    // Description: Get the number of elements in the heap.
+    // Runtime: O(1)
+    virtual std::size_t size() const
+    {
+        return count;
+    } // size()
+
+
+    // Description: Return true if the heap is empty.
+    // Runtime: O(1)
+    virtual bool empty() const
+    {
+        return count == 0;
+    } // empty()
+
+
+    // Description: Assumes that all elements inside the heap are out of order and
+    //              'rebuilds' the heap by fixing the heap invariant.
+    // Runtime: O(n)
+    virtual void updatePriorities()
+    {
+        for (std::size_t i = count / 2; i-- > 0;)
+            fixDown(i);
+    } // updatePriorities()
+
+
+    // Description: Replace the most extreme element with val, in one sift
+    //              instead of a pop() and a push(). The heap must not be
+    //              empty.
+    // Runtime: O(log(n))
+    void replace_top(const TYPE &val)
+    {
+        data[ROOT] = val;
+        fixDown(ROOT);
+    } // replace_top()
+
+
+    // Description: Remove every element.
+    // Runtime: O(1)
+    void clear()
+    {
+        count = 0;
+    } // clear()
+
+
+    // Description: A view of the elements in heap order, top() first.
+    // Runtime: O(1)
+    std::span<const TYPE> heap_order() const
+    {
+        return std::span<const TYPE>(data.data(), count);
+    } // heap_order()
+
+
+    // Description: The most elements the heap can hold.
+    // Runtime: O(1)
+    std::size_t capacity() const
+    {
+        return data.size();
+    } // capacity()
+
+
+    // Description: Return true if the heap is full.
+    // Runtime: O(1)
+    bool full() const
+    {
+        return count == capacity();
+    } // full()
+
+
+private:
+
+    // Zero-based: the children of i are 2i + 1 and 2i + 2.
+    static constexpr std::size_t ROOT = 0;
+
+    // the heap is data[0, count)
+    bounded::Storage<TYPE, CAPACITY> data{};
+    std::size_t count = 0;
+
+
+    // Description: fixes the heap if the priority at index has increased,
+    //              moving parents down into the hole until it fits.
+    // Runtime: O(log(n))
+    void fixUp(std::size_t index)
+    {
+        TYPE moving = std::move(data[index]);
+        while (index != ROOT && this->compare(data[(index - 1) / 2], moving))
+        {
+            data[index] = std::move(data[(index - 1) / 2]);
+            index = (index - 1) / 2;
+        } // while
+        data[index] = std::move(moving);
+    } // fixUp()
+
+
+    // Description: fixes the heap if the priority at index has decreased,
+    //              moving the higher child up into the hole at each level.
+    // Runtime: O(log(n))
+    void fixDown(std::size_t index)
+    {
+        TYPE moving = std::move(data[index]);
+        while (2 * index + 1 < count)
+        {
+            std::size_t child = 2 * index + 1;
+            if (child + 1 < count && this->compare(data[child], data[child + 1]))
+                ++child;
+            if (!this->compare(moving, data[child]))
+                break;
+            data[index] = std::move(data[child]);
+            index = child;
+        } // while
+        data[index] = std::move(moving);
+    } // fixDown()
+
+
+}; // BoundedPQ
+
+
+
+// A specialized version of the 'priority queue' ADT implemented as a pairing
+// heap whose nodes come from a fixed-size pool.
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+          std::size_t CAPACITY = 0, bool KEEP_BEST = false>
+class BoundedPairingPQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
+{
+    // This is a way to refer to the base class object.
+    using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
+
+public:
+
+    // Each node within the pairing heap. A node in the pool is either in the
+    // heap or on the free list.
+    class Node
+    {
+    public:
+
+        // Description: Allows access to the element at that Node's position.
+        // Runtime: O(1).
+        const TYPE &getElt() const { return elt; }
+        const TYPE &operator*() const { return elt; }
+
+        friend BoundedPairingPQ;
+
+    private:
+
+        TYPE elt{};
+
+        // leftmost child, right sibling (or next free node), and left sibling
+        // or, for a leftmost child, parent
+        Node *child = nullptr;
+        Node *next = nullptr;
+        Node *prev = nullptr;
+        bool inHeap = false;
+    }; // class Node
+
+
+    // Description: Construct an empty pairing heap with a compile-time
+    //              capacity and an optional comparison functor.
+    // Runtime: O(CAPACITY)
+    explicit BoundedPairingPQ(COMP_FUNCTOR comp = COMP_FUNCTOR()) : BaseClass{comp}
+    {
+        static_assert(CAPACITY > 0, "pass the capacity to the constructor");
+        chainFreeList();
+    } // BoundedPairingPQ
+
+
+    // Description: Construct an empty pairing heap with room for 'capacity'
+    //              elements, allocated here and never again.
+    // Runtime: O(capacity)
+    explicit BoundedPairingPQ(std::size_t capacity, COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : BaseClass{comp}
+    {
+        static_assert(CAPACITY == 0, "the capacity is a template argument");
+        pool.resize(capacity);
+        chainFreeList();
+    } // BoundedPairingPQ
+
+
+    // Node handles point into the pool, so a copy could not keep them.
+    BoundedPairingPQ(const BoundedPairingPQ &) = delete;
+    BoundedPairingPQ &operator=(const BoundedPairingPQ &) = delete;
+
+
+    // Description: Destructor doesn't need any code, the pool will be
+    //              destroyed automatically.
+    virtual ~BoundedPairingPQ()
+    {} // ~BoundedPairingPQ()
+
+
+    // Description: Add a new element to the heap if there is room or, with
+    //              KEEP_BEST, if it is more extreme than the least extreme
+    //              element, whose node it takes over.
+    // Runtime: O(1), O(n) when evicting
+    // Returns: the new element's node, or nullptr if it was not added
+    Node *try_addNode(const TYPE &val)
+    {
+        if constexpr (KEEP_BEST)
+        {
+            if (!freeNodes && !pool.empty())
+            {
+                // the pool is full, so every node is in the heap
+                Node *worst = &pool[0];
+                for (Node &node : pool)
+                    if (this->compare(node.elt, worst->elt))
+                        worst = &node;
+                if (!this->compare(worst->elt, val))
+                    return nullptr;
+                erase(worst);
+            } // if
+        } // if
+
+        if (!freeNodes)
+            return nullptr;
+        Node *node = freeNodes;
+        freeNodes = node->next;
+        node->elt = val;
+        node->next = nullptr;
+        node->inHeap = true;
+        root = root ? link(root, node) : node;
+        ++numNodes;
+        return node;
+    } // try_addNode()
+
+
+    // Description: try_addNode() for callers that do not need the node.
+    // Runtime: O(1), O(n) when evicting
+    // Returns: true if val is now in the heap
+    bool try_push(const TYPE &val)
+    {
+        return try_addNode(val) != nullptr;
+    } // try_push()
+
+
+    // Description: Add a new element to the heap. Without KEEP_BEST, the
+    //              heap must not be full.
+    // Runtime: O(1), O(n) when evicting
+    virtual void push(const TYPE &val)
+    {
+        [[maybe_unused]] bool pushed = try_push(val);
+        assert((KEEP_BEST || pushed) && "push() into a full BoundedPairingPQ");
+    } // push()
+
+
+    // Description: Remove the most extreme (defined by 'compare') element from
+    //              the heap, returning its node to the pool.
+    // Runtime: Amortized O(log(n))
+    virtual void pop()
+    {
+        Node *old = root;
+        root = mergePairs(old->child);
+        release(old);
+    } // pop()
+
+
+    // Description: Return the most extreme (defined by 'compare') element of
+    //              the heap.
+    // Runtime: O(1)
+    virtual const TYPE &top() const
+    {
+        return root->elt;
+    } // top()
+
+
+    // Description: Get the number of elements in the heap.
+    // Runtime: O(1)
+    virtual std::size_t size() const
+    {
+        return numNodes;
+    } // size()
+
+
+    // Description: Return true if the heap is empty.
+    // Runtime: O(1)
+    virtual bool empty() const
+    {
+        return numNodes == 0;
+    } // empty()
+
+
+    // Description: Assumes that all elements inside the heap are out of order and
+    //              'rebuilds' the heap by melding every node on its own.
+    // Runtime: O(capacity)
+    virtual void updatePriorities()
+    {
+        root = nullptr;
+        for (Node &node : pool)
+        {
+            if (!node.inHeap)
+                continue;
+            node.child = node.next = node.prev = nullptr;
+            root = root ? link(root, &node) : &node;
+        } // for
+    } // updatePriorities()
+
+
+    // Description: Updates the priority of an element already in the heap
+    //              by replacing it with new_value.
+    // PRECONDITION: new_value must be at least as extreme as the old value.
+    // Runtime: O(1)
+    void updateElt(Node *node, const TYPE &new_value)
+    {
+        node->elt = new_value;
+        if (node == root)
+            return;
+        cut(node);
+        root = link(root, node);
+    } // updateElt()
+
+
+    // Description: Remove an element anywhere in the heap, returning its
+    //              node to the pool.
+    // Runtime: Amortized O(log(n))
+    void erase(Node *node)
+    {
+        if (node == root)
+        {
+            pop();
+            return;
+        } // if
+        cut(node);
+        if (Node *children = mergePairs(node->child))
+            root = link(root, children);
+        release(node);
+    } // erase()
+
+
+    // Description: The most elements the heap can hold.
+    // Runtime: O(1)
+    std::size_t capacity() const
+    {
+        return pool.size();
+    } // capacity()
+
+
+    // Description: Return true if the heap is full.
+    // Runtime: O(1)
+    bool full() const
+    {
+        return freeNodes == nullptr;
+    } // full()
+
+
+private:
+
+    bounded::Storage<Node, CAPACITY> pool{};
+    Node *root = nullptr;
+    Node *freeNodes = nullptr;
+    std::size_t numNodes = 0;
+
+
+    // Description: Put every node of the pool on the free list.
+    // Runtime: O(capacity)
+    void chainFreeList()
+    {
+        for (std::size_t i = pool.size(); i-- > 0;)
+        {
+            pool[i].next = freeNodes;
+            freeNodes = &pool[i];
+        } // for
+    } // chainFreeList()
+
+
+    // Description: Return a node that has left the heap to the free list.
+    // Runtime: O(1)
+    void release(Node *node)
+    {
+        node->child = node->prev = nullptr;
+        node->inHeap = false;
+        node->next = freeNodes;
+        freeNodes = node;
+        --numNodes;
+    } // release()
+
+
+    // Description: Links two root nodes with no siblings; the less extreme
+    //              one becomes the leftmost child of the other.
+    // Runtime: O(1)
+    Node *link(Node *a, Node *b)
+    {
+        if (this->compare(a->elt, b->elt))
+            std::swap(a, b);
+        b->prev = a;
+        b->next = a->child;
+        if (a->child)
+            a->child->prev = b;
+        a->child = b;
+        return a;
+    } // link()
+
+
+    // Description: Detach the subtree rooted at a non-root node.
+    // Runtime: O(1)
+    void cut(Node *node)
+    {
+        if (node->prev->child == node)
+            node->prev->child = node->next;
+        else
+            node->prev->next = node->next;
+        if (node->next)
+            node->next->prev = node->prev;
+        node->next = node->prev = nullptr;
+    } // cut()
+
+
+    // Description: The standard two-pass combine of a sibling list: link
+    //              pairs left to right, then link the results right to left.
+    //              The first pass chains its results through prev, so no
+    //              memory is needed.
+    // Runtime: Amortized O(log(n))
+    Node *mergePairs(Node *first)
+    {
+        if (!first)
+            return nullptr;
+
+        Node *last = nullptr;
+        while (first)
+        {
+            Node *a = first;
+            Node *b = a->next;
+            first = b ? b->next : nullptr;
+            a->next = a->prev = nullptr;
+            if (b)
+            {
+                b->next = b->prev = nullptr;
+                a = link(a, b);
+            } // if
+            a->prev = last;
+            last = a;
+        } // while
+
+        Node *result = last;
+        last = last->prev;
+        result->prev = nullptr;
+        while (last)
+        {
+            Node *before = last->prev;
+            last->prev = nullptr;
+            result = link(last, result);
+            last = before;
+        } // while
+        return result;
+    } // mergePairs()
+
+
+}; // BoundedPairingPQ
+
+#endif // BOUNDEDPQ_H
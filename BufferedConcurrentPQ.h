@@ -0,0 +1,215 @@
+//  BufferedConcurrentPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A shared PairingPQ behind one mutex, with a push buffer per producer
+    thread in front of it, for many threads pushing into one queue that a
+    few threads pop from.
+
+    A push goes into the pusher's own buffer, itself a small pairing heap
+    behind a SpinLock that no other producer touches. Once it holds
+    bufferSize elements, the whole buffer is melded into the shared heap in
+    O(1) under the mutex, so producers take the mutex once per bufferSize
+    pushes instead of once per push.
+
+    A consumer first melds every non-empty buffer into the shared heap,
+    still in O(1) each, and then pops under the same lock. Every element
+    whose push() returned before a try_pop() started is therefore a
+    candidate for it, so the queue is exact in the same sense as LockedPQ;
+    it only trades the consumers' work, one buffer check per producer, for
+    the producers'.
+
+    - Locks are only ever taken mutex before buffer, so a producer lets go
+      of its full buffer, takes the mutex, and then takes the buffer back
+      to meld it.
+    - Threads are numbered in the order they first push into a queue of
+      this type, and use buffer number % threads, so with no more
+      producers than buffers each one has a buffer to itself. More
+      producers share buffers, which stays correct but makes them wait
+      for each other.
+    - The buffers and the shared heap are PairingPQs, because their meld()
+      moves a whole heap without copying a node.
+
+*/
+
+#ifndef BUFFEREDCONCURRENTPQ_H
+#define BUFFEREDCONCURRENTPQ_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "PairingPQ.h"
+#include "SpinLock.h"
+
+// A priority queue (defined by 'compare') safe for concurrent push(),
+// try_pop() and try_top(), with per-thread push buffers.
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+class BufferedConcurrentPQ
+{
+public:
+
+    // Description: Construct an empty queue with one buffer of bufferSize
+    //              elements for each of 'threads' producers, and an
+    //              optional comparison functor.
+    // Runtime: O(threads)
+    explicit BufferedConcurrentPQ(std::size_t threads = std::thread::hardware_concurrency(),
+                                  std::size_t bufferSize = 64, COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : capacity{ std::max(std::size_t{ 1 }, bufferSize) }, heap{ comp }
+    {
+        const std::size_t n = std::max(std::size_t{ 1 }, threads);
+        for (std::size_t i = 0; i < n; ++i)
+            buffers.push_back(std::make_unique<Buffer>(comp));
+    } // BufferedConcurrentPQ
+
+
+    // The locks cannot be copied.
+    BufferedConcurrentPQ(const BufferedConcurrentPQ &) = delete;
+    BufferedConcurrentPQ &operator=(const BufferedConcurrentPQ &) = delete;
+
+
+    // Description: Add a new element to the calling thread's buffer, and
+    //              meld the buffer into the shared heap once it is full.
+    // Runtime: O(1), plus the wait for the mutex once per bufferSize pushes.
+    void push(const TYPE &val)
+    {
+        Buffer &buffer = *buffers[threadIndex() % buffers.size()];
+        {
+            std::lock_guard<SpinLock> guard{ buffer.lock };
+            buffer.heap.push(val);
+            buffer.pending.store(buffer.heap.size(), std::memory_order_relaxed);
+            if (buffer.heap.size() < capacity)
+                return;
+        }
+
+        // a consumer may drain the buffer between the two locks, which
+        // leaves less to meld
+        std::lock_guard<std::mutex> guard{ lock };
+        std::lock_guard<SpinLock> bufferGuard{ buffer.lock };
+        heap.meld(buffer.heap);
+        buffer.pending.store(0, std::memory_order_relaxed);
+    } // push()
+
+
+    // Description: Remove the most extreme element and copy it into out.
+    // Runtime: O(threads) to empty the buffers, plus that of PairingPQ::pop(),
+    //          plus the wait for the mutex.
+    // Returns: false, leaving out alone, if the queue is empty
+    bool try_pop(TYPE &out)
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        drainBuffers();
+        if (heap.empty())
+            return false;
+        out = heap.top();
+        heap.pop();
+        return true;
+    } // try_pop()
+
+
+    // Description: Copy the most extreme element into out, without removing
+    //              it.
+    // Runtime: O(threads), plus the wait for the mutex.
+    // Returns: false, leaving out alone, if the queue is empty
+    bool try_top(TYPE &out)
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        drainBuffers();
+        if (heap.empty())
+            return false;
+        out = heap.top();
+        return true;
+    } // try_top()
+
+
+    // Description: Meld every buffer into the shared heap now.
+    // Runtime: O(threads), plus the wait for the mutex.
+    void flush()
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        drainBuffers();
+    } // flush()
+
+
+    // Description: Get the number of elements in the queue, buffered or not.
+    //              Other threads may change it before the caller looks at it.
+    // Runtime: O(threads), plus the wait for the mutex.
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        std::size_t n = heap.size();
+        for (const std::unique_ptr<Buffer> &buffer : buffers)
+            n += buffer->pending.load();
+        return n;
+    } // size()
+
+
+    // Description: Return true if the queue is empty, as of the call.
+    // Runtime: O(threads), plus the wait for the mutex.
+    bool empty() const
+    {
+        return size() == 0;
+    } // empty()
+
+
+private:
+
+    using Heap = PairingPQ<TYPE, COMP_FUNCTOR>;
+
+    // A producer's buffer, on a cache line of its own so that producers do
+    // not slow each other down. pending mirrors heap.size(), so that
+    // consumers can skip empty buffers without taking their locks; it is
+    // only written under the lock, whose release publishes it.
+    struct alignas(64) Buffer
+    {
+        SpinLock lock;
+        std::atomic<std::size_t> pending{ 0 };
+        Heap heap;
+
+        explicit Buffer(const COMP_FUNCTOR &comp) : heap{ comp } {}
+    }; // Buffer
+
+    std::size_t capacity;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+
+    // guards the shared heap
+    mutable std::mutex lock;
+    Heap heap;
+
+
+    // Description: A number for the calling thread, counting up from 0 in
+    //              the order threads first ask.
+    // Runtime: O(1)
+    static std::size_t threadIndex()
+    {
+        static std::atomic<std::size_t> next{ 0 };
+        thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    } // threadIndex()
+
+
+    // Description: Meld every non-empty buffer into the shared heap. The
+    //              caller holds the mutex.
+    // Runtime: O(threads)
+    void drainBuffers()
+    {
+        for (std::unique_ptr<Buffer> &buffer : buffers)
+        {
+            if (buffer->pending.load() == 0)
+                continue;
+            std::lock_guard<SpinLock> guard{ buffer->lock };
+            heap.meld(buffer->heap);
+            buffer->pending.store(0, std::memory_order_relaxed);
+        } // for
+    } // drainBuffers()
+
+
+}; // BufferedConcurrentPQ
+
+#endif // BUFFEREDCONCURRENTPQ_H
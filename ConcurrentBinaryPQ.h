@@ -0,0 +1,317 @@
+//  ConcurrentBinaryPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A binary heap that several threads can push into and pop from at the
+    same time, after Hunt, Michael, Parthasarathy and Scott, "An efficient
+    algorithm for concurrent priority queue heaps" (1996).
+
+    Every node has its own SpinLock. A global mutex guards only the size,
+    and is held just long enough to claim the slot at the bottom of the
+    heap. After that, a push sifts its element up and a pop sifts the root
+    down, each holding at most three node locks at a time, so operations on
+    different paths of the heap run in parallel.
+
+    - Locks are always taken parent before child, and the global lock
+      before any node lock, so there is no deadlock.
+    - Bottom-up pushes and top-down pops can meet on the same path. Each
+      node therefore carries a tag: EMPTY, AVAILABLE, or the id of the
+      thread whose push is still sifting that element up. A push follows
+      its element by tag, because a pop's sift down may have moved it up
+      a level, and stops once a pop has taken it.
+    - The n-th slot is not n but n with the bits below its top bit reversed.
+      Consecutive pushes then climb disjoint paths instead of all meeting
+      the pushes just before them.
+
+    The heap grows one level at a time, and levels are never moved or freed
+    before the destructor, so a node reference stays valid while other
+    threads grow the heap.
+
+    top() followed by pop() is not atomic with other threads around, so the
+    interface is push() and try_pop(), like LockedPQ. Elements live in
+    preallocated levels, so TYPE must be default constructible.
+
+*/
+
+#ifndef CONCURRENTBINARYPQ_H
+#define CONCURRENTBINARYPQ_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "SpinLock.h"
+
+// A binary max heap (defined by 'compare') safe for concurrent push() and
+// try_pop().
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+class ConcurrentBinaryPQ
+{
+public:
+
+    // Description: Construct an empty heap with an optional comparison functor.
+    // Runtime: O(1)
+    explicit ConcurrentBinaryPQ(COMP_FUNCTOR comp = COMP_FUNCTOR()) : compare{ comp }
+    {} // ConcurrentBinaryPQ
+
+
+    // Description: Construct a heap out of an iterator range with an optional
+    //              comparison functor.
+    // Runtime: O(n log(n)) where n is number of elements in range.
+    template <typename InputIterator>
+    ConcurrentBinaryPQ(InputIterator start, InputIterator end,
+                       COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : ConcurrentBinaryPQ{ comp }
+    {
+        while (start != end)
+            push(*start++);
+    } // ConcurrentBinaryPQ
+
+
+    // The locks cannot be copied.
+    ConcurrentBinaryPQ(const ConcurrentBinaryPQ &) = delete;
+    ConcurrentBinaryPQ &operator=(const ConcurrentBinaryPQ &) = delete;
+
+
+    // Description: Free every level. No other thread may be using the heap.
+    // Runtime: O(n)
+    ~ConcurrentBinaryPQ()
+    {
+        for (std::atomic<Node *> &level : levels)
+            delete[] level.load(std::memory_order_relaxed);
+    } // ~ConcurrentBinaryPQ()
+
+
+    // Description: Add a new element to the heap.
+    // Runtime: O(log(n)), plus waits for the locks on its path.
+    void push(const TYPE &val)
+    {
+        const std::uint32_t self = threadTag();
+
+        std::unique_lock<std::mutex> heapGuard{ heapLock };
+        std::size_t i = slot(++count);
+        growTo(i);
+        Node &bottom = node(i);
+        std::unique_lock<SpinLock> bottomGuard{ bottom.lock };
+        heapGuard.unlock();
+        bottom.item = val;
+        bottom.tag = self;
+        bottomGuard.unlock();
+
+        while (i > 1)
+        {
+            Node &parent = node(i / 2);
+            Node &child = node(i);
+            std::unique_lock<SpinLock> parentGuard{ parent.lock };
+            std::unique_lock<SpinLock> childGuard{ child.lock };
+            if (parent.tag == AVAILABLE && child.tag == self)
+            {
+                if (compare(parent.item, child.item))
+                {
+                    swapNodes(parent, child);
+                    i /= 2;
+                } // if
+                else
+                {
+                    child.tag = AVAILABLE;
+                    return;
+                } // else
+            } // if
+            else if (parent.tag == EMPTY)
+                return;
+            else if (child.tag != self)
+                i /= 2;
+            else
+            {
+                // the parent is still being pushed by another thread,
+                // which needs these locks to finish
+                childGuard.unlock();
+                parentGuard.unlock();
+                std::this_thread::yield();
+            } // else
+        } // while
+
+        Node &root = node(1);
+        std::lock_guard<SpinLock> rootGuard{ root.lock };
+        if (root.tag == self)
+            root.tag = AVAILABLE;
+    } // push()
+
+
+    // Description: Remove the most extreme element and copy it into out.
+    // Runtime: O(log(n)), plus waits for the locks on its path.
+    // Returns: false, leaving out alone, if the heap is empty
+    bool try_pop(TYPE &out)
+    {
+        std::unique_lock<std::mutex> heapGuard{ heapLock };
+        if (count == 0)
+            return false;
+        Node &bottom = node(slot(count--));
+        std::unique_lock<SpinLock> bottomGuard{ bottom.lock };
+        heapGuard.unlock();
+        TYPE last = std::move(bottom.item);
+        bottom.tag = EMPTY;
+        bottomGuard.unlock();
+
+        // the bottom element goes to the root, unless it was the root
+        Node &root = node(1);
+        std::unique_lock<SpinLock> guard{ root.lock };
+        if (root.tag == EMPTY)
+        {
+            out = std::move(last);
+            return true;
+        } // if
+        out = std::move(root.item);
+        root.item = std::move(last);
+        root.tag = AVAILABLE;
+
+        // sift down, holding the lock of node i
+        std::size_t i = 1;
+        while (depth(i) + 1 < MAX_LEVELS && level(2 * i))
+        {
+            Node &parent = node(i);
+            Node &left = node(2 * i);
+            Node &right = node(2 * i + 1);
+            std::unique_lock<SpinLock> leftGuard{ left.lock };
+            std::unique_lock<SpinLock> rightGuard{ right.lock };
+            if (left.tag == EMPTY)
+                break;
+
+            // the right slot only fills after the left one
+            bool goRight = right.tag != EMPTY && compare(left.item, right.item);
+            Node &child = goRight ? right : left;
+            (goRight ? leftGuard : rightGuard).unlock();
+            if (!compare(parent.item, child.item))
+                break;
+            swapNodes(parent, child);
+            guard = std::move(goRight ? rightGuard : leftGuard);
+            i = goRight ? 2 * i + 1 : 2 * i;
+        } // while
+        return true;
+    } // try_pop()
+
+
+    // Description: Get the number of elements in the heap, as of the call.
+    //              A push counts once it has claimed its slot, a pop once it
+    //              has freed one.
+    // Runtime: O(1), plus the wait for the size lock.
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> guard{ heapLock };
+        return count;
+    } // size()
+
+
+    // Description: Return true if the heap is empty, as of the call.
+    // Runtime: O(1), plus the wait for the size lock.
+    bool empty() const
+    {
+        return size() == 0;
+    } // empty()
+
+
+private:
+
+    // Node tags other than the id of a pushing thread.
+    static constexpr std::uint32_t EMPTY = 0;
+    static constexpr std::uint32_t AVAILABLE = 1;
+
+    // Levels the heap can grow to; level k holds 2^k nodes.
+    static constexpr std::size_t MAX_LEVELS = 48;
+
+    struct Node
+    {
+        SpinLock lock;
+        std::uint32_t tag = EMPTY;
+        TYPE item{};
+    }; // Node
+
+    COMP_FUNCTOR compare;
+
+    // guards count and the growth of levels
+    mutable std::mutex heapLock;
+    std::size_t count = 0;
+
+    // level k, once allocated; slot i (1-based) is in level depth(i)
+    std::array<std::atomic<Node *>, MAX_LEVELS> levels{};
+
+
+    // Description: A tag no other live thread uses for this kind of heap.
+    // Runtime: O(1)
+    static std::uint32_t threadTag()
+    {
+        static std::atomic<std::uint32_t> next{ AVAILABLE + 1 };
+        thread_local const std::uint32_t tag = next.fetch_add(1, std::memory_order_relaxed);
+        return tag;
+    } // threadTag()
+
+
+    // Description: The slot of the n-th element (1-based): n with the bits
+    //              below its top bit reversed.
+    // Runtime: O(log(n))
+    static std::size_t slot(std::size_t n)
+    {
+        std::size_t reversed = 1;
+        for (std::size_t b = 0; b < depth(n); ++b)
+            reversed = (reversed << 1) | ((n >> b) & 1);
+        return reversed;
+    } // slot()
+
+
+    // Description: The level of slot i, counting the root's as 0.
+    // Runtime: O(1)
+    static std::size_t depth(std::size_t i)
+    {
+        // slots start at 1, so the | 1 never changes the result; it only
+        // shows the compiler that the argument is never 0
+        return static_cast<std::size_t>(std::bit_width(i | 1)) - 1;
+    } // depth()
+
+
+    // Description: The level holding slot i, or nullptr if it is not
+    //              allocated yet.
+    // Runtime: O(1)
+    Node *level(std::size_t i) const
+    {
+        return levels[depth(i)].load(std::memory_order_acquire);
+    } // level()
+
+
+    // Description: The node in slot i, whose level must be allocated.
+    // Runtime: O(1)
+    Node &node(std::size_t i) const
+    {
+        return level(i)[i - std::bit_floor(i)];
+    } // node()
+
+
+    // Description: Allocate the level of slot i if needed. The caller holds
+    //              heapLock.
+    // Runtime: O(i) when it allocates, O(1) otherwise.
+    void growTo(std::size_t i)
+    {
+        const std::size_t k = depth(i);
+        if (!levels[k].load(std::memory_order_relaxed))
+            levels[k].store(new Node[std::size_t{ 1 } << k], std::memory_order_release);
+    } // growTo()
+
+
+    // Description: Exchange the elements and tags of two locked nodes.
+    // Runtime: O(1)
+    static void swapNodes(Node &a, Node &b)
+    {
+        std::swap(a.item, b.item);
+        std::swap(a.tag, b.tag);
+    } // swapNodes()
+
+
+}; // ConcurrentBinaryPQ
+
+#endif // CONCURRENTBINARYPQ_H
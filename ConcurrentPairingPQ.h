@@ -0,0 +1,353 @@
+//  ConcurrentPairingPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A PairingPQ owned by one thread, whose elements other threads may
+    reprice or erase, such as resting orders that risk threads reprice
+    while the matching thread pops.
+
+    push() returns a Handle to the element. update() and erase() on a
+    Handle may come from any thread, and are not applied right away: each
+    posts a command to the element's own mailbox, a lock-free stack. The
+    first command to reach an empty mailbox also puts the element on the
+    queue's list of elements with mail, another lock-free stack. Before
+    its next top(), pop() or size(), the owner takes that whole list and
+    applies each mailbox in the order it was posted to:
+
+    - an update to a more extreme value is PairingPQ::updateElt(),
+      anything else erases the node and adds a new one,
+    - an erase is PairingPQ::erase(),
+    - commands for an element that was popped or erased already are
+      dropped.
+
+    Handles are reference counted, so a Handle stays safe to post to after
+    the owner pops its element; live() then turns false. The owner keeps
+    its own reference while an element is in the heap, and the list of
+    elements with mail keeps one while they are on it. Foreign threads
+    never touch the heap itself, which stays single-threaded.
+
+    Commands on the same Handle apply in the order they were posted, but
+    commands on different Handles may apply in any order. Erase commands
+    need a placeholder value, so TYPE must be default constructible.
+
+*/
+
+#ifndef CONCURRENTPAIRINGPQ_H
+#define CONCURRENTPAIRINGPQ_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include "PairingPQ.h"
+
+// A pairing heap (defined by 'compare') owned by one thread, with
+// update() and erase() from any thread.
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+class ConcurrentPairingPQ
+{
+public:
+
+    class Element;
+
+    // An element in the queue, to update() or erase() it.
+    using Handle = std::shared_ptr<Element>;
+
+private:
+
+    // What the heap stores: the value, and a reference to its handle.
+    struct Entry
+    {
+        TYPE value;
+        Handle element;
+    }; // Entry
+
+    struct EntryComp
+    {
+        COMP_FUNCTOR compare;
+
+        bool operator()(const Entry &a, const Entry &b) const
+        {
+            return compare(a.value, b.value);
+        } // operator()()
+    }; // EntryComp
+
+    using Heap = PairingPQ<Entry, EntryComp>;
+
+    // A posted command: an erase, or an update to value.
+    struct Mail
+    {
+        bool erase;
+        TYPE value;
+        Mail *next;
+    }; // Mail
+
+public:
+
+    // The shared state behind a Handle.
+    class Element
+    {
+    public:
+
+        // Description: Return false once the owner has popped or erased
+        //              the element. Commands still in its mailbox do not
+        //              count until the owner applies them.
+        // Runtime: O(1)
+        bool live() const
+        {
+            return alive.load(std::memory_order_acquire);
+        } // live()
+
+        ~Element()
+        {
+            for (Mail *mail = mailbox.load(); mail;)
+            {
+                Mail *next = mail->next;
+                delete mail;
+                mail = next;
+            } // for
+        } // ~Element()
+
+    private:
+
+        friend ConcurrentPairingPQ;
+
+        // commands, newest first
+        std::atomic<Mail *> mailbox{ nullptr };
+        std::atomic<bool> alive{ true };
+
+        // the next element on the list of elements with mail, and this
+        // element's own reference while it is on it; written by the poster
+        // that lists it, and read by the owner after taking the list
+        Element *nextListed = nullptr;
+        Handle listed;
+
+        // the element's node, owner only; nullptr once it is gone
+        typename Heap::Node *node = nullptr;
+    }; // Element
+
+
+    // Description: Construct an empty queue with an optional comparison
+    //              functor.
+    // Runtime: O(1)
+    explicit ConcurrentPairingPQ(COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : compare{ comp }, heap{ EntryComp{ comp } }
+    {} // ConcurrentPairingPQ
+
+
+    // The mailboxes point back at the queue's list.
+    ConcurrentPairingPQ(const ConcurrentPairingPQ &) = delete;
+    ConcurrentPairingPQ &operator=(const ConcurrentPairingPQ &) = delete;
+
+
+    // Description: Apply any remaining commands, which frees them, and
+    //              destroy the heap.
+    // Runtime: O(n) plus that of the remaining commands.
+    ~ConcurrentPairingPQ()
+    {
+        applyMail();
+    } // ~ConcurrentPairingPQ()
+
+
+    // Description: Add a new element. Owner only.
+    // Runtime: O(1)
+    // Returns: a handle to update() or erase() it through
+    Handle push(const TYPE &val)
+    {
+        Handle element = std::make_shared<Element>();
+        element->node = heap.addNode(Entry{ val, element });
+        return element;
+    } // push()
+
+
+    // Description: Post a command to give the element val as its new
+    //              value. Any thread may call this.
+    // Runtime: O(1), plus retries while other threads post to the same
+    //          element.
+    void update(const Handle &element, const TYPE &val)
+    {
+        post(element, new Mail{ false, val, nullptr });
+    } // update()
+
+
+    // Description: Post a command to remove the element. Any thread may
+    //              call this.
+    // Runtime: O(1), plus retries while other threads post to the same
+    //          element.
+    void erase(const Handle &element)
+    {
+        post(element, new Mail{ true, TYPE{}, nullptr });
+    } // erase()
+
+
+    // Description: Apply the posted commands, then return the most extreme
+    //              element. Owner only.
+    // Runtime: O(1) plus that of the posted commands.
+    const TYPE &top()
+    {
+        applyMail();
+        return heap.top().value;
+    } // top()
+
+
+    // Description: Apply the posted commands, then remove the most extreme
+    //              element. Owner only.
+    // Runtime: Amortized O(log(n)) plus that of the posted commands.
+    void pop()
+    {
+        applyMail();
+        retire(*heap.top().element);
+        heap.pop();
+    } // pop()
+
+
+    // Description: Apply the posted commands, then remove the most extreme
+    //              element and copy it into out. Owner only.
+    // Runtime: Amortized O(log(n)) plus that of the posted commands.
+    // Returns: false, leaving out alone, if the queue is empty
+    bool try_pop(TYPE &out)
+    {
+        applyMail();
+        if (heap.empty())
+            return false;
+        out = heap.top().value;
+        retire(*heap.top().element);
+        heap.pop();
+        return true;
+    } // try_pop()
+
+
+    // Description: Apply the posted commands, then get the number of
+    //              elements. Owner only.
+    // Runtime: O(1) plus that of the posted commands.
+    std::size_t size()
+    {
+        applyMail();
+        return heap.size();
+    } // size()
+
+
+    // Description: Apply the posted commands, then return true if the queue
+    //              is empty. Owner only.
+    // Runtime: O(1) plus that of the posted commands.
+    bool empty()
+    {
+        return size() == 0;
+    } // empty()
+
+
+    // Description: Apply every command posted so far. top(), pop(),
+    //              try_pop() and size() call this first. Owner only.
+    // Runtime: O(1) per command, plus that of the heap operation it takes.
+    void applyMail()
+    {
+        Element *list = listed.exchange(nullptr, std::memory_order_acquire);
+        while (list)
+        {
+            Element &element = *list;
+            list = element.nextListed;
+
+            // let go of the list's reference before the mailbox, so that a
+            // post after the exchange can list the element again
+            Handle keep = std::move(element.listed);
+            Mail *mail = element.mailbox.exchange(nullptr, std::memory_order_acq_rel);
+
+            // the mailbox is newest first
+            Mail *oldest = nullptr;
+            while (mail)
+            {
+                Mail *next = mail->next;
+                mail->next = oldest;
+                oldest = mail;
+                mail = next;
+            } // while
+            while (oldest)
+            {
+                Mail *next = oldest->next;
+                apply(keep, *oldest);
+                delete oldest;
+                oldest = next;
+            } // while
+        } // while
+    } // applyMail()
+
+
+private:
+
+    COMP_FUNCTOR compare;
+    Heap heap;
+
+    // elements with mail, newest first
+    std::atomic<Element *> listed{ nullptr };
+
+
+    // Description: Push mail onto the element's mailbox, and list the
+    //              element if its mailbox was empty.
+    // Runtime: O(1), plus retries while other threads post.
+    void post(const Handle &element, Mail *mail)
+    {
+        if (!element->live())
+        {
+            delete mail;
+            return;
+        } // if
+
+        Mail *head = element->mailbox.load(std::memory_order_relaxed);
+        do
+            mail->next = head;
+        while (!element->mailbox.compare_exchange_weak(head, mail, std::memory_order_acq_rel,
+                                                       std::memory_order_relaxed));
+
+        // a non-empty mailbox is listed already, or about to be emptied by
+        // the owner, who then sees this mail too
+        if (head)
+            return;
+
+        element->listed = element;
+        Element *first = listed.load(std::memory_order_relaxed);
+        do
+            element->nextListed = first;
+        while (!listed.compare_exchange_weak(first, element.get(), std::memory_order_release,
+                                             std::memory_order_relaxed));
+    } // post()
+
+
+    // Description: Apply one command to element.
+    // Runtime: That of the heap operation it takes.
+    void apply(const Handle &element, const Mail &mail)
+    {
+        typename Heap::Node *node = element->node;
+        if (!node)
+            return;
+
+        if (mail.erase)
+        {
+            retire(*element);
+            heap.erase(node);
+        } // if
+        else if (compare(node->getElt().value, mail.value))
+            heap.updateElt(node, Entry{ mail.value, element });
+        else
+        {
+            // updateElt() only moves elements up
+            heap.erase(node);
+            element->node = heap.addNode(Entry{ mail.value, element });
+        } // else
+    } // apply()
+
+
+    // Description: Mark element as gone, before its node is destroyed.
+    // Runtime: O(1)
+    static void retire(Element &element)
+    {
+        element.node = nullptr;
+        element.alive.store(false, std::memory_order_release);
+    } // retire()
+
+
+}; // ConcurrentPairingPQ
+
+#endif // CONCURRENTPAIRINGPQ_H
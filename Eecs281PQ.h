@@ -59,6 +59,31 @@ public:
     //              You must reorder the data so that the PQ invariant is restored.
     //              Each derived PQ will have to implement this appropriately.
     virtual void updatePriorities() = 0;
+
+    // Description: Add every element of an iterator range. This pushes them
+    //              one by one; a derived PQ that can take a batch in fewer
+    //              steps hides it with its own.
+    template<typename InputIterator>
+    void push_range(InputIterator start, InputIterator end)
+    {
+        while (start != end)
+            push(*start++);
+    } // push_range()
+
+    // Description: Remove the k most extreme elements (all of them if there
+    //              are fewer) and return them, most extreme first. This pops
+    //              them one by one; a derived PQ that can take a batch in
+    //              fewer steps hides it with its own.
+    std::vector<TYPE> pop_batch(std::size_t k)
+    {
+        std::vector<TYPE> best;
+        while (best.size() < k && !empty())
+        {
+            best.push_back(top());
+            pop();
+        } // while
+        return best;
+    } // pop_batch()
     
 protected:
     
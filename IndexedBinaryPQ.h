@@ -0,0 +1,297 @@
+//  IndexedBinaryPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A d-ary heap whose elements are tagged with an external ID (a small,
+    dense integer such as an order number), plus a position map from ID to
+    heap slot that fixUp() and fixDown() keep current.
+
+    With the map, repricing or cancelling one element is a single O(log n)
+    sift from its slot, instead of BinaryPQ's O(n) updatePriorities().
+
+    The heap array stores each element next to its ID, so the sifts only read
+    the hot array and write the map. ARITY = 2 is a binary heap; a wider node
+    (4 or 8) makes the tree shallower and keeps each node's children on one
+    or two cache lines.
+
+*/
+
+#ifndef INDEXEDBINARYPQ_H
+#define INDEXEDBINARYPQ_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "Eecs281PQ.h"
+
+// A specialized version of the 'heap' ADT implemented as a d-ary heap with
+// a position map, addressed by element ID.
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+          std::size_t ARITY = 2>
+class IndexedBinaryPQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
+{
+    // This is a way to refer to the base class object.
+    using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
+
+    static_assert(ARITY >= 2, "a heap node needs at least two children");
+
+public:
+
+    // Description: Construct an empty heap with an optional comparison functor.
+    // Runtime: O(1)
+    explicit IndexedBinaryPQ(COMP_FUNCTOR comp = COMP_FUNCTOR()) : BaseClass{comp}
+    {} // IndexedBinaryPQ
+
+
+    // Description: Construct a heap out of an iterator range with an optional
+    //              comparison functor. The i-th element of the range gets ID i.
+    // Runtime: O(n) where n is number of elements in range.
+    template <typename InputIterator>
+    IndexedBinaryPQ(InputIterator start, InputIterator end,
+                    COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : BaseClass{comp}
+    {
+        while (start != end)
+        {
+            pos.push_back(data.size());
+            data.push_back(Entry{*start++, data.size()});
+        } // while
+        updatePriorities();
+    } // IndexedBinaryPQ
+
+
+    // Description: Destructor doesn't need any code, the vectors will
+    //              be destroyed automatically.
+    virtual ~IndexedBinaryPQ()
+    {} // ~IndexedBinaryPQ()
+
+
+    // Description: Assumes that all elements inside the heap are out of order and
+    //              'rebuilds' the heap by fixing the heap invariant, i.e., the heapify approach.
+    // Runtime: O(n)
+    virtual void updatePriorities()
+    {
+        // heapify from the last parent up, then fixDown() keeps pos
+        // current for every element it moves
+        if (data.size() <= 1)
+            return;
+        for (std::size_t i = parent(data.size() - 1) + 1; i-- > 0;)
+            fixDown(i);
+    } // updatePriorities()
+
+
+    // Description: Add a new element to the heap under a fresh ID, one past
+    //              the largest ID used so far.
+    // Runtime: O(log(n))
+    virtual void push(const TYPE &val)
+    {
+        push(pos.size(), val);
+    } // push()
+
+
+    // Description: Add a new element to the heap under the given ID. If the
+    //              ID is already in the heap, this is update(id, val).
+    // Runtime: O(log(n)), plus O(id) the first time a larger ID is seen.
+    void push(std::size_t id, const TYPE &val)
+    {
+        if (contains(id))
+        {
+            update(id, val);
+            return;
+        } // if
+
+        if (id >= pos.size())
+            pos.resize(id + 1, NOT_IN_HEAP);
+        data.push_back(Entry{val, id});
+        fixUp(data.size() - 1);
+    } // push()
+
+
+    // Description: Remove the most extreme (defined by 'compare') element from
+    //              the heap.
+    // Runtime: O(log(n))
+    virtual void pop()
+    {
+        removeAt(ROOT);
+    } // pop()
+
+
+    // Description: Return the most extreme (defined by 'compare') element of
+    //              the heap.
+    // Runtime: O(1)
+    virtual const TYPE &top() const
+    { return data[ROOT].elt; }
+    // top()
+
+
+    // Description: Return the ID of the most extreme element.
+    // Runtime: O(1)
+    std::size_t topId() const
+    { return data[ROOT].id; }
+    // topId()
+
+
+    // Description: Get the number of elements in the heap.
+    // Runtime: O(1)
+    virtual std::size_t size() const
+    { return data.size(); }
+    // size()
+
+
+    // Description: Return true if the heap is empty.
+    // Runtime: O(1)
+    virtual bool empty() const
+    { return data.empty(); }
+    // empty()
+
+
+    // Description: Return true if an element with this ID is in the heap.
+    // Runtime: O(1)
+    bool contains(std::size_t id) const
+    { return id < pos.size() && pos[id] != NOT_IN_HEAP; }
+    // contains()
+
+
+    // Description: Return the element with this ID, which must be in the heap.
+    // Runtime: O(1)
+    const TYPE &get(std::size_t id) const
+    { return data[pos[id]].elt; }
+    // get()
+
+
+    // Description: Give the element with this ID, which must be in the heap,
+    //              a new value. Either direction of change is fine.
+    // Runtime: O(log(n))
+    void update(std::size_t id, const TYPE &newVal)
+    {
+        std::size_t index = pos[id];
+        bool raised = this->compare(data[index].elt, newVal);
+        data[index].elt = newVal;
+        if (raised)
+            fixUp(index);
+        else
+            fixDown(index);
+    } // update()
+
+
+    // Description: Remove the element with this ID. Returns false if the ID
+    //              was not in the heap.
+    // Runtime: O(log(n))
+    bool erase(std::size_t id)
+    {
+        if (!contains(id))
+            return false;
+        removeAt(pos[id]);
+        return true;
+    } // erase()
+
+
+private:
+
+    // An element of the heap and the ID it was pushed under.
+    struct Entry
+    {
+        TYPE elt;
+        std::size_t id;
+    };
+
+    static constexpr std::size_t ROOT = 0;
+    static constexpr std::size_t NOT_IN_HEAP = std::numeric_limits<std::size_t>::max();
+
+    // The heap, base-zero, and the slot of each ID (or NOT_IN_HEAP).
+    std::vector<Entry> data;
+    std::vector<std::size_t> pos;
+
+
+    static std::size_t parent(std::size_t index)
+    { return (index - 1) / ARITY; }
+    // parent()
+
+
+    static std::size_t firstChild(std::size_t index)
+    { return index * ARITY + 1; }
+    // firstChild()
+
+
+    // Description: Put entry into slot index and record it in the map.
+    void place(std::size_t index, Entry &&entry)
+    {
+        pos[entry.id] = index;
+        data[index] = std::move(entry);
+    } // place()
+
+
+    // Description: Remove the element in slot index: the last element fills
+    //              the hole and is sifted whichever way it needs to go.
+    // Runtime: O(log(n))
+    void removeAt(std::size_t index)
+    {
+        pos[data[index].id] = NOT_IN_HEAP;
+        if (index + 1 == data.size())
+        {
+            data.pop_back();
+            return;
+        } // if
+
+        Entry last = std::move(data.back());
+        data.pop_back();
+        bool raised = this->compare(data[index].elt, last.elt);
+        place(index, std::move(last));
+        if (raised)
+            fixUp(index);
+        else
+            fixDown(index);
+    } // removeAt()
+
+
+    // Description: fixes the heap if the priority at index has increased.
+    //              The element is held aside and lower parents are moved
+    //              down into the hole, so each level costs one move.
+    // Runtime: O(log(n))
+    void fixUp(std::size_t index)
+    {
+        Entry moving = std::move(data[index]);
+        while (index != ROOT && this->compare(data[parent(index)].elt, moving.elt))
+        {
+            std::size_t up = parent(index);
+            place(index, std::move(data[up]));
+            index = up;
+        } // while
+        place(index, std::move(moving));
+    } // fixUp()
+
+
+    // Description: fixes the heap if the priority at index has decreased,
+    //              moving the highest child up into the hole at each level.
+    // Runtime: O(ARITY * log(n) / log(ARITY))
+    void fixDown(std::size_t index)
+    {
+        const std::size_t heapSize = data.size();
+        Entry moving = std::move(data[index]);
+        while (firstChild(index) < heapSize)
+        {
+            // find the highest of up to ARITY children
+            std::size_t first = firstChild(index);
+            std::size_t last = std::min(first + ARITY, heapSize);
+            std::size_t best = first;
+            for (std::size_t j = first + 1; j < last; ++j)
+                if (this->compare(data[best].elt, data[j].elt))
+                    best = j;
+
+            if (!this->compare(moving.elt, data[best].elt))
+                break;
+
+            place(index, std::move(data[best]));
+            index = best;
+        } // while
+        place(index, std::move(moving));
+    } // fixDown()
+
+
+}; // IndexedBinaryPQ
+
+#endif // INDEXEDBINARYPQ_H
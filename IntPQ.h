@@ -0,0 +1,376 @@
+//  IntPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A priority queue specialized for 32-bit unsigned integer keys, built as a
+    64-ary van Emde Boas style tree of bitmaps.
+
+    Each node owns one 64-bit word: bit d is set when child d is non-empty (or,
+    at the bottom level, when key d is present). A 32-bit key is split into
+    digits of 2 + 6 + 6 + 6 + 6 + 6 bits, so every operation touches at most six
+    words, and finding the next/previous set bit in a word is a single
+    count-trailing/leading-zeros instruction. That makes push, pop, erase,
+    successor and predecessor O(log(U) / log(64)) = 6 steps for U = 2^32, which
+    is the O(log log U) of a vEB tree with the bottom levels collapsed into words.
+
+    Children are stored compactly (only the present ones, ordered by digit), so
+    memory stays proportional to the number of distinct keys rather than to U.
+
+*/
+
+#ifndef INTPQ_H
+#define INTPQ_H
+
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "Eecs281PQ.h"
+
+// A specialized version of the 'priority queue' ADT for uint32_t keys. Only
+// std::less (largest first) and std::greater (smallest first) are supported,
+// because the bitmaps order keys numerically.
+template <typename COMP_FUNCTOR = std::less<uint32_t>>
+class IntPQ : public Eecs281PQ<uint32_t, COMP_FUNCTOR>
+{
+    // This is a way to refer to the base class object.
+    using BaseClass = Eecs281PQ<uint32_t, COMP_FUNCTOR>;
+
+    static_assert(std::is_same_v<COMP_FUNCTOR, std::less<uint32_t>> ||
+                  std::is_same_v<COMP_FUNCTOR, std::greater<uint32_t>>,
+                  "IntPQ orders keys numerically: use std::less or std::greater");
+
+public:
+
+    // Description: Construct an empty queue with an optional comparison functor.
+    // Runtime: O(1)
+    explicit IntPQ(COMP_FUNCTOR comp = COMP_FUNCTOR()) : BaseClass{comp}
+    {
+        nodes.emplace_back(); // the root always exists
+    } // IntPQ
+
+
+    // Description: Construct a queue out of an iterator range with an optional
+    //              comparison functor.
+    // Runtime: O(n) where n is number of elements in range.
+    template <typename InputIterator>
+    IntPQ(InputIterator start, InputIterator end,
+          COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : IntPQ{comp}
+    {
+        while (start != end)
+            push(*start++);
+    } // IntPQ
+
+
+    // Description: Destructor doesn't need any code, the node vector will
+    //              be destroyed automatically.
+    virtual ~IntPQ()
+    {} // ~IntPQ()
+
+
+    // Description: Keys are their own priorities, so they can never be out of
+    //              order; nothing to do.
+    // Runtime: O(1)
+    virtual void updatePriorities()
+    {} // updatePriorities()
+
+
+    // Description: Add a new key to the queue. Duplicate keys are counted.
+    // Runtime: O(1), at most six word operations.
+    virtual void push(const uint32_t &val)
+    {
+        if (!insertKey(val))
+            ++duplicates[val];
+
+        if (numElts == 0 || this->compare(extreme, val))
+            extreme = val;
+        ++numElts;
+    } // push()
+
+
+    // Description: Remove the most extreme (defined by 'compare') key.
+    // Runtime: O(1), at most six word operations.
+    virtual void pop()
+    {
+        erase(extreme);
+    } // pop()
+
+
+    // Description: Return the most extreme (defined by 'compare') key.
+    // Runtime: O(1)
+    virtual const uint32_t &top() const
+    { return extreme; }
+    // top()
+
+
+    // Description: Get the number of keys in the queue (duplicates included).
+    // Runtime: O(1)
+    virtual std::size_t size() const
+    { return numElts; }
+    // size()
+
+
+    // Description: Return true if the queue is empty.
+    // Runtime: O(1)
+    virtual bool empty() const
+    { return numElts == 0; }
+    // empty()
+
+
+    // Description: Return true if key is in the queue.
+    // Runtime: O(1), at most six word operations.
+    bool contains(uint32_t key) const
+    {
+        uint32_t node = ROOT;
+        for (unsigned level = 0; level < LEAF_LEVEL; ++level)
+        {
+            unsigned d = digit(key, level);
+            if (!hasBit(nodes[node].mask, d))
+                return false;
+            node = child(node, d);
+        } // for
+
+        return hasBit(nodes[node].mask, digit(key, LEAF_LEVEL));
+    } // contains()
+
+
+    // Description: Remove one occurrence of key, which need not be the top.
+    //              Returns false if key was not in the queue.
+    // Runtime: O(1), at most six word operations.
+    bool erase(uint32_t key)
+    {
+        auto dup = duplicates.find(key);
+        if (dup != duplicates.end())
+        {
+            if (--dup->second == 0)
+                duplicates.erase(dup);
+            --numElts;
+            return true;
+        } // if
+
+        if (!eraseKey(key))
+            return false;
+
+        --numElts;
+        if (numElts != 0 && key == extreme)
+            extreme = isMaxFirst ? maxKey() : minKey();
+        return true;
+    } // erase()
+
+
+    // Description: Return the smallest key strictly greater than key, if any.
+    // Runtime: O(1), at most twelve word operations.
+    std::optional<uint32_t> successor(uint32_t key) const
+    {
+        return neighbor(ROOT, key, 0, true);
+    } // successor()
+
+
+    // Description: Return the largest key strictly less than key, if any.
+    // Runtime: O(1), at most twelve word operations.
+    std::optional<uint32_t> predecessor(uint32_t key) const
+    {
+        return neighbor(ROOT, key, 0, false);
+    } // predecessor()
+
+
+private:
+
+    // A node of the tree: the bitmap of its present children (or keys, at the
+    // leaf level) and the indices of the present children, ordered by digit.
+    struct Node
+    {
+        uint64_t mask = 0;
+        std::vector<uint32_t> children;
+    };
+
+    // Digits, top to bottom: 2 bits at the root, then five 6-bit levels.
+    static constexpr unsigned LEAF_LEVEL = 5;
+    static constexpr unsigned BITS_PER_LEVEL = 6;
+    static constexpr uint32_t ROOT = 0;
+    static constexpr bool isMaxFirst =
+        std::is_same_v<COMP_FUNCTOR, std::less<uint32_t>>;
+
+    // Node pool, indexed by uint32_t; freed slots are recycled.
+    std::vector<Node> nodes;
+    std::vector<uint32_t> freeNodes;
+
+    // Extra copies of keys pushed more than once.
+    std::unordered_map<uint32_t, std::size_t> duplicates;
+
+    std::size_t numElts = 0;
+    uint32_t extreme = 0;
+
+
+    // Description: The digit of key used at 'level' (0 = root).
+    static unsigned digit(uint32_t key, unsigned level)
+    {
+        unsigned shift = (LEAF_LEVEL - level) * BITS_PER_LEVEL;
+        return (key >> shift) & 63u;
+    } // digit()
+
+
+    static bool hasBit(uint64_t mask, unsigned d)
+    { return (mask >> d) & 1u; }
+    // hasBit()
+
+
+    // Description: Index of child d of node, which must be present. The
+    //              children are packed, so the slot is the number of present
+    //              children with a smaller digit.
+    uint32_t child(uint32_t node, unsigned d) const
+    {
+        const Node &n = nodes[node];
+        uint64_t below = n.mask & ((uint64_t{1} << d) - 1);
+        return n.children[static_cast<std::size_t>(std::popcount(below))];
+    } // child()
+
+
+    uint32_t allocNode()
+    {
+        if (!freeNodes.empty())
+        {
+            uint32_t idx = freeNodes.back();
+            freeNodes.pop_back();
+            return idx;
+        } // if
+
+        nodes.emplace_back();
+        return static_cast<uint32_t>(nodes.size() - 1);
+    } // allocNode()
+
+
+    // Description: Set the bits for key, creating nodes along the way.
+    //              Returns false if key was already present.
+    bool insertKey(uint32_t key)
+    {
+        uint32_t node = ROOT;
+        for (unsigned level = 0; level < LEAF_LEVEL; ++level)
+        {
+            unsigned d = digit(key, level);
+            if (!hasBit(nodes[node].mask, d))
+            {
+                uint32_t fresh = allocNode();
+                Node &n = nodes[node];
+                uint64_t below = n.mask & ((uint64_t{1} << d) - 1);
+                n.children.insert(n.children.begin() + std::popcount(below), fresh);
+                n.mask |= uint64_t{1} << d;
+            } // if
+            node = child(node, d);
+        } // for
+
+        unsigned d = digit(key, LEAF_LEVEL);
+        if (hasBit(nodes[node].mask, d))
+            return false;
+        nodes[node].mask |= uint64_t{1} << d;
+        return true;
+    } // insertKey()
+
+
+    // Description: Clear the bit for key and free every node that becomes
+    //              empty. Returns false if key was not present.
+    bool eraseKey(uint32_t key)
+    {
+        uint32_t path[LEAF_LEVEL + 1];
+        uint32_t node = ROOT;
+        for (unsigned level = 0; level < LEAF_LEVEL; ++level)
+        {
+            path[level] = node;
+            unsigned d = digit(key, level);
+            if (!hasBit(nodes[node].mask, d))
+                return false;
+            node = child(node, d);
+        } // for
+        path[LEAF_LEVEL] = node;
+
+        unsigned d = digit(key, LEAF_LEVEL);
+        if (!hasBit(nodes[node].mask, d))
+            return false;
+        nodes[node].mask &= ~(uint64_t{1} << d);
+
+        // Walk back up, unlinking emptied nodes from their parents.
+        for (unsigned level = LEAF_LEVEL; level > 0 && nodes[path[level]].mask == 0; --level)
+        {
+            freeNodes.push_back(path[level]);
+            nodes[path[level]].children.clear();
+
+            Node &parent = nodes[path[level - 1]];
+            unsigned pd = digit(key, level - 1);
+            uint64_t below = parent.mask & ((uint64_t{1} << pd) - 1);
+            parent.children.erase(parent.children.begin() + std::popcount(below));
+            parent.mask &= ~(uint64_t{1} << pd);
+        } // for
+
+        return true;
+    } // eraseKey()
+
+
+    // Description: Smallest (or largest) key in the subtree rooted at node,
+    //              which sits at 'level' and whose digits so far form prefix.
+    uint32_t extremeBelow(uint32_t node, unsigned level, uint32_t prefix, bool smallest) const
+    {
+        for (;; ++level)
+        {
+            uint64_t mask = nodes[node].mask;
+            unsigned d = smallest
+                ? static_cast<unsigned>(std::countr_zero(mask))
+                : 63u - static_cast<unsigned>(std::countl_zero(mask));
+            prefix = (prefix << BITS_PER_LEVEL) | d;
+            if (level == LEAF_LEVEL)
+                return prefix;
+            node = child(node, d);
+        } // for
+    } // extremeBelow()
+
+
+    uint32_t minKey() const
+    { return extremeBelow(ROOT, 0, 0, true); }
+    // minKey()
+
+
+    uint32_t maxKey() const
+    { return extremeBelow(ROOT, 0, 0, false); }
+    // maxKey()
+
+
+    // Description: The next key after (upward == true) or before key inside
+    //              the subtree rooted at node, at 'level', with the given
+    //              prefix of already-matched digits.
+    std::optional<uint32_t> neighbor(uint32_t node, uint32_t key, unsigned level,
+                                     bool upward) const
+    {
+        const uint64_t mask = nodes[node].mask;
+        const unsigned d = digit(key, level);
+        const uint32_t prefix = (level == 0) ? 0
+            : key >> ((LEAF_LEVEL - level + 1) * BITS_PER_LEVEL);
+
+        // First try to stay on key's own path.
+        if (level < LEAF_LEVEL && hasBit(mask, d))
+            if (auto found = neighbor(child(node, d), key, level + 1, upward))
+                return found;
+
+        // Otherwise take the nearest sibling digit on the correct side.
+        uint64_t side = upward
+            ? (d == 63 ? 0 : mask & (~uint64_t{0} << (d + 1)))
+            : mask & ((uint64_t{1} << d) - 1);
+        if (side == 0)
+            return std::nullopt;
+
+        unsigned next = upward
+            ? static_cast<unsigned>(std::countr_zero(side))
+            : 63u - static_cast<unsigned>(std::countl_zero(side));
+        uint32_t nextPrefix = (prefix << BITS_PER_LEVEL) | next;
+        if (level == LEAF_LEVEL)
+            return nextPrefix;
+        return extremeBelow(child(node, next), level + 1, nextPrefix, upward);
+    } // neighbor()
+
+
+}; // IntPQ
+
+#endif // INTPQ_H
@@ -0,0 +1,131 @@
+//  LockedPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    Any of the priority queues behind one std::mutex: the simplest way to
+    share a queue between threads, and the baseline the concurrent queues
+    are measured against.
+
+    top() followed by pop() is not atomic once other threads can get in
+    between, so the shared interface is push() and try_pop(), which takes
+    the top element and removes it under one lock. try_pop() on an empty
+    queue returns false instead of being a precondition violation.
+
+    try_lock_push() and try_lock_pop() give up instead of waiting when
+    another thread holds the lock, for callers that would rather go to
+    another queue.
+
+*/
+
+#ifndef LOCKEDPQ_H
+#define LOCKEDPQ_H
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include "BinaryPQ.h"
+
+// A priority queue of type PQ, holding TYPE elements, shared between
+// threads through one mutex.
+template <typename TYPE, typename PQ = BinaryPQ<TYPE>>
+class LockedPQ
+{
+public:
+
+    // Description: Construct the queue from whatever arguments PQ's
+    //              constructor takes.
+    // Runtime: That of PQ's constructor.
+    template <typename... Args>
+    explicit LockedPQ(Args &&...args) : pq{ std::forward<Args>(args)... }
+    {} // LockedPQ
+
+
+    // The mutex cannot be copied.
+    LockedPQ(const LockedPQ &) = delete;
+    LockedPQ &operator=(const LockedPQ &) = delete;
+
+
+    // Description: Add a new element to the queue.
+    // Runtime: That of PQ::push(), plus the wait for the lock.
+    void push(const TYPE &val)
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        pq.push(val);
+    } // push()
+
+
+    // Description: Remove the most extreme element and copy it into out.
+    // Runtime: That of PQ::pop(), plus the wait for the lock.
+    // Returns: false, leaving out alone, if the queue is empty
+    bool try_pop(TYPE &out)
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        return popLocked(out);
+    } // try_pop()
+
+
+    // Description: push(), unless another thread holds the lock.
+    // Runtime: That of PQ::push()
+    // Returns: false if the lock was taken and val was not pushed
+    bool try_lock_push(const TYPE &val)
+    {
+        std::unique_lock<std::mutex> guard{ lock, std::try_to_lock };
+        if (!guard.owns_lock())
+            return false;
+        pq.push(val);
+        return true;
+    } // try_lock_push()
+
+
+    // Description: try_pop(), unless another thread holds the lock.
+    // Runtime: That of PQ::pop()
+    // Returns: false if the lock was taken or the queue is empty
+    bool try_lock_pop(TYPE &out)
+    {
+        std::unique_lock<std::mutex> guard{ lock, std::try_to_lock };
+        return guard.owns_lock() && popLocked(out);
+    } // try_lock_pop()
+
+
+    // Description: Get the number of elements in the queue. Other threads
+    //              may change it before the caller looks at it.
+    // Runtime: O(1), plus the wait for the lock.
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        return pq.size();
+    } // size()
+
+
+    // Description: Return true if the queue is empty, as of the call.
+    // Runtime: O(1), plus the wait for the lock.
+    bool empty() const
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        return pq.empty();
+    } // empty()
+
+
+private:
+
+    mutable std::mutex lock;
+    PQ pq;
+
+
+    // Description: try_pop() with the lock held.
+    // Runtime: That of PQ::pop()
+    bool popLocked(TYPE &out)
+    {
+        if (pq.empty())
+            return false;
+        out = pq.top();
+        pq.pop();
+        return true;
+    } // popLocked()
+
+
+}; // LockedPQ
+
+#endif // LOCKEDPQ_H
@@ -0,0 +1,233 @@
+//  LoserTree.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A tournament tree of losers, used to merge k streams that are each already
+    in priority order. Every internal node remembers the leaf that LOST the match
+    played there, and the overall winner is kept on the side. When the winner's
+    leaf gets a new value, only the matches on the path from that leaf to the
+    root have to be replayed, which is exactly ceil(log k) compares, versus the
+    ~2 log k compares of a binary heap's pop() followed by a push().
+
+    Layout: leaf i lives at position (k + i), internal nodes are 1 .. k - 1, and
+    the parent of position p is p / 2 (this works for any k, not only powers of 2).
+
+*/
+
+#ifndef LOSERTREE_H
+#define LOSERTREE_H
+
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// A tournament (loser) tree over k leaves. With the default functor
+// (std::less) the winner is the largest leaf, just like top() of the PQs.
+// TYPE must be default constructible so that exhausted leaves have a value.
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+class LoserTree
+{
+public:
+
+    // Description: Construct a tree with k leaves, all of them exhausted.
+    //              Give them values with setLeaf(), then call build().
+    // Runtime: O(k)
+    explicit LoserTree(std::size_t k, COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : compare{comp}, numLeaves{k}, numLive{0}, winner{0},
+          leaves(k), live(k, false), losers(k, 0)
+    {} // LoserTree
+
+
+    // Description: Construct a tree whose leaves are the (live) elements of an
+    //              iterator range, and play the initial tournament.
+    // Runtime: O(k) where k is number of elements in range.
+    template <typename InputIterator>
+    LoserTree(InputIterator start, InputIterator end,
+              COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : compare{comp}, numLeaves{0}, numLive{0}, winner{0}, leaves{start, end}
+    {
+        numLeaves = leaves.size();
+        live.assign(numLeaves, true);
+        losers.assign(numLeaves, 0);
+        build();
+    } // LoserTree
+
+
+    // Description: Give leaf i a value and mark it live. The tournament is not
+    //              replayed; call build() once all leaves are set.
+    // Runtime: O(1)
+    void setLeaf(std::size_t i, const TYPE &val)
+    {
+        leaves[i] = val;
+        live[i] = true;
+    } // setLeaf()
+
+
+    // Description: Play the whole tournament from scratch.
+    // Runtime: O(k)
+    void build()
+    {
+        numLive = 0;
+        for (std::size_t i = 0; i < numLeaves; ++i)
+            numLive += live[i] ? 1 : 0;
+
+        if (numLeaves == 0)
+            return;
+
+        // Temporary winners of every match, indexed by tree position.
+        std::vector<std::size_t> winners(2 * numLeaves);
+        for (std::size_t i = 0; i < numLeaves; ++i)
+            winners[numLeaves + i] = i;
+
+        for (std::size_t node = numLeaves - 1; node >= ROOT; --node)
+        {
+            std::size_t left = winners[2 * node],
+                        right = winners[2 * node + 1];
+            bool rightWins = beats(right, left);
+            winners[node] = rightWins ? right : left;
+            losers[node] = rightWins ? left : right;
+        } // for
+
+        winner = winners[ROOT];
+    } // build()
+
+
+    // Description: Return the most extreme (defined by 'compare') live leaf.
+    // Runtime: O(1)
+    const TYPE &top() const
+    { return leaves[winner]; }
+    // top()
+
+
+    // Description: Return which leaf (stream) the current top came from.
+    // Runtime: O(1)
+    std::size_t topIndex() const
+    { return winner; }
+    // topIndex()
+
+
+    // Description: Replace the winning leaf with the next value from its
+    //              stream and replay its path to the root.
+    // Runtime: O(log(k)), exactly one compare per level.
+    void replace_top(const TYPE &val)
+    {
+        leaves[winner] = val;
+        replay(winner);
+    } // replace_top()
+
+
+    // Description: The winning leaf's stream ran dry; take it out of play.
+    // Runtime: O(log(k))
+    void exhaustTop()
+    {
+        live[winner] = false;
+        --numLive;
+        replay(winner);
+    } // exhaustTop()
+
+
+    // Description: Get the number of live leaves.
+    // Runtime: O(1)
+    std::size_t size() const
+    { return numLive; }
+    // size()
+
+
+    // Description: Return true if every leaf is exhausted.
+    // Runtime: O(1)
+    bool empty() const
+    { return numLive == 0; }
+    // empty()
+
+
+private:
+
+    // Constant for the root of the tournament.
+    static constexpr std::size_t ROOT = 1;
+
+    COMP_FUNCTOR compare;
+    std::size_t numLeaves;
+    std::size_t numLive;
+
+    // Leaf that won the final match.
+    std::size_t winner;
+
+    // Current value of every leaf, and whether its stream is still live.
+    // (char instead of bool to avoid the packed vector<bool> specialization)
+    std::vector<TYPE> leaves;
+    std::vector<char> live;
+
+    // losers[node] is the leaf that lost the match at 'node'.
+    std::vector<std::size_t> losers;
+
+
+    // Description: Does leaf a win a match against leaf b? Exhausted leaves
+    //              always lose.
+    // Runtime: O(1)
+    bool beats(std::size_t a, std::size_t b) const
+    {
+        return !live[b] || (live[a] && compare(leaves[b], leaves[a]));
+    } // beats()
+
+
+    // Description: Replay the matches from leaf i up to the root. The stored
+    //              loser and the climbing winner are swapped with selects rather
+    //              than branches, so the loop body compiles to conditional moves.
+    // Runtime: O(log(k))
+    void replay(std::size_t i)
+    {
+        std::size_t climber = i;
+        for (std::size_t node = (numLeaves + i) / 2; node >= ROOT; node /= 2)
+        {
+            std::size_t stored = losers[node];
+            bool storedWins = beats(stored, climber);
+            losers[node] = storedWins ? climber : stored;
+            climber = storedWins ? stored : climber;
+        } // for
+
+        winner = climber;
+    } // replay()
+
+
+}; // LoserTree
+
+
+// Description: Merge k ranges, each already in priority order (the order pop()
+//              would produce with the same functor, i.e. descending for
+//              std::less), into a single stream written to 'out'. Use
+//              std::greater to merge ascending (e.g. time-sorted) ranges.
+// Runtime: O(n log(k)) where n is the total number of elements.
+template <typename InputIterator, typename OutputIterator,
+          typename COMP_FUNCTOR =
+              std::less<typename std::iterator_traits<InputIterator>::value_type>>
+OutputIterator kway_merge(
+    std::vector<std::pair<InputIterator, InputIterator>> ranges,
+    OutputIterator out, COMP_FUNCTOR comp = COMP_FUNCTOR())
+{
+    using TYPE = typename std::iterator_traits<InputIterator>::value_type;
+
+    LoserTree<TYPE, COMP_FUNCTOR> tree(ranges.size(), comp);
+    for (std::size_t i = 0; i < ranges.size(); ++i)
+        if (ranges[i].first != ranges[i].second)
+            tree.setLeaf(i, *ranges[i].first);
+    tree.build();
+
+    while (!tree.empty())
+    {
+        std::size_t i = tree.topIndex();
+        *out++ = tree.top();
+
+        // Advance the winning range and feed its next element back in.
+        if (++ranges[i].first != ranges[i].second)
+            tree.replace_top(*ranges[i].first);
+        else
+            tree.exhaustTop();
+    } // while
+
+    return out;
+} // kway_merge()
+
+#endif // LOSERTREE_H
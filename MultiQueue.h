@@ -0,0 +1,280 @@
+//  MultiQueue.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A relaxed concurrent priority queue after Rihani, Sanders and Dementiev,
+    "MultiQueues: Simple Relaxed Concurrent Priority Queues" (2015).
+
+    The elements are spread over c * p shards, each an ordinary queue (a
+    BinaryPQ by default) behind its own SpinLock, for p threads and a
+    factor c. Shards only ever try_lock(), so no thread waits on another
+    one.
+
+    - push() puts the element into a random shard whose lock it gets.
+    - try_pop() picks two random shards and pops the better of their two
+      tops.
+
+    A pop is therefore not always the most extreme element in the queue,
+    but one of the best few: the expected rank error grows with c * p, and
+    the chance of two threads wanting the same shard shrinks with it. Use c
+    to trade one against the other.
+
+    With TRACK_RANK = true, the queue also keeps every element in a
+    std::multiset behind one mutex, and each pop counts the elements in it
+    that are more extreme than the one it took. The queue is then serial,
+    so only use it to measure rank_stats() while tuning c.
+
+    When two random picks keep finding empty shards, try_pop() falls back
+    to scanning every shard, so it only returns false when all of them were
+    empty.
+
+*/
+
+#ifndef MULTIQUEUE_H
+#define MULTIQUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "BinaryPQ.h"
+#include "SpinLock.h"
+
+// A relaxed priority queue (defined by 'compare') over shards of type
+// SHARD, safe for concurrent push() and try_pop().
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+          typename SHARD = BinaryPQ<TYPE, COMP_FUNCTOR>, bool TRACK_RANK = false>
+class MultiQueue
+{
+public:
+
+    // How far from the top the pops have been. A pop's rank error is the
+    // number of elements more extreme than it in the queue at the time.
+    struct RankStats
+    {
+        std::size_t pops = 0;
+        std::size_t total = 0;
+        std::size_t worst = 0;
+
+        double mean() const { return pops ? static_cast<double>(total) / static_cast<double>(pops) : 0.0; }
+    }; // RankStats
+
+
+    // Description: Construct an empty queue of factor * threads shards,
+    //              with an optional comparison functor.
+    // Runtime: O(factor * threads)
+    explicit MultiQueue(std::size_t threads = std::thread::hardware_concurrency(),
+                        std::size_t factor = 2, COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : compare{ comp }, ranked{ comp }
+    {
+        const std::size_t n = std::max(std::size_t{ 1 }, threads * factor);
+        for (std::size_t i = 0; i < n; ++i)
+            shards.push_back(std::make_unique<Shard>(comp));
+    } // MultiQueue
+
+
+    // The locks cannot be copied.
+    MultiQueue(const MultiQueue &) = delete;
+    MultiQueue &operator=(const MultiQueue &) = delete;
+
+
+    // Description: Add a new element to a random shard.
+    // Runtime: That of SHARD::push(), plus retries while shards are busy.
+    void push(const TYPE &val)
+    {
+        for (;;)
+        {
+            Shard &shard = *shards[randomShard()];
+            std::unique_lock<SpinLock> guard{ shard.lock, std::try_to_lock };
+            if (!guard.owns_lock())
+                continue;
+            shard.pq.push(val);
+            count.fetch_add(1, std::memory_order_release);
+            if constexpr (TRACK_RANK)
+            {
+                std::lock_guard<std::mutex> statsGuard{ statsLock };
+                ranked.insert(val);
+            } // if
+            return;
+        } // for
+    } // push()
+
+
+    // Description: Remove the better top of two random shards and copy it
+    //              into out.
+    // Runtime: That of SHARD::pop(), plus retries while shards are busy.
+    // Returns: false, leaving out alone, if every shard was empty
+    bool try_pop(TYPE &out)
+    {
+        std::size_t misses = 0;
+        while (count.load(std::memory_order_acquire) > 0)
+        {
+            Shard &first = *shards[randomShard()];
+            Shard &second = *shards[randomShard()];
+            std::unique_lock<SpinLock> firstGuard{ first.lock, std::try_to_lock };
+            if (!firstGuard.owns_lock())
+                continue;
+            std::unique_lock<SpinLock> secondGuard;
+            if (&second != &first)
+            {
+                secondGuard = std::unique_lock<SpinLock>{ second.lock, std::try_to_lock };
+                if (!secondGuard.owns_lock())
+                    continue;
+            } // if
+
+            Shard *best = better(first, second);
+            if (best)
+            {
+                take(*best, out);
+                return true;
+            } // if
+            if (++misses >= shards.size())
+            {
+                firstGuard.unlock();
+                if (secondGuard.owns_lock())
+                    secondGuard.unlock();
+                return scanPop(out);
+            } // if
+        } // while
+        return false;
+    } // try_pop()
+
+
+    // Description: Get the number of elements in the queue, as of the call.
+    // Runtime: O(1)
+    std::size_t size() const
+    {
+        return count.load(std::memory_order_acquire);
+    } // size()
+
+
+    // Description: Return true if the queue is empty, as of the call.
+    // Runtime: O(1)
+    bool empty() const
+    {
+        return size() == 0;
+    } // empty()
+
+
+    // Description: The number of shards, factor * threads.
+    // Runtime: O(1)
+    std::size_t shard_count() const
+    {
+        return shards.size();
+    } // shard_count()
+
+
+    // Description: The rank errors of the pops so far; all zero unless
+    //              TRACK_RANK.
+    // Runtime: O(1)
+    RankStats rank_stats() const
+    {
+        std::lock_guard<std::mutex> statsGuard{ statsLock };
+        return stats;
+    } // rank_stats()
+
+
+private:
+
+    // A shard gets a cache line of its own, so that locking one does not
+    // slow down threads working on its neighbors.
+    struct alignas(64) Shard
+    {
+        SpinLock lock;
+        SHARD pq;
+
+        explicit Shard(const COMP_FUNCTOR &comp) : pq{ comp } {}
+    }; // Shard
+
+    COMP_FUNCTOR compare;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<std::size_t> count{ 0 };
+
+    // every element, and the rank errors so far, with TRACK_RANK
+    mutable std::mutex statsLock;
+    std::multiset<TYPE, COMP_FUNCTOR> ranked;
+    RankStats stats;
+
+
+    // Description: A uniformly random shard index, from a generator of the
+    //              calling thread's own.
+    // Runtime: O(1)
+    std::size_t randomShard() const
+    {
+        // xorshift64*, seeded from the address of the state itself, which
+        // differs between threads
+        thread_local std::uint64_t state = 0;
+        if (state == 0)
+            state = reinterpret_cast<std::uintptr_t>(&state) | 1;
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        const std::uint64_t bits = (state * 0x2545F4914F6CDD1DULL) >> 32;
+        return static_cast<std::size_t>((bits * shards.size()) >> 32);
+    } // randomShard()
+
+
+    // Description: The locked shard with the more extreme top, or nullptr
+    //              if both are empty.
+    // Runtime: O(1)
+    Shard *better(Shard &a, Shard &b) const
+    {
+        if (a.pq.empty())
+            return b.pq.empty() ? nullptr : &b;
+        if (b.pq.empty() || !compare(a.pq.top(), b.pq.top()))
+            return &a;
+        return &b;
+    } // better()
+
+
+    // Description: Pop the top of a locked, non-empty shard into out.
+    // Runtime: That of SHARD::pop(), plus O(rank error) with TRACK_RANK.
+    void take(Shard &shard, TYPE &out)
+    {
+        out = shard.pq.top();
+        shard.pq.pop();
+        count.fetch_sub(1, std::memory_order_release);
+        if constexpr (TRACK_RANK)
+        {
+            std::lock_guard<std::mutex> statsGuard{ statsLock };
+            std::size_t rank = 0;
+            for (auto it = ranked.rbegin(); compare(out, *it); ++it)
+                ++rank;
+            ranked.erase(ranked.find(out));
+            ++stats.pops;
+            stats.total += rank;
+            stats.worst = std::max(stats.worst, rank);
+        } // if
+    } // take()
+
+
+    // Description: Pop the top of the first non-empty shard, waiting for
+    //              each lock in turn.
+    // Runtime: O(shards) plus that of SHARD::pop()
+    // Returns: false if every shard was empty
+    bool scanPop(TYPE &out)
+    {
+        for (std::unique_ptr<Shard> &shard : shards)
+        {
+            std::lock_guard<SpinLock> guard{ shard->lock };
+            if (!shard->pq.empty())
+            {
+                take(*shard, out);
+                return true;
+            } // if
+        } // for
+        return false;
+    } // scanPop()
+
+
+}; // MultiQueue
+
+#endif // MULTIQUEUE_H
@@ -0,0 +1,306 @@
+//  NodeArena.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A pool of small blocks carved out of large chunks, for keeping the nodes
+    of one heap together, and on one NUMA node.
+
+    Blocks are handed out by bumping a pointer through the current chunk,
+    and freed blocks go to a free list per size class (multiples of 16
+    bytes, up to 256), to be handed out again first. Chunks are only
+    returned when the arena is destroyed. Larger or more aligned blocks
+    come from operator new instead.
+
+    On Linux, a chunk is mapped with mmap() and, given a NUMA node, bound
+    to it with the mbind() system call, so its pages come from that node
+    whichever thread first touches them. Where mbind() fails (a kernel
+    without NUMA, a container that forbids it, a node that does not exist)
+    or is not available, the calling thread writes to every page of the
+    chunk at once, so they come from the node that thread runs on, which
+    the first-touch policy makes the local one. bound() tells whether every
+    chunk so far was bound.
+
+    An arena is not thread-safe; whoever owns it (a shard behind its lock)
+    serializes access. ArenaAllocator adapts one to the standard allocator
+    interface, so that containers such as PairingPQ can take their nodes
+    from it.
+
+*/
+
+#ifndef NODEARENA_H
+#define NODEARENA_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class NodeArena
+{
+public:
+
+    // Description: Construct an empty arena whose chunks of chunkBytes are
+    //              bound to NUMA node numaNode, or not bound if it is
+    //              negative.
+    // Runtime: O(1)
+    explicit NodeArena(int numaNode = -1, std::size_t chunkBytes = std::size_t{ 1 } << 20)
+        : node{ numaNode }, chunkSize{ std::max(chunkBytes, MAX_BLOCK) }
+    {} // NodeArena
+
+
+    // The chunks cannot be shared.
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+
+
+    // Description: Return every chunk to the system. Blocks still in use
+    //              become invalid.
+    // Runtime: O(chunks)
+    ~NodeArena()
+    {
+        for (void *chunk : chunkList)
+            releaseChunk(chunk);
+    } // ~NodeArena()
+
+
+    // Description: A block of at least bytes, aligned to align.
+    // Runtime: O(1), plus O(chunkBytes) to touch a new chunk.
+    void *allocate(std::size_t bytes, std::size_t align)
+    {
+        if (bytes > MAX_BLOCK || align > GRAIN)
+            return ::operator new(bytes, std::align_val_t{ std::max(align, alignof(std::max_align_t)) });
+
+        const std::size_t sizeClass = classOf(bytes);
+        if (FreeBlock *block = freeLists[sizeClass])
+        {
+            freeLists[sizeClass] = block->next;
+            return block;
+        } // if
+
+        const std::size_t blockBytes = (sizeClass + 1) * GRAIN;
+        if (static_cast<std::size_t>(limit - cursor) < blockBytes)
+            newChunk();
+        void *block = cursor;
+        cursor += blockBytes;
+        return block;
+    } // allocate()
+
+
+    // Description: Give back a block from allocate(bytes, align).
+    // Runtime: O(1)
+    void deallocate(void *block, std::size_t bytes, std::size_t align) noexcept
+    {
+        if (bytes > MAX_BLOCK || align > GRAIN)
+        {
+            ::operator delete(block, std::align_val_t{ std::max(align, alignof(std::max_align_t)) });
+            return;
+        } // if
+
+        const std::size_t sizeClass = classOf(bytes);
+        freeLists[sizeClass] = ::new (block) FreeBlock{ freeLists[sizeClass] };
+    } // deallocate()
+
+
+    // Description: The NUMA node the arena binds its chunks to, or -1.
+    // Runtime: O(1)
+    int numa_node() const
+    {
+        return node;
+    } // numa_node()
+
+
+    // Description: Return true if every chunk so far was bound to the
+    //              node with mbind(), and false if any was only touched.
+    // Runtime: O(1)
+    bool bound() const
+    {
+        return node >= 0 && allBound;
+    } // bound()
+
+
+    // Description: The number of chunks taken from the system so far.
+    // Runtime: O(1)
+    std::size_t chunks() const
+    {
+        return chunkList.size();
+    } // chunks()
+
+
+private:
+
+    static constexpr std::size_t GRAIN = 16;
+    static constexpr std::size_t MAX_BLOCK = 256;
+
+    // A freed block, linked through its own first bytes.
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    }; // FreeBlock
+
+    int node;
+    std::size_t chunkSize;
+    bool allBound = true;
+    std::vector<void *> chunkList;
+    std::array<FreeBlock *, MAX_BLOCK / GRAIN> freeLists{};
+    char *cursor = nullptr;
+    char *limit = nullptr;
+
+
+    // Description: The free list for blocks of bytes.
+    // Runtime: O(1)
+    static std::size_t classOf(std::size_t bytes)
+    {
+        return (std::max(bytes, std::size_t{ 1 }) - 1) / GRAIN;
+    } // classOf()
+
+
+    // Description: Start a new chunk; the rest of the current one is lost.
+    // Runtime: O(chunkBytes)
+    void newChunk()
+    {
+        chunkList.reserve(chunkList.size() + 1);
+        void *chunk = nullptr;
+#if defined(__linux__)
+        chunk = ::mmap(nullptr, chunkSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (chunk == MAP_FAILED)
+            throw std::bad_alloc{};
+        if (!bind(chunk))
+            touch(chunk);
+#else
+        chunk = ::operator new(chunkSize, std::align_val_t{ 64 });
+        allBound = false;
+        touch(chunk);
+#endif
+        chunkList.push_back(chunk);
+        cursor = static_cast<char *>(chunk);
+        limit = cursor + chunkSize;
+    } // newChunk()
+
+
+    // Description: Bind chunk's pages to the arena's node.
+    // Runtime: O(1)
+    // Returns: false if there is no node to bind to, or mbind() failed
+    bool bind([[maybe_unused]] void *chunk)
+    {
+        if (node < 0)
+            return false;
+#if defined(__linux__) && defined(SYS_mbind)
+        // MPOL_BIND from <numaif.h>, which needs libnuma to link against
+        constexpr int MPOL_BIND_MODE = 2;
+        constexpr std::size_t BITS = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> mask(static_cast<std::size_t>(node) / BITS + 1, 0);
+        mask[static_cast<std::size_t>(node) / BITS] = 1UL << (static_cast<std::size_t>(node) % BITS);
+        if (::syscall(SYS_mbind, chunk, chunkSize, MPOL_BIND_MODE, mask.data(),
+                      mask.size() * BITS + 1, 0) == 0)
+            return true;
+#endif
+        allBound = false;
+        return false;
+    } // bind()
+
+
+    // Description: Write to every page of chunk, so that they are placed
+    //              now, on the calling thread's node.
+    // Runtime: O(chunkBytes / page size)
+    void touch(void *chunk) const
+    {
+        volatile char *bytes = static_cast<char *>(chunk);
+        for (std::size_t i = 0; i < chunkSize; i += 4096)
+            bytes[i] = 0;
+    } // touch()
+
+
+    // Description: Return chunk to the system.
+    // Runtime: O(1)
+    void releaseChunk(void *chunk) const
+    {
+#if defined(__linux__)
+        ::munmap(chunk, chunkSize);
+#else
+        ::operator delete(chunk, std::align_val_t{ 64 });
+#endif
+    } // releaseChunk()
+
+
+}; // NodeArena
+
+
+// A standard allocator that takes its memory from a NodeArena, or from
+// std::allocator without one.
+template <typename TYPE>
+class ArenaAllocator
+{
+public:
+
+    using value_type = TYPE;
+
+    // Description: An allocator drawing from arena, which must outlive
+    //              every block it hands out.
+    // Runtime: O(1)
+    explicit ArenaAllocator(NodeArena *arena = nullptr) noexcept : source{ arena }
+    {} // ArenaAllocator
+
+
+    // Description: The same arena, for another type.
+    // Runtime: O(1)
+    template <typename OTHER>
+    ArenaAllocator(const ArenaAllocator<OTHER> &other) noexcept : source{ other.arena() }
+    {} // ArenaAllocator
+
+
+    // Description: Room for n objects.
+    // Runtime: O(1)
+    TYPE *allocate(std::size_t n)
+    {
+        if (!source)
+            return std::allocator<TYPE>{}.allocate(n);
+        return static_cast<TYPE *>(source->allocate(n * sizeof(TYPE), alignof(TYPE)));
+    } // allocate()
+
+
+    // Description: Give back room from allocate(n).
+    // Runtime: O(1)
+    void deallocate(TYPE *block, std::size_t n) noexcept
+    {
+        if (!source)
+            std::allocator<TYPE>{}.deallocate(block, n);
+        else
+            source->deallocate(block, n * sizeof(TYPE), alignof(TYPE));
+    } // deallocate()
+
+
+    // Description: The arena, or nullptr.
+    // Runtime: O(1)
+    NodeArena *arena() const noexcept
+    {
+        return source;
+    } // arena()
+
+
+    // Blocks from one allocator may go back to the other.
+    friend bool operator==(const ArenaAllocator &a, const ArenaAllocator &b) noexcept
+    {
+        return a.source == b.source;
+    } // operator==()
+
+
+private:
+
+    NodeArena *source;
+
+
+}; // ArenaAllocator
+
+#endif // NODEARENA_H
@@ -0,0 +1,402 @@
+//  NumaShardedPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A priority queue with one shard per NUMA node, for machines where one
+    heap's nodes would otherwise be spread over every socket and half of
+    all accesses would be remote.
+
+    Each shard is a PairingPQ behind its own SpinLock, whose nodes come
+    from a NodeArena bound to that NUMA node, and push() goes to the shard
+    of the node the calling thread runs on. Across shards, a LoserTree
+    over copies of the shard tops picks the shard to pop from, so the
+    queue is exact: try_pop() takes the most extreme element of all.
+
+    - try_pop() holds the tournament's mutex, pops the winning shard and
+      replays its path with the shard's new top.
+    - push() only takes its shard's lock, unless it gives the shard a new
+      top. Then it publishes that top in the tournament, under the mutex,
+      before it returns. A shard whose new top is not published yet is
+      marked stale, so that pushes after it publish too, and no element
+      whose push() returned can be missed by try_pop().
+    - Locks are taken mutex before shard.
+
+    NumaTopology::detect() reads the nodes and their CPUs from
+    /sys/devices/system/node. Where that is missing, as off Linux, it falls
+    back to a single node, which makes this one PairingPQ plus a lock.
+    NumaTopology::simulate() makes up a topology instead, for testing on a
+    single-node machine: its shards are real, but threads are spread over
+    them by thread number rather than by CPU, and arenas are not bound.
+
+    TYPE must be default constructible, for the tournament's empty leaves.
+
+*/
+
+#ifndef NUMASHARDEDPQ_H
+#define NUMASHARDEDPQ_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LoserTree.h"
+#include "NodeArena.h"
+#include "PairingPQ.h"
+#include "SpinLock.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+// The NUMA nodes of a machine, and the CPUs of each.
+struct NumaTopology
+{
+    // the system's number for each node, and its CPUs
+    std::vector<int> nodeIds;
+    std::vector<std::vector<int>> cpus;
+
+    // made up by simulate() rather than read from the system
+    bool simulated = false;
+
+
+    // Description: The machine's topology, or one node with every CPU
+    //              where the system does not say.
+    // Runtime: O(nodes + CPUs)
+    static NumaTopology detect()
+    {
+        NumaTopology topology;
+        const std::string root = "/sys/devices/system/node/";
+        for (int id : parseList(readLine(root + "online")))
+        {
+            std::vector<int> nodeCpus = parseList(readLine(root + "node" + std::to_string(id) + "/cpulist"));
+            if (nodeCpus.empty())
+                continue;
+            topology.nodeIds.push_back(id);
+            topology.cpus.push_back(std::move(nodeCpus));
+        } // for
+
+        if (topology.nodeIds.empty())
+        {
+            topology.nodeIds.push_back(0);
+            topology.cpus.emplace_back();
+            const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned cpu = 0; cpu < cores; ++cpu)
+                topology.cpus.back().push_back(static_cast<int>(cpu));
+        } // if
+        return topology;
+    } // detect()
+
+
+    // Description: A made-up topology of 'nodes' nodes with cpusPerNode
+    //              CPUs each, numbered in order.
+    // Runtime: O(nodes * cpusPerNode)
+    static NumaTopology simulate(std::size_t nodes, std::size_t cpusPerNode = 1)
+    {
+        NumaTopology topology;
+        topology.simulated = true;
+        int cpu = 0;
+        for (std::size_t node = 0; node < std::max(nodes, std::size_t{ 1 }); ++node)
+        {
+            topology.nodeIds.push_back(static_cast<int>(node));
+            topology.cpus.emplace_back();
+            for (std::size_t i = 0; i < std::max(cpusPerNode, std::size_t{ 1 }); ++i)
+                topology.cpus.back().push_back(cpu++);
+        } // for
+        return topology;
+    } // simulate()
+
+
+    // Description: The number of nodes.
+    // Runtime: O(1)
+    std::size_t nodes() const
+    {
+        return nodeIds.size();
+    } // nodes()
+
+
+    // Description: The index (not the system's number) of the node that
+    //              cpu belongs to, or 0 if none does.
+    // Runtime: O(CPUs)
+    std::size_t nodeOfCpu(int cpu) const
+    {
+        for (std::size_t node = 0; node < cpus.size(); ++node)
+            if (std::find(cpus[node].begin(), cpus[node].end(), cpu) != cpus[node].end())
+                return node;
+        return 0;
+    } // nodeOfCpu()
+
+
+    // Description: The numbers in a list like "0-3,8,10-11", the format of
+    //              the files under /sys/devices/system/node.
+    // Runtime: O(numbers)
+    static std::vector<int> parseList(const std::string &list)
+    {
+        std::vector<int> numbers;
+        std::stringstream ss{ list };
+        std::string range;
+        while (std::getline(ss, range, ','))
+        {
+            const std::size_t dash = range.find('-');
+            try
+            {
+                const int first = std::stoi(range.substr(0, dash));
+                const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int n = first; n <= last; ++n)
+                    numbers.push_back(n);
+            } // try
+            catch (const std::exception &)
+            {
+                // not a number, such as an empty list
+            } // catch
+        } // while
+        return numbers;
+    } // parseList()
+
+
+    // Description: The first line of a file, or "" if it cannot be read.
+    // Runtime: O(line length)
+    static std::string readLine(const std::string &path)
+    {
+        std::ifstream in{ path };
+        std::string line;
+        std::getline(in, line);
+        return line;
+    } // readLine()
+}; // NumaTopology
+
+
+// A priority queue (defined by 'compare') safe for concurrent push(),
+// try_pop() and try_top(), with a shard and node arena per NUMA node.
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+class NumaShardedPQ
+{
+public:
+
+    // Description: Construct an empty queue with one shard per node of
+    //              topology, and an optional comparison functor.
+    // Runtime: O(nodes)
+    explicit NumaShardedPQ(NumaTopology topo = NumaTopology::detect(),
+                           COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : compare{ comp }, layout{ std::move(topo) }, tournament{ layout.nodes(), comp }
+    {
+        for (std::size_t i = 0; i < layout.nodes(); ++i)
+            shards.push_back(std::make_unique<Shard>(layout.simulated ? -1 : layout.nodeIds[i], comp));
+    } // NumaShardedPQ
+
+
+    // The locks cannot be copied.
+    NumaShardedPQ(const NumaShardedPQ &) = delete;
+    NumaShardedPQ &operator=(const NumaShardedPQ &) = delete;
+
+
+    // Description: Add a new element to the shard of the calling thread's
+    //              node.
+    // Runtime: O(1), plus O(nodes) and the wait for the mutex if it is
+    //          its shard's new top.
+    void push(const TYPE &val)
+    {
+        push(val, currentShard());
+    } // push()
+
+
+    // Description: Add a new element to the given shard, for callers that
+    //              know better which node will use it.
+    // Runtime: That of push(val).
+    void push(const TYPE &val, std::size_t shard)
+    {
+        shard %= shards.size();
+        Shard &target = *shards[shard];
+        {
+            std::lock_guard<SpinLock> guard{ target.lock };
+            if (target.heap.empty() || compare(target.heap.top(), val))
+                target.stale = true;
+            target.heap.push(val);
+            if (!target.stale)
+                return;
+        }
+
+        std::lock_guard<std::mutex> guard{ lock };
+        std::lock_guard<SpinLock> shardGuard{ target.lock };
+        if (!target.stale)
+            return;
+        tournament.setLeaf(shard, target.heap.top());
+        target.stale = false;
+        tournament.build();
+    } // push()
+
+
+    // Description: Remove the most extreme element of all shards and copy
+    //              it into out.
+    // Runtime: Amortized O(log(n)) plus O(log(nodes)), plus the wait for
+    //          the mutex.
+    // Returns: false, leaving out alone, if the queue is empty
+    bool try_pop(TYPE &out)
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        if (tournament.empty())
+            return false;
+
+        Shard &winner = *shards[tournament.topIndex()];
+        std::lock_guard<SpinLock> shardGuard{ winner.lock };
+        out = winner.heap.top();
+        winner.heap.pop();
+        if (winner.heap.empty())
+            tournament.exhaustTop();
+        else
+            tournament.replace_top(winner.heap.top());
+        winner.stale = false;
+        return true;
+    } // try_pop()
+
+
+    // Description: Copy the most extreme element into out, without
+    //              removing it.
+    // Runtime: O(1), plus the wait for the mutex.
+    // Returns: false, leaving out alone, if the queue is empty
+    bool try_top(TYPE &out)
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        if (tournament.empty())
+            return false;
+
+        // the shard's top may be newer than the tournament's copy
+        Shard &winner = *shards[tournament.topIndex()];
+        std::lock_guard<SpinLock> shardGuard{ winner.lock };
+        out = winner.heap.top();
+        return true;
+    } // try_top()
+
+
+    // Description: Get the number of elements. Other threads may change it
+    //              before the caller looks at it.
+    // Runtime: O(nodes)
+    std::size_t size() const
+    {
+        std::size_t n = 0;
+        for (const std::unique_ptr<Shard> &shard : shards)
+        {
+            std::lock_guard<SpinLock> guard{ shard->lock };
+            n += shard->heap.size();
+        } // for
+        return n;
+    } // size()
+
+
+    // Description: Return true if the queue is empty, as of the call.
+    // Runtime: O(nodes)
+    bool empty() const
+    {
+        return size() == 0;
+    } // empty()
+
+
+    // Description: The number of shards, one per node.
+    // Runtime: O(1)
+    std::size_t shard_count() const
+    {
+        return shards.size();
+    } // shard_count()
+
+
+    // Description: The number of elements in one shard.
+    // Runtime: O(1), plus the wait for its lock.
+    std::size_t shard_size(std::size_t shard) const
+    {
+        std::lock_guard<SpinLock> guard{ shards[shard]->lock };
+        return shards[shard]->heap.size();
+    } // shard_size()
+
+
+    // Description: Return true if every shard's arena is bound to its node
+    //              with mbind(), false if any fell back to first touch.
+    // Runtime: O(nodes)
+    bool bound() const
+    {
+        for (const std::unique_ptr<Shard> &shard : shards)
+        {
+            std::lock_guard<SpinLock> guard{ shard->lock };
+            if (!shard->arena.bound())
+                return false;
+        } // for
+        return true;
+    } // bound()
+
+
+    // Description: The topology the shards follow.
+    // Runtime: O(1)
+    const NumaTopology &topology() const
+    {
+        return layout;
+    } // topology()
+
+
+    // Description: The shard of the node the calling thread runs on; by
+    //              thread number with a simulated topology, or where the
+    //              CPU is unknown.
+    // Runtime: O(CPUs)
+    std::size_t currentShard() const
+    {
+#if defined(__linux__)
+        if (!layout.simulated)
+        {
+            const int cpu = ::sched_getcpu();
+            if (cpu >= 0)
+                return layout.nodeOfCpu(cpu);
+        } // if
+#endif
+        return threadIndex() % shards.size();
+    } // currentShard()
+
+
+private:
+
+    using Heap = PairingPQ<TYPE, COMP_FUNCTOR, false, 0, ArenaAllocator<TYPE>>;
+
+    // A node's shard, on a cache line of its own. The arena comes first,
+    // so that it outlives the heap's nodes. stale is set while the heap
+    // has a better top than the tournament's copy.
+    struct alignas(64) Shard
+    {
+        mutable SpinLock lock;
+        NodeArena arena;
+        Heap heap;
+        bool stale = false;
+
+        Shard(int numaNode, const COMP_FUNCTOR &comp)
+            : arena{ numaNode }, heap{ comp, ArenaAllocator<TYPE>{ &arena } }
+        {} // Shard
+    }; // Shard
+
+    COMP_FUNCTOR compare;
+    NumaTopology layout;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    // guards the tournament over the shard tops
+    std::mutex lock;
+    LoserTree<TYPE, COMP_FUNCTOR> tournament;
+
+
+    // Description: A number for the calling thread, counting up from 0 in
+    //              the order threads first ask.
+    // Runtime: O(1)
+    static std::size_t threadIndex()
+    {
+        static std::atomic<std::size_t> next{ 0 };
+        thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    } // threadIndex()
+
+
+}; // NumaShardedPQ
+
+#endif // NUMASHARDEDPQ_H
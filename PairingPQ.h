@@ -2,18 +2,39 @@
 #define PAIRINGPQ_H
 
 #include "Eecs281PQ.h"
+#include "Parallel.h"
+#include "TieBreak.h"
+#include <algorithm>
+#include <array>
 #include <deque>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include <iostream>
 
 using namespace std;
 
 // A specialized version of the 'priority queue' ADT implemented as a pairing heap.
-template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+// With STABLE = true, elements of equal priority come out in FIFO order.
+// With INLINE > 0, the first INLINE nodes come from a slab inside the object
+// and are recycled through a free list, so a heap that never holds more than
+// that never allocates. Node pointers stay valid as long as the heap lives.
+// Other nodes come from ALLOCATOR, rebound to Node, such as an ArenaAllocator
+// that keeps a heap's nodes together in memory of its own.
+template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+         bool STABLE = false, std::size_t INLINE = 0,
+         typename ALLOCATOR = std::allocator<TYPE>>
 class PairingPQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
 {
     // This is a way to refer to the base class object.
     using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
+
+    // Tie-break policy, and what each node stores.
+    using Ties = TieBreak<TYPE, COMP_FUNCTOR, STABLE>;
+    using Slot = typename Ties::Slot;
     
 public:
     
@@ -24,7 +45,7 @@ public:
     public:
         
         // Node ctor
-        explicit Node(const TYPE &val)
+        explicit Node(const Slot &val)
         : elt{ val }, child{ nullptr }, sibling{ nullptr }, parent{ nullptr }
         {}
         
@@ -32,8 +53,8 @@ public:
         // There are two versions, getElt() and a dereference operator, use
         // whichever one seems more natural to you.
         // Runtime: O(1).
-        const TYPE &getElt() const { return elt; }
-        const TYPE &operator*() const { return elt; }
+        const TYPE &getElt() const { return Ties::elt(elt); }
+        const TYPE &operator*() const { return Ties::elt(elt); }
         
         // To access any private data members of this Node class 
         // from within the PairingPQ class. (ie: myNode.elt is a legal
@@ -43,7 +64,7 @@ public:
 
     private:
 
-        TYPE elt;
+        Slot elt;
         Node *child;
         Node *sibling;
         Node *parent;
@@ -58,6 +79,14 @@ public:
     {} // PairingPQ()
     
     
+    // Description: Construct an empty pairing heap whose nodes come from
+    //              alloc.
+    // Runtime: O(1)
+    PairingPQ(COMP_FUNCTOR comp, const ALLOCATOR &alloc) :
+    BaseClass{ comp }, root{ nullptr }, numNodes{ 0 }, nodeAlloc{ alloc }
+    {} // PairingPQ()
+    
+    
     // Description: Construct a pairing heap out of an iterator range with an optional
     //              comparison functor.
     // Runtime: O(n) where n is number of elements in range.
@@ -78,11 +107,13 @@ public:
     // Description: Copy constructor.
     // Runtime: O(n)
     PairingPQ(const PairingPQ &other) :
-    BaseClass{ other.compare }, root{ nullptr }, numNodes{ 0 }
+    BaseClass{ other.compare }, root{ nullptr }, numNodes{ 0 }, ties{ other.ties },
+    nodeAlloc{ NodeTraits::select_on_container_copy_construction(other.nodeAlloc) }
     {
         // make a deque and insert root to other
         std::deque<Node*> dq;
-        dq.push_back(other.root);
+        if (other.root)
+            dq.push_back(other.root);
         
         while (!dq.empty())
         {
@@ -90,8 +121,9 @@ public:
             Node *ptr = traversalHelper(dq);
             
             // I now have the current node's child and sibling in the deck
-            // waiting to get pushed. I push the current node first.
-            push(ptr->elt);
+            // waiting to get pushed. I push the current node first, keeping
+            // its slot so stable mode keeps its place in line.
+            addSlot(ptr->elt);
         }
         
     } // PairingPQ()
@@ -103,12 +135,29 @@ public:
     {
         // copy-swap method (idiot check not needed from now on)
         
-        // use copy ctor to create a copy of the refrenced object on rhs
-        PairingPQ temp(rhs);
-        
-        // begin swapping the current objects (lhs) members with the copy's members
-        std::swap(temp.numNodes, numNodes);
-        std::swap(temp.root, root);
+        if constexpr (INLINE == 0)
+        {
+            // use copy ctor to create a copy of the refrenced object on rhs
+            PairingPQ temp(rhs);
+
+            // begin swapping the current objects (lhs) members with the copy's members
+            // (the nodes go with the allocator they came from)
+            std::swap(temp.numNodes, numNodes);
+            std::swap(temp.root, root);
+            std::swap(temp.ties, ties);
+            std::swap(temp.nodeAlloc, nodeAlloc);
+        }
+        else if (this != &rhs)
+        {
+            // inline nodes cannot change owner, so copy node by node
+            destroyNodes();
+            ties = rhs.ties;
+            std::deque<Node*> dq;
+            if (rhs.root)
+                dq.push_back(rhs.root);
+            while (!dq.empty())
+                addSlot(traversalHelper(dq)->elt);
+        }
         
         return *this;
         
@@ -141,24 +190,7 @@ public:
     // OG Refactored: Abstracted any code duplication
     ~PairingPQ()
     {
-        // make a deque and insert root
-        std::deque<Node*> dq;
-        
-        if (!root)
-            return;
-        
-        dq.push_back(root);
-        
-        while (!dq.empty())
-        {
-            // get the next element
-            Node *ptr = traversalHelper(dq);
-            
-            // delete the current node
-            delete ptr;
-        }
-        
-        numNodes = 0;
+        destroyNodes();
         
     } // ~PairingPQ()
 
@@ -173,6 +205,9 @@ public:
     // OG Refactored: abstracted any code duplication
     virtual void updatePriorities()
     {
+        if (!root || !root->child)
+            return;
+        
         // create an aux deck
         std::deque<Node*> dq;
         dq.push_back(root->child);
@@ -184,9 +219,10 @@ public:
             // get a starting point
             Node *ptr = traversalHelper(dq);
             
-            // severe the relationship
+            // severe the relationship; the child and sibling are in the
+            // deck already, and get melded in on their own
             ptr->parent = nullptr;
-            //ptr->child = nullptr;
+            ptr->child = nullptr;
             ptr->sibling = nullptr;
             
             // now were ready to meld
@@ -206,7 +242,28 @@ public:
     {
         addNode(val);
     } // push()
-    
+
+
+    // Description: Move every element of other into this heap, leaving other
+    //              empty. No node is copied, so Node pointers into other now
+    //              point into this heap. Both heaps must compare alike, and
+    //              their allocators must compare equal.
+    // Runtime: O(1)
+    void meld(PairingPQ &other)
+    {
+        // inline nodes cannot change owner, and sequence numbers from two
+        // heaps say nothing about which push came first
+        static_assert(INLINE == 0 && !STABLE, "meld() needs heap-allocated, unstable nodes");
+
+        if (this == &other || !other.root)
+            return;
+        root = root ? meld(other.root, root) : other.root;
+        numNodes += other.numNodes;
+        other.root = nullptr;
+        other.numNodes = 0;
+
+    } // meld()
+
     
     // Description: Remove the most extreme (defined by 'compare') element from
     //              the pairing heap.
@@ -223,58 +280,80 @@ public:
         root->child = nullptr;
         
         // pop the root
-        delete root;
+        freeNode(root);
         numNodes--;
         
-        // two cases: empty and not empty
-        if (!temp)
-        {
-            // update the root
-            root = nullptr;
-        }
-        else if (size() == 1)
-        {
-            temp->parent = nullptr;
-            root = temp;
-        }
-        // not empty case
-        else
-        {
-            // create a deque of pointers
-            std::deque<Node*> dq;
+        // the root's children become the new heap
+        root = temp ? combineSiblings(temp) : nullptr;
+        
+    } // pop()
+    
+    
+    // Description: Remove the k most extreme elements (all of them if there
+    //              are fewer) and return them, most extreme first. Long
+    //              lists of children are melded on several threads.
+    // Runtime: Amortized O(k log(n))
+    std::vector<TYPE> pop_batch(std::size_t k)
+    {
+        return pop_batch(k, parallel::threadsFor(size()));
+        
+    } // pop_batch()
+    
+    
+    // Description: pop_batch(k) on up to 'threads' threads. Each pop melds
+    //              the root's children by multi-pass pairing as pop() does,
+    //              but from one reused array instead of a deque per pop. A
+    //              list of at least BATCH_SPLIT_MIN children per thread is
+    //              split into one slice per thread; each thread melds its
+    //              own slice, whose subtrees no other thread touches, and
+    //              the slices' roots are melded last.
+    // Runtime: Amortized O(k log(n)), less the share of long child lists
+    //          melded in parallel.
+    std::vector<TYPE> pop_batch(std::size_t k, std::size_t threads)
+    {
+        std::vector<TYPE> best;
+        best.reserve(std::min(k, size()));
+        std::vector<Node*> children;
         
-            // fill it with the remaining heap
-            while (temp)
+        while (best.size() < k && root)
+        {
+            best.push_back(top());
+            
+            // detach the children, as combineSiblings() would
+            children.clear();
+            for (Node *child = root->child; child;)
             {
-                dq.push_back(temp);
-                temp = temp->sibling;
+                Node *next = child->sibling;
+                child->parent = nullptr;
+                child->sibling = nullptr;
+                children.push_back(child);
+                child = next;
             }
+            root->child = nullptr;
+            freeNode(root);
+            numNodes--;
             
-            // we now perform a multi-pass on the dq
-            while (dq.size() != 1)
+            if (children.empty())
             {
-                size_t index = 0;
-                
-                // break the sibling parent relation
-                dq[index]->parent = nullptr;
-                dq[index]->sibling = nullptr;
-                dq[index + 1]->parent = nullptr;
-                dq[index + 1]->sibling = nullptr;
-                
-                // meld two elements and push them to back
-               dq.push_back(meld(dq[index], dq[index + 1]));
-                    
-                // pop the ones that were just melded
-                dq.pop_front();
-                dq.pop_front();
+                root = nullptr;
+                continue;
             }
             
-            // heap restored
-            root = dq.front();
-            dq.pop_front();
+            // each slice's root ends up first in its slice
+            const std::size_t slices = children.size() >= BATCH_SPLIT_MIN * threads ? threads : 1;
+            parallel::run(slices, [&](std::size_t t)
+            {
+                const std::size_t first = children.size() * t / slices;
+                multipass(children.data() + first, children.size() * (t + 1) / slices - first);
+            });
+            for (std::size_t t = 1; t < slices; ++t)
+                children[t] = children[children.size() * t / slices];
+            root = multipass(children.data(), slices);
         }
         
-    } // pop()
+        return best;
+        
+    } // pop_batch()
     
     
     // Description: Return the most extreme (defined by 'compare') element of
@@ -284,7 +363,7 @@ public:
     // Runtime: O(1)
     virtual const TYPE &top() const
     {
-        return root->elt;
+        return Ties::elt(root->elt);
         
     } // top()
     
@@ -319,10 +398,11 @@ public:
     void updateElt(Node* node, const TYPE &new_value)
     {
         // check for precondition
-        if (this->compare(node->elt, new_value))
+        if (this->compare(Ties::elt(node->elt), new_value))
         {
-            // update elt
-            node->elt = new_value;
+            // update elt (in stable mode it also goes to the back of the
+            // line among equal priorities, like a repriced order)
+            node->elt = ties.wrap(new_value);
             
             // three main cases:
             // 1. node = root,
@@ -337,44 +417,39 @@ public:
                 // if the val is less than my parent, then no work needed
                 
                 // if val is greater, then need to correct the heap
-                if (this->compare(node->parent->elt, new_value))
+                if (isLower(node->parent->elt, node->elt))
                 {
-                    // store the parent before i sever link
-                    Node *temp1 = node->parent;
-                    
-                    // check if I am leftmost
-                    if (node->parent->child == node)
-                    {
-                        // give the old root a new child, which is leftmost's sibling
-                        node->parent->child = node->sibling;
-                    }
-                    // check for prev, sibling, and parent, then sever 3 links
-                    else
-                    {
-                        // start at leftmost
-                        Node *temp2 = node->parent->child;
-                        
-                        // traverse until one before node
-                        while (temp2->sibling != node)
-                        {
-                            temp2 = temp2->sibling;
-                        }
-                        
-                        // extend the link past me
-                        temp2->sibling = node->sibling;
-                    }
-                    
-                    // sever sibling and parent links
-                    node->parent = nullptr;
-                    node->sibling = nullptr;
-                    
+                    cut(node);
                     root = meld(root, node);
-                    
                 }
             }
         }
         
     } // updateElt()
+
+
+    // Description: Remove the element refered to by node, which must be in
+    //              this heap, and destroy the node. Its children are paired
+    //              up as in pop() and melded back in.
+    // Runtime: Amortized O(log(n)), plus O(siblings) to find node's place.
+    void erase(Node *node)
+    {
+        if (node == root)
+        {
+            pop();
+            return;
+        }
+
+        cut(node);
+        Node *children = node->child;
+        node->child = nullptr;
+        freeNode(node);
+        numNodes--;
+
+        if (children)
+            root = meld(combineSiblings(children), root);
+
+    } // erase()
     
     
     // Description: Add a new element to the pairing heap. Returns a Node* corresponding
@@ -386,8 +461,19 @@ public:
     //       updatePriorities().
     Node* addNode(const TYPE &val)
     {
-        // use the new keyword here to create the new node
-        Node *newNode = new Node{ val };
+        return addSlot(ties.wrap(val));
+    } // addNode()
+    
+    
+private:
+    
+    // Description: addNode() for an already wrapped element; the copy
+    //              constructor uses it to keep each element's slot.
+    // Runtime: O(1)
+    Node* addSlot(const Slot &val)
+    {
+        // get the new node from the slab, or with the new keyword
+        Node *newNode = makeNode(val);
         
         // we have two cases: empty and size > 0
         
@@ -399,19 +485,17 @@ public:
         
         numNodes++;
         
-        return root;
+        return newNode;
         
-    } // addNode()
+    } // addSlot()
     
     
-private:
-    
     // Links two non null heaps: root a and root b (b is always the curr root)
     // these roots must not have a parent or siblings.
     Node* meld(Node *a, Node *b)
     {
         // get extreme
-        if (this->compare(b->elt, a->elt))
+        if (isLower(b->elt, a->elt))
         {
             // give b a new parent and sibling
             b->parent = a;
@@ -435,11 +519,220 @@ private:
         return b;
         
     } // meld()
+
+
+    // Description: Detach node, with its subtree, from its parent's list of
+    //              children. node must not be the root.
+    // Runtime: O(siblings before node)
+    void cut(Node *node)
+    {
+        // check if I am leftmost
+        if (node->parent->child == node)
+        {
+            // give the parent a new child, which is leftmost's sibling
+            node->parent->child = node->sibling;
+        }
+        // check for prev, sibling, and parent, then sever 3 links
+        else
+        {
+            // start at leftmost
+            Node *temp2 = node->parent->child;
+            
+            // traverse until one before node
+            while (temp2->sibling != node)
+            {
+                temp2 = temp2->sibling;
+            }
+            
+            // extend the link past me
+            temp2->sibling = node->sibling;
+        }
+        
+        // sever sibling and parent links
+        node->parent = nullptr;
+        node->sibling = nullptr;
+        
+    } // cut()
+
+
+    // Description: Meld a list of siblings, starting at first, into one
+    //              heap by multi-pass pairing, and return its root.
+    // Runtime: O(siblings)
+    Node *combineSiblings(Node *first)
+    {
+        if (!first->sibling)
+        {
+            first->parent = nullptr;
+            return first;
+        }
+        
+        // create a deque of pointers
+        std::deque<Node*> dq;
+    
+        // fill it with the siblings
+        while (first)
+        {
+            dq.push_back(first);
+            first = first->sibling;
+        }
+        
+        // we now perform a multi-pass on the dq
+        while (dq.size() != 1)
+        {
+            size_t index = 0;
+            
+            // break the sibling parent relation
+            dq[index]->parent = nullptr;
+            dq[index]->sibling = nullptr;
+            dq[index + 1]->parent = nullptr;
+            dq[index + 1]->sibling = nullptr;
+            
+            // meld two elements and push them to back
+            dq.push_back(meld(dq[index], dq[index + 1]));
+                
+            // pop the ones that were just melded
+            dq.pop_front();
+            dq.pop_front();
+        }
+        
+        return dq.front();
+        
+    } // combineSiblings()
+    
+    
+    // Description: Meld count parentless, siblingless roots, starting at
+    //              first, by multi-pass pairing: neighbours are melded
+    //              pairwise, round after round. Returns the root, which is
+    //              also left in *first.
+    // Runtime: O(count)
+    Node *multipass(Node **first, std::size_t count)
+    {
+        while (count > 1)
+        {
+            std::size_t melded = 0;
+            for (std::size_t i = 0; i + 1 < count; i += 2)
+                first[melded++] = meld(first[i], first[i + 1]);
+            if (count % 2 == 1)
+                first[melded++] = first[count - 1];
+            count = melded;
+        }
+        
+        return first[0];
+        
+    } // multipass()
+    
+    
+    // Is a lower priority than b? Plain this->compare unless STABLE,
+    // in which case ties go to the element pushed first.
+    bool isLower(const Slot &a, const Slot &b) const
+    {
+        return Ties::lower(this->compare, a, b);
+    } // isLower()
+    
+    
+    // Description: Destroy every node, leaving an empty heap.
+    // Runtime: O(n)
+    void destroyNodes()
+    {
+        // make a deque and insert root
+        std::deque<Node*> dq;
+        
+        if (!root)
+            return;
+        
+        dq.push_back(root);
+        
+        while (!dq.empty())
+        {
+            // get the next element
+            Node *ptr = traversalHelper(dq);
+            
+            // delete the current node
+            freeNode(ptr);
+        }
+        
+        root = nullptr;
+        numNodes = 0;
+        
+    } // destroyNodes()
+    
+    
+    // One slot of the inline slab: a node while in use, a free list link
+    // otherwise.
+    union SlabEntry
+    {
+        SlabEntry *next;
+        alignas(Node) unsigned char node[sizeof(Node)];
+    };
+    
+    struct NoSlab {};
+    using Slab = std::conditional_t<INLINE == 0, NoSlab, std::array<SlabEntry, INLINE>>;
+    
+    
+    // Description: A new node holding val, from the slab while it has room.
+    // Runtime: O(1)
+    Node *makeNode(const Slot &val)
+    {
+        if constexpr (INLINE > 0)
+        {
+            SlabEntry *entry = freeSlots;
+            if (entry)
+                freeSlots = entry->next;
+            else if (slabUsed < INLINE)
+                entry = &slab[slabUsed++];
+            if (entry)
+                return ::new (static_cast<void *>(entry->node)) Node{ val };
+        }
+        Node *node = NodeTraits::allocate(nodeAlloc, 1);
+        NodeTraits::construct(nodeAlloc, node, val);
+        return node;
+        
+    } // makeNode()
+    
+    
+    // Description: Destroy a node, returning slab nodes to the free list.
+    // Runtime: O(1)
+    void freeNode(Node *node)
+    {
+        if constexpr (INLINE > 0)
+        {
+            auto *entry = reinterpret_cast<SlabEntry *>(node);
+            std::less<const SlabEntry *> before;
+            if (!before(entry, slab.data()) && before(entry, slab.data() + INLINE))
+            {
+                node->~Node();
+                entry->next = freeSlots;
+                freeSlots = entry;
+                return;
+            }
+        }
+        NodeTraits::destroy(nodeAlloc, node);
+        NodeTraits::deallocate(nodeAlloc, node, 1);
+        
+    } // freeNode()
+    
+    // pop_batch() splits lists of children across threads only with at
+    // least this many per thread
+    static constexpr std::size_t BATCH_SPLIT_MIN = 8192;
     
     // root of heap and size
     Node *root;
     size_t numNodes;
     
+    // Hands out sequence numbers in stable mode; empty otherwise.
+    [[no_unique_address]] Ties ties;
+    
+    // where nodes outside the slab come from
+    using NodeAlloc = typename std::allocator_traits<ALLOCATOR>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAlloc>;
+    [[no_unique_address]] NodeAlloc nodeAlloc;
+    
+    // inline nodes: the slab, how many of its slots have ever been used,
+    // and the used slots that are free again
+    [[no_unique_address]] Slab slab;
+    std::size_t slabUsed = 0;
+    SlabEntry *freeSlots = nullptr;
+    
 };
 
 #endif // PAIRINGPQ_H
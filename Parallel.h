@@ -0,0 +1,64 @@
+//  Parallel.h
+//  p2b-priority-queues
+//
+
+/*
+
+    The thread fan-out behind the parallel rebuilds and scans: BinaryPQ's
+    heapify and SortedPQ's full sort in updatePriorities(), and the argmax
+    scans of the unordered PQs.
+
+    threadsFor() decides how many threads a job over n elements is worth:
+    one below PARALLEL_THRESHOLD elements, where a job fits in cache and
+    starting threads would cost more than it saves, otherwise up to the
+    number of hardware threads. run() then calls a job once per thread
+    index, on fresh threads plus the calling one, and returns when all are
+    done. Jobs must touch disjoint elements.
+
+*/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace parallel
+{
+
+// Jobs over at least this many elements are split across threads.
+constexpr std::size_t PARALLEL_THRESHOLD = std::size_t{1} << 18;
+
+
+// Description: How many threads a job over n elements should use.
+// Runtime: O(1)
+inline std::size_t threadsFor(std::size_t n)
+{
+    if (n < PARALLEL_THRESHOLD)
+        return 1;
+
+    // asking the OS for the core count is a system call, so ask once
+    static const std::size_t cores = std::thread::hardware_concurrency();
+    return std::max(std::size_t{1}, std::min(cores, n / (PARALLEL_THRESHOLD / 2)));
+} // threadsFor()
+
+
+// Description: Call job(t) for every t in [0, threads), each on its own
+//              thread; this thread takes t = 0.
+// Runtime: That of the slowest job, plus starting threads - 1 threads.
+template <typename JOB>
+void run(std::size_t threads, const JOB &job)
+{
+    std::vector<std::thread> workers;
+    for (std::size_t t = 1; t < threads; ++t)
+        workers.emplace_back([&job, t]() { job(t); });
+    job(0);
+    for (std::thread &worker : workers)
+        worker.join();
+} // run()
+
+} // namespace parallel
+
+#endif // PARALLEL_H
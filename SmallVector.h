@@ -0,0 +1,364 @@
+//  SmallVector.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A vector whose first N elements live inside the object itself. Only
+    when it grows past N does it move everything to a heap block, which then
+    grows like a std::vector.
+
+    A priority queue that never holds more than N elements therefore never
+    allocates, and its elements sit in the same cache lines as the rest of
+    the queue object. The price is N elements of space in every object,
+    used or not.
+
+    It offers the subset of the std::vector interface the priority queues
+    use, with plain pointers as iterators. Like a std::vector, any growth
+    invalidates them. Moving a SmallVector that has not spilled moves its
+    elements one by one, since they cannot change owner.
+
+    InlineStorage<TYPE, N> is std::vector<TYPE> for N == 0 and
+    SmallVector<TYPE, N> otherwise, so a queue can take N as a template
+    parameter and keep its old layout by default.
+
+*/
+
+#ifndef SMALLVECTOR_H
+#define SMALLVECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename TYPE, std::size_t N>
+class SmallVector
+{
+    static_assert(N > 0, "use std::vector for no inline capacity");
+
+public:
+
+    using value_type = TYPE;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = TYPE &;
+    using const_reference = const TYPE &;
+    using pointer = TYPE *;
+    using const_pointer = const TYPE *;
+    using iterator = TYPE *;
+    using const_iterator = const TYPE *;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+
+    // Description: Construct an empty vector, using the inline slots.
+    // Runtime: O(1)
+    SmallVector() = default;
+
+
+    // Description: Construct a vector holding a copy of a range.
+    // Runtime: O(n)
+    template <typename InputIterator,
+              typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    SmallVector(InputIterator from, InputIterator to)
+    {
+        assign(from, to);
+    } // SmallVector()
+
+
+    // Description: Copy constructor.
+    // Runtime: O(n)
+    SmallVector(const SmallVector &other)
+    {
+        assign(other.begin(), other.end());
+    } // SmallVector()
+
+
+    // Description: Move constructor. Steals a heap block, otherwise moves
+    //              the inline elements.
+    // Runtime: O(1) if other has spilled, O(N) otherwise
+    SmallVector(SmallVector &&other) noexcept(std::is_nothrow_move_constructible_v<TYPE>)
+    {
+        steal(other);
+    } // SmallVector()
+
+
+    // Description: Copy assignment operator.
+    // Runtime: O(n)
+    SmallVector &operator=(const SmallVector &rhs)
+    {
+        if (this != &rhs)
+            assign(rhs.begin(), rhs.end());
+        return *this;
+    } // operator=()
+
+
+    // Description: Move assignment operator.
+    // Runtime: O(n) to destroy the old elements
+    SmallVector &operator=(SmallVector &&rhs) noexcept(std::is_nothrow_move_constructible_v<TYPE>)
+    {
+        if (this != &rhs)
+        {
+            release();
+            steal(rhs);
+        } // if
+        return *this;
+    } // operator=()
+
+
+    // Description: Destroy the elements and free a heap block.
+    // Runtime: O(n)
+    ~SmallVector()
+    {
+        release();
+    } // ~SmallVector()
+
+
+    // Element access; i must be less than size().
+    TYPE &operator[](std::size_t i) { return first[i]; }
+    const TYPE &operator[](std::size_t i) const { return first[i]; }
+    TYPE &front() { return first[0]; }
+    const TYPE &front() const { return first[0]; }
+    TYPE &back() { return first[count - 1]; }
+    const TYPE &back() const { return first[count - 1]; }
+    TYPE *data() { return first; }
+    const TYPE *data() const { return first; }
+
+    // Iterators.
+    iterator begin() { return first; }
+    iterator end() { return first + count; }
+    const_iterator begin() const { return first; }
+    const_iterator end() const { return first + count; }
+    const_iterator cbegin() const { return first; }
+    const_iterator cend() const { return first + count; }
+    reverse_iterator rbegin() { return reverse_iterator{ end() }; }
+    reverse_iterator rend() { return reverse_iterator{ begin() }; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator{ end() }; }
+    const_reverse_iterator rend() const { return const_reverse_iterator{ begin() }; }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+    // Size and capacity.
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    std::size_t capacity() const { return cap; }
+
+    // Description: Are the elements still in the inline slots?
+    // Runtime: O(1)
+    bool is_inline() const { return first == slots(); }
+
+
+    // Description: Make room for at least n elements.
+    // Runtime: O(n) if it has to move, O(1) otherwise
+    void reserve(std::size_t n)
+    {
+        if (n > cap)
+            relocate(n);
+    } // reserve()
+
+
+    // Description: Append an element.
+    // Runtime: Amortized O(1)
+    void push_back(const TYPE &val)
+    {
+        emplace_back(val);
+    } // push_back()
+
+    void push_back(TYPE &&val)
+    {
+        emplace_back(std::move(val));
+    } // push_back()
+
+
+    // Description: Construct an element at the end.
+    // Runtime: Amortized O(1)
+    template <typename... Args>
+    TYPE &emplace_back(Args &&...args)
+    {
+        if (count == cap)
+        {
+            // val may live in this vector, so build it before moving house;
+            // cap is never below N, the max only shows the compiler that
+            // the new block is not empty
+            TYPE val(std::forward<Args>(args)...);
+            relocate(std::max(2 * cap, 2 * N));
+            ::new (static_cast<void *>(first + count)) TYPE(std::move(val));
+        } // if
+        else
+            ::new (static_cast<void *>(first + count)) TYPE(std::forward<Args>(args)...);
+        return first[count++];
+    } // emplace_back()
+
+
+    // Description: Remove the last element.
+    // Runtime: O(1)
+    void pop_back()
+    {
+        first[--count].~TYPE();
+    } // pop_back()
+
+
+    // Description: Insert val before pos.
+    // Runtime: O(n)
+    iterator insert(const_iterator pos, const TYPE &val)
+    {
+        std::size_t index = static_cast<std::size_t>(pos - first);
+        emplace_back(val);
+        std::rotate(first + index, first + count - 1, first + count);
+        return first + index;
+    } // insert()
+
+
+    // Description: Insert the range [from, to) before pos.
+    // Runtime: O(n + m) for m new elements
+    template <typename InputIterator>
+    iterator insert(const_iterator pos, InputIterator from, InputIterator to)
+    {
+        std::size_t index = static_cast<std::size_t>(pos - first);
+        std::size_t old = count;
+        for (; from != to; ++from)
+            emplace_back(*from);
+        std::rotate(first + index, first + old, first + count);
+        return first + index;
+    } // insert()
+
+
+    // Description: Remove the element at pos.
+    // Runtime: O(n)
+    iterator erase(const_iterator pos)
+    {
+        iterator at = first + (pos - first);
+        std::move(at + 1, end(), at);
+        pop_back();
+        return at;
+    } // erase()
+
+
+    // Description: Replace the contents with n copies of val.
+    // Runtime: O(n)
+    void assign(std::size_t n, const TYPE &val)
+    {
+        TYPE copy(val);
+        clear();
+        reserve(n);
+        while (count < n)
+            emplace_back(copy);
+    } // assign()
+
+
+    // Description: Replace the contents with a copy of [from, to).
+    // Runtime: O(n)
+    template <typename InputIterator,
+              typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    void assign(InputIterator from, InputIterator to)
+    {
+        clear();
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                      typename std::iterator_traits<InputIterator>::iterator_category>)
+            reserve(static_cast<std::size_t>(std::distance(from, to)));
+        for (; from != to; ++from)
+            emplace_back(*from);
+    } // assign()
+
+
+    // Description: Destroy every element, keeping the capacity.
+    // Runtime: O(n)
+    void clear()
+    {
+        std::destroy(first, first + count);
+        count = 0;
+    } // clear()
+
+
+    // Description: Exchange contents with other.
+    // Runtime: O(1) if both have spilled, O(N) otherwise
+    void swap(SmallVector &other)
+    {
+        if (!is_inline() && !other.is_inline())
+        {
+            std::swap(first, other.first);
+            std::swap(count, other.count);
+            std::swap(cap, other.cap);
+            return;
+        } // if
+        SmallVector temp{ std::move(other) };
+        other = std::move(*this);
+        *this = std::move(temp);
+    } // swap()
+
+
+private:
+
+    // the elements, inline or on the heap, and how many there are
+    TYPE *first = slots();
+    std::size_t count = 0;
+    std::size_t cap = N;
+
+    // raw inline slots; only the first 'count' hold live elements while
+    // the vector has not spilled
+    alignas(TYPE) unsigned char storage[N * sizeof(TYPE)];
+
+
+    TYPE *slots() { return reinterpret_cast<TYPE *>(storage); }
+    const TYPE *slots() const { return reinterpret_cast<const TYPE *>(storage); }
+
+
+    // Description: Move the elements to a heap block of n slots.
+    // Runtime: O(size())
+    void relocate(std::size_t n)
+    {
+        TYPE *block = std::allocator<TYPE>{}.allocate(n);
+        std::uninitialized_move(first, first + count, block);
+        std::destroy(first, first + count);
+        if (!is_inline())
+            std::allocator<TYPE>{}.deallocate(first, cap);
+        first = block;
+        cap = n;
+    } // relocate()
+
+
+    // Description: Destroy the elements and free a heap block, leaving an
+    //              empty vector on the inline slots.
+    // Runtime: O(size())
+    void release()
+    {
+        clear();
+        if (!is_inline())
+            std::allocator<TYPE>{}.deallocate(first, cap);
+        first = slots();
+        cap = N;
+    } // release()
+
+
+    // Description: Take over other's elements, leaving it empty. This
+    //              vector must be empty and on its inline slots.
+    // Runtime: O(1) if other has spilled, O(N) otherwise
+    void steal(SmallVector &other)
+    {
+        if (other.is_inline())
+        {
+            std::uninitialized_move(other.first, other.first + other.count, first);
+            count = other.count;
+            other.clear();
+            return;
+        } // if
+        first = other.first;
+        count = other.count;
+        cap = other.cap;
+        other.first = other.slots();
+        other.count = 0;
+        other.cap = N;
+    } // steal()
+}; // SmallVector
+
+
+// std::vector for no inline capacity, SmallVector otherwise.
+template <typename TYPE, std::size_t N>
+using InlineStorage = std::conditional_t<N == 0, std::vector<TYPE>, SmallVector<TYPE, N>>;
+
+#endif // SMALLVECTOR_H
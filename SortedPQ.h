@@ -2,8 +2,14 @@
 #define SORTEDPQ_H
 
 #include "Eecs281PQ.h"
+#include "Parallel.h"
+#include "SearchKernel.h"
+#include "SmallVector.h"
 #include <algorithm>
+#include <cassert>
 #include <iostream>
+#include <iterator>
+#include <ranges>
 
 // A specialized version of the 'heap' ADT that is implemented with an
 // underlying sorted array-based container.
@@ -11,29 +17,63 @@
 // Note: The most extreme element should be found at the end of the
 // 'data' container, such that traversing the iterators yields the elements in
 // sorted order.
-template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+
+// Pushes are not inserted right away: they are appended to a small unsorted
+// side buffer whose most extreme element is tracked, and the buffer is
+// sorted and merged into 'data' in one pass only when pop() needs an element
+// that is in it (or updatePriorities() runs). Pushes that are never popped
+// before the next rebuild therefore never pay for an O(n) insert.
+
+// With STABLE = true, elements of equal priority come out in FIFO order. No
+// sequence numbers are needed: everything in the buffer is newer than
+// everything in 'data', ties between the two go to 'data', and the merge
+// puts buffered elements in front of their equals, i.e. behind them in pop
+// order. Since the order of equals is their position in 'data', not a
+// stamp, updatePriorities() (a stable sort) orders elements that became
+// equal by where their old priorities put them, not by when they were
+// pushed. The queues with sequence numbers (BinaryPQ, PairingPQ,
+// UnorderedPQ, UnorderedFastPQ) go by push order there, too.
+
+// The const views (iterators, top_n, rank, select, count_between) read
+// straight out of 'data' and never modify the PQ, so any number of threads
+// may use them at once. They need the buffer to be empty: after a push(),
+// call sorted_view(), which merges the buffer and returns a const reference
+// to the PQ.
+
+// With INLINE > 0, 'data' keeps its first INLINE elements inside the object,
+// and while they all fit, push() inserts straight into the sorted run like a
+// plain sorted array, so the buffer is never used and nothing is allocated.
+template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+         bool STABLE = false, std::size_t INLINE = 0>
 class SortedPQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
 {
     // This is a way to refer to the base class object.
     using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
 
 public:
-    
+
     // Description: Construct an empty heap with an optional comparison functor.
     // Runtime: O(1)
-    explicit SortedPQ(COMP_FUNCTOR comp = COMP_FUNCTOR()) : 
+    explicit SortedPQ(COMP_FUNCTOR comp = COMP_FUNCTOR()) :
     BaseClass{ comp }
         {} // SortedPQ
 
 
     // Description: Construct a heap out of an iterator range with an optional
     //              comparison functor.
-    // Runtime: O(n log n) where n is number of elements in range.
+    // Runtime: O(n log n) where n is number of elements in range, O(n) if
+    //          the range is already sorted (or reverse sorted).
     template<typename InputIterator>
-    SortedPQ(InputIterator start, InputIterator end, 
-            COMP_FUNCTOR comp = COMP_FUNCTOR()) : 
+    SortedPQ(InputIterator start, InputIterator end,
+            COMP_FUNCTOR comp = COMP_FUNCTOR()) :
             BaseClass{ comp }, data{ start, end }
-    { updatePriorities(); } // SortedPQ
+    {
+        // the first element of the range is the oldest, so it belongs
+        // nearest the back among its equals
+        if constexpr (STABLE)
+            std::reverse(data.begin(), data.end());
+        updatePriorities();
+    } // SortedPQ
 
 
     // Description: Destructor doesn't need any code, the data vector will
@@ -42,23 +82,24 @@ public:
     {} // ~SortedPQ()
 
 
-    // Description: Add a new element to the heap.
-    // Runtime: O(n)
-    /*
-        lower_bound returns an iterator pointing to the first element in the range [first, last) that is not less than (i.e., greater or equal to) the value specified. If all elements in the range are less than the specified value, the function returns an iterator to the end of the range.
-    */
+    // Description: Add a new element to the heap. It waits in the buffer
+    //              until pop() or updatePriorities() merges it in.
+    // Runtime: O(1) amortized, O(INLINE) while the heap fits inline
     virtual void push(const TYPE &val)
     {
-        // Find the last place val should go
-        auto index = std::lower_bound(
-            data.begin(), 
-            data.end(), 
-            val, 
-            this->compare
-        );
-        
-        // insert val at its lower bound
-        data.insert(index, val);        
+        if constexpr (INLINE > 0)
+        {
+            if (buffer.empty() && data.size() < INLINE)
+            {
+                insertSorted(val);
+                return;
+            } // if
+        } // if
+
+        // keep the first of equal extremes, which is the oldest
+        if (buffer.empty() || this->compare(buffer[bufferTop], val))
+            bufferTop = buffer.size();
+        buffer.push_back(val);
     } // push()
 
 
@@ -67,9 +108,12 @@ public:
     // Note: We will not run tests on your code that would require it to pop an
     // element when the heap is empty. Though you are welcome to if you are
     // familiar with them, you do not need to use exceptions in this project.
-    // Runtime: Amortized O(1)
+    // Runtime: Amortized O(1) while the top is in the sorted run; a pop that
+    //          reaches into the buffer first merges it, in O(n + b log b).
     virtual void pop()
     {
+        if (topInBuffer())
+            mergeBuffer();
         data.pop_back();
     } // pop()
 
@@ -81,7 +125,7 @@ public:
     // Runtime: O(1)
     virtual const TYPE &top() const
     {
-        return data.back();
+        return topInBuffer() ? buffer[bufferTop] : data.back();
     } // top()
 
 
@@ -90,7 +134,7 @@ public:
     // Runtime: O(1)
     virtual std::size_t size() const
     {
-        return data.size();
+        return data.size() + buffer.size();
     } // size()
 
 
@@ -99,23 +143,315 @@ public:
     // Runtime: O(1)
     virtual bool empty() const
     {
-        return data.empty();
+        return data.empty() && buffer.empty();
     } // empty()
 
 
     // Description: Assumes that all elements inside the heap are out of order and
     //              'rebuilds' the heap by fixing the heap invariant.
-    // Runtime: O(n log n)
+    // Runtime: O(n + b log b) if the sorted run is still intact, otherwise
+    //          O(n log n), less for inputs made of long sorted runs.
     virtual void updatePriorities()
     {
-        // sort the vector
-        sort(data.begin(), data.end(), this->compare);
+        updatePriorities(parallel::threadsFor(data.size() + buffer.size()));
     } // updatePriorities()
 
 
+    // Description: updatePriorities() on 'threads' threads. A full re-sort
+    //              sorts one slice of the elements per thread, then merges
+    //              neighboring slices, pairs of them in parallel, until one
+    //              is left. Every step is stable, so the elements come out in
+    //              the same order as from the serial sort.
+    // Runtime: O(n + b log b) if the sorted run is still intact, otherwise
+    //          O((n log n) / threads + n log(threads)).
+    void updatePriorities(std::size_t threads)
+    {
+        // If no priority inside the sorted run changed, only the buffer
+        // needs sorting; checking that is a single linear pass.
+        if (std::is_sorted(data.begin(), data.end(), this->compare))
+        {
+            mergeBuffer();
+            return;
+        } // if
+
+        // buffered elements are the newest, so in stable mode they go in
+        // front, newest first
+        data.insert(data.begin(), buffer.rbegin(), buffer.rend());
+        buffer.clear();
+
+        const std::size_t n = data.size();
+        threads = std::min(threads, n / MIN_RUN);
+        if (threads < 2)
+        {
+            runSort(data.begin(), data.end());
+            return;
+        } // if
+
+        auto at = [this](std::size_t i) { return data.begin() + static_cast<std::ptrdiff_t>(i); };
+        std::vector<std::size_t> bounds;
+        for (std::size_t t = 0; t <= threads; ++t)
+            bounds.push_back(n * t / threads);
+        parallel::run(threads, [this, &at, &bounds](std::size_t t)
+        {
+            runSort(at(bounds[t]), at(bounds[t + 1]));
+        });
+
+        // merge neighboring slices until a single one is left
+        while (bounds.size() > 2)
+        {
+            const std::size_t pairs = (bounds.size() - 1) / 2;
+            parallel::run(pairs, [this, &at, &bounds](std::size_t i)
+            {
+                std::inplace_merge(at(bounds[2 * i]), at(bounds[2 * i + 1]),
+                                   at(bounds[2 * i + 2]), this->compare);
+            });
+            std::vector<std::size_t> merged;
+            for (std::size_t i = 0; i < bounds.size(); i += 2)
+                merged.push_back(bounds[i]);
+            if (merged.back() != n)
+                merged.push_back(n);
+            bounds.swap(merged);
+        } // while
+    } // updatePriorities()
+
+
+    // Description: Merge the pushes waiting in the buffer and return the PQ
+    //              as const, ready for the views below. The views stay
+    //              usable until the next push().
+    // Runtime: O(n + b log b), O(1) if nothing was pushed since the last
+    //          merge.
+    const SortedPQ &sorted_view()
+    {
+        mergeBuffer();
+        return *this;
+    } // sorted_view()
+
+
+    using const_iterator = typename InlineStorage<TYPE, INLINE>::const_iterator;
+
+    // Description: Iterators over the elements in sorted order, least
+    //              extreme first, so the last element is top(). They stay
+    //              valid until the next push(), pop() or updatePriorities().
+    // Runtime: O(1)
+    const_iterator begin() const
+    {
+        assertMerged();
+        return data.cbegin();
+    } // begin()
+
+    const_iterator end() const
+    {
+        assertMerged();
+        return data.cend();
+    } // end()
+
+
+    // Description: A view of the n most extreme elements (all of them if
+    //              there are fewer), most extreme first. No copy is made.
+    // Runtime: O(1)
+    auto top_n(std::size_t n) const
+    {
+        assertMerged();
+        auto count = static_cast<std::ptrdiff_t>(std::min(n, data.size()));
+        return std::ranges::subrange(data.crbegin(), data.crbegin() + count);
+    } // top_n()
+
+
+    // Description: The number of elements strictly more extreme than val,
+    //              i.e. the position val would be popped at; rank(top()) == 0.
+    // Runtime: O(log(n))
+    std::size_t rank(const TYPE &val) const
+    {
+        assertMerged();
+        return static_cast<std::size_t>(data.data() + data.size() - upperBound(val));
+    } // rank()
+
+
+    // Description: The element that the i-th pop would return, where
+    //              select(0) == top(). i must be less than size().
+    // Runtime: O(1)
+    const TYPE &select(std::size_t i) const
+    {
+        assertMerged();
+        return data[data.size() - 1 - i];
+    } // select()
+
+
+    // Description: The number of elements from lo up to hi, both included,
+    //              where lo is not more extreme than hi.
+    // Runtime: O(log(n))
+    std::size_t count_between(const TYPE &lo, const TYPE &hi) const
+    {
+        assertMerged();
+        const TYPE *first = fastLowerBound(data.data(), data.data() + data.size(),
+                                           lo, this->compare);
+        const TYPE *last = upperBound(hi);
+        return last > first ? static_cast<std::size_t>(last - first) : 0;
+    } // count_between()
+
+
 private:
+
+    // Runs shorter than this are extended with insertion sort before merging.
+    static constexpr std::size_t MIN_RUN = 32;
+
+    // Buffers up to this size are inserted one by one instead of merged.
+    static constexpr std::size_t MAX_INSERTS = 8;
+
     // priority queue's underlying container
-    std::vector<TYPE> data;
+    InlineStorage<TYPE, INLINE> data;
+
+    // unsorted pushes not yet merged into 'data', and the index of the most
+    // extreme of them
+    std::vector<TYPE> buffer;
+    std::size_t bufferTop = 0;
+
+    // reused output of the merge, so steady state merges do not allocate
+    std::vector<TYPE> scratch;
+
+
+    // Description: The first element of 'data' more extreme than val.
+    // Runtime: O(log(n))
+    const TYPE *upperBound(const TYPE &val) const
+    {
+        // lower bound of "not less extreme than val" is the upper bound of val
+        auto notAbove = [this](const TYPE &elt, const TYPE &v) { return !this->compare(v, elt); };
+        return fastLowerBound(data.data(), data.data() + data.size(), val, notAbove);
+    } // upperBound()
+
+
+    // Description: The views read 'data' alone, so nothing may be waiting
+    //              in the buffer.
+    // Runtime: O(1)
+    void assertMerged() const
+    {
+        assert(buffer.empty() && "call sorted_view() after push()");
+    } // assertMerged()
+
+
+    // Description: Is the top element in the buffer? Ties go to 'data', whose
+    //              elements are older.
+    // Runtime: O(1)
+    bool topInBuffer() const
+    {
+        return !buffer.empty() &&
+               (data.empty() || this->compare(data.back(), buffer[bufferTop]));
+    } // topInBuffer()
+
+
+    // Description: Sort the buffer and merge it into 'data' in one pass.
+    //              A buffer of a few elements is inserted at each one's
+    //              lower bound instead, which moves half the run per element
+    //              but compares only O(log n) times.
+    // Runtime: O(n + b log b)
+    void mergeBuffer()
+    {
+        if (buffer.empty())
+            return;
+
+        if (buffer.size() <= MAX_INSERTS)
+        {
+            // oldest first: each insert lands in front of its equals
+            for (const TYPE &val : buffer)
+                insertSorted(val);
+            buffer.clear();
+            return;
+        } // if
+
+        // newest first, so that after a stable sort and merge they end up
+        // in front of their equals
+        if constexpr (STABLE)
+            std::reverse(buffer.begin(), buffer.end());
+        runSort(buffer.begin(), buffer.end());
+
+        scratch.clear();
+        scratch.reserve(data.size() + buffer.size());
+        std::merge(buffer.begin(), buffer.end(), data.begin(), data.end(),
+                   std::back_inserter(scratch), this->compare);
+        if constexpr (INLINE == 0)
+            data.swap(scratch);
+        else
+            data.assign(std::make_move_iterator(scratch.begin()),
+                        std::make_move_iterator(scratch.end()));
+        buffer.clear();
+    } // mergeBuffer()
+
+
+    // Description: Insert val at its lower bound in 'data', in front of
+    //              its equals.
+    // Runtime: O(n)
+    void insertSorted(const TYPE &val)
+    {
+        const TYPE *slot = fastLowerBound(data.data(), data.data() + data.size(),
+                                          val, this->compare);
+        data.insert(data.begin() + (slot - data.data()), val);
+    } // insertSorted()
+
+
+    // Description: Stable, adaptive merge sort. Finds the natural runs of
+    //              [begin, end) (strictly descending runs are reversed in
+    //              place), extends runs shorter than MIN_RUN with insertion
+    //              sort, then merges neighboring runs pairwise until one is
+    //              left.
+    // Runtime: O(n log r) for r runs: O(n) on sorted or reverse sorted input,
+    //          O(n log n) at worst.
+    template<typename ITERATOR>
+    void runSort(ITERATOR begin, ITERATOR end) const
+    {
+        const std::size_t n = static_cast<std::size_t>(end - begin);
+        if (n < 2)
+            return;
+
+        auto at = [begin](std::size_t i) { return begin + static_cast<std::ptrdiff_t>(i); };
+
+        // find the runs; bounds[i] .. bounds[i + 1] is sorted
+        std::vector<std::size_t> bounds{ 0 };
+        std::size_t first = 0;
+        while (first < n)
+        {
+            std::size_t last = first + 1;
+            if (last < n && this->compare(*at(last), *at(last - 1)))
+            {
+                while (last < n && this->compare(*at(last), *at(last - 1)))
+                    ++last;
+                std::reverse(at(first), at(last));
+            } // if
+            else
+            {
+                while (last < n && !this->compare(*at(last), *at(last - 1)))
+                    ++last;
+            } // else
+
+            // extend a short run by inserting the following elements one at
+            // a time after their equals (upper_bound keeps it stable)
+            std::size_t end = std::min(n, first + MIN_RUN);
+            for (; last < end; ++last)
+            {
+                auto slot = std::upper_bound(at(first), at(last), *at(last), this->compare);
+                std::rotate(slot, at(last), at(last + 1));
+            } // for
+
+            bounds.push_back(last);
+            first = last;
+        } // while
+
+        // merge neighboring runs until a single one is left
+        while (bounds.size() > 2)
+        {
+            std::vector<std::size_t> merged{ 0 };
+            for (std::size_t i = 0; i + 2 < bounds.size(); i += 2)
+            {
+                std::inplace_merge(at(bounds[i]), at(bounds[i + 1]), at(bounds[i + 2]),
+                                   this->compare);
+                merged.push_back(bounds[i + 2]);
+            } // for
+            if (merged.back() != n)
+                merged.push_back(n);
+            bounds.swap(merged);
+        } // while
+    } // runSort()
+
+
 }; // SortedPQ
 
 #endif // SORTEDPQ_H
@@ -0,0 +1,71 @@
+//  SpinLock.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A one-byte lock for critical sections of a few instructions, such as
+    the per-node locks of ConcurrentBinaryPQ, where a std::mutex would make
+    every node 40 bytes larger.
+
+    lock() spins on a plain load, so that waiting threads share the cache
+    line instead of bouncing it, and yields after a short while, so that a
+    thread that was preempted while holding the lock gets to run. It meets
+    the Lockable requirements, so std::lock_guard and std::unique_lock work
+    with it.
+
+*/
+
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <atomic>
+#include <thread>
+
+class SpinLock
+{
+public:
+
+    // Description: Wait for the lock and take it.
+    // Runtime: O(1) when the lock is free.
+    void lock()
+    {
+        for (unsigned spins = 0; !try_lock(); ++spins)
+        {
+            while (held.load(std::memory_order_relaxed))
+            {
+                if (++spins >= SPINS_BEFORE_YIELD)
+                    std::this_thread::yield();
+            } // while
+        } // for
+    } // lock()
+
+
+    // Description: Take the lock if it is free.
+    // Runtime: O(1)
+    // Returns: true if the lock was taken
+    bool try_lock()
+    {
+        return !held.exchange(true, std::memory_order_acquire);
+    } // try_lock()
+
+
+    // Description: Release the lock, which the caller holds.
+    // Runtime: O(1)
+    void unlock()
+    {
+        held.store(false, std::memory_order_release);
+    } // unlock()
+
+
+private:
+
+    // Plain loads before lock() starts yielding the processor.
+    static constexpr unsigned SPINS_BEFORE_YIELD = 64;
+
+    std::atomic<bool> held{ false };
+
+
+}; // SpinLock
+
+#endif // SPINLOCK_H
@@ -0,0 +1,274 @@
+//  StagedPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A priority queue owned by one thread, fed by other threads through a
+    StagingRing instead of a mutex.
+
+    Producers push() or try_push() into the ring and never touch the queue.
+    The owner calls drain(), or try_pop(), which drains first, and the ring
+    is emptied in batches of up to 'batch' elements, each handed to the
+    queue's push_range() at once: BinaryPQ fixes only the slots above the
+    batch, PairingPQ and SortedPQ take it in O(1) per element. The queue
+    itself stays single-threaded and in the owner's cache.
+
+    - Back-pressure: the ring has a fixed capacity. try_push() gives up on a
+      full ring, and push() yields until the owner makes room; stats()
+      counts both.
+    - Latency: with TRACK_LATENCY = true, every element carries the time it
+      was pushed, and drain() records how long elements waited in the ring,
+      which is what a slow owner costs the producers. This adds a clock read
+      to every push and drain.
+
+    The owner-side calls (drain(), try_pop(), queue()) are for one thread
+    only. A single producer may use MULTI_PRODUCER = false.
+
+*/
+
+#ifndef STAGEDPQ_H
+#define STAGEDPQ_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "BinaryPQ.h"
+#include "StagingRing.h"
+
+// A priority queue of type PQ, holding TYPE elements, owned by one thread
+// and fed through a lock-free ring by the others.
+template <typename TYPE, typename PQ = BinaryPQ<TYPE>, bool MULTI_PRODUCER = true,
+          bool TRACK_LATENCY = false>
+class StagedPQ
+{
+public:
+
+    // What the ring has seen so far. Latencies are in nanoseconds, and zero
+    // without TRACK_LATENCY.
+    struct Stats
+    {
+        std::size_t pushed = 0;
+        std::size_t rejected = 0;
+        std::size_t stalls = 0;
+        std::size_t drains = 0;
+        std::size_t drained = 0;
+        std::size_t largestBatch = 0;
+        std::uint64_t totalLatency = 0;
+        std::uint64_t worstLatency = 0;
+
+        double meanLatency() const
+        {
+            return drained ? static_cast<double>(totalLatency) / static_cast<double>(drained) : 0.0;
+        } // meanLatency()
+    }; // Stats
+
+
+    // Description: Construct an empty queue behind a ring of 'capacity'
+    //              slots, drained 'batch' elements at a time, passing any
+    //              further arguments to PQ's constructor.
+    // Runtime: O(capacity), plus that of PQ's constructor.
+    template <typename... Args>
+    explicit StagedPQ(std::size_t capacity = 1024, std::size_t batch = 256, Args &&...args)
+        : ring{ capacity }, batchSize{ std::max(std::size_t{ 1 }, batch) },
+          pq{ std::forward<Args>(args)... }
+    {
+        staged.reserve(batchSize);
+    } // StagedPQ
+
+
+    // The ring cannot be copied.
+    StagedPQ(const StagedPQ &) = delete;
+    StagedPQ &operator=(const StagedPQ &) = delete;
+
+
+    // Description: Hand val to the owner, unless the ring is full.
+    // Runtime: O(1)
+    // Returns: false, leaving the queue alone, if the ring was full
+    bool try_push(const TYPE &val)
+    {
+        if (ring.try_push(stamp(val)))
+            return true;
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    } // try_push()
+
+
+    // Description: Hand val to the owner, yielding while the ring is full.
+    //              The owner must not call this on a full ring, since
+    //              nobody else would drain it.
+    // Runtime: O(1), plus the wait for the owner to make room.
+    void push(const TYPE &val)
+    {
+        const Item item = stamp(val);
+        if (ring.try_push(item))
+            return;
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        while (!ring.try_push(item))
+            std::this_thread::yield();
+    } // push()
+
+
+    // Description: Move every element in the ring into the queue, 'batch'
+    //              at a time. Owner only.
+    // Runtime: O(k) plus that of PQ::push_range() for k elements.
+    // Returns: the number of elements moved
+    std::size_t drain()
+    {
+        std::size_t total = 0;
+        for (;;)
+        {
+            staged.clear();
+            const std::size_t moved = ring.pop_bulk(std::back_inserter(staged), batchSize);
+            if (moved == 0)
+                break;
+            total += moved;
+            largestBatch.store(std::max(largestBatch.load(std::memory_order_relaxed), moved),
+                               std::memory_order_relaxed);
+
+            if constexpr (TRACK_LATENCY)
+            {
+                const std::uint64_t now = clock();
+                values.clear();
+                std::uint64_t sum = 0, worst = worstLatency.load(std::memory_order_relaxed);
+                for (const Item &item : staged)
+                {
+                    const std::uint64_t waited = now > item.pushedAt ? now - item.pushedAt : 0;
+                    sum += waited;
+                    worst = std::max(worst, waited);
+                    values.push_back(item.value);
+                } // for
+                totalLatency.fetch_add(sum, std::memory_order_relaxed);
+                worstLatency.store(worst, std::memory_order_relaxed);
+                pq.push_range(values.begin(), values.end());
+            } // if
+            else
+                pq.push_range(staged.begin(), staged.end());
+        } // for
+
+        if (total > 0)
+        {
+            drains.fetch_add(1, std::memory_order_relaxed);
+            drained.fetch_add(total, std::memory_order_relaxed);
+        } // if
+        return total;
+    } // drain()
+
+
+    // Description: Drain the ring, then remove the most extreme element
+    //              and copy it into out. Owner only.
+    // Runtime: That of drain(), plus that of PQ::pop().
+    // Returns: false, leaving out alone, if the queue is empty
+    bool try_pop(TYPE &out)
+    {
+        drain();
+        if (pq.empty())
+            return false;
+        out = pq.top();
+        pq.pop();
+        return true;
+    } // try_pop()
+
+
+    // Description: The queue, for the owner to use as is. Elements still in
+    //              the ring are not in it until the next drain().
+    // Runtime: O(1)
+    PQ &queue()
+    {
+        return pq;
+    } // queue()
+
+    const PQ &queue() const
+    {
+        return pq;
+    } // queue()
+
+
+    // Description: The number of elements waiting in the ring. Other
+    //              threads may change it before the caller looks at it.
+    // Runtime: O(1)
+    std::size_t pending() const
+    {
+        return ring.size();
+    } // pending()
+
+
+    // Description: The counters so far. Only exact once the producers are
+    //              done.
+    // Runtime: O(1)
+    Stats stats() const
+    {
+        Stats s;
+        s.pushed = ring.pushed();
+        s.rejected = rejected.load(std::memory_order_relaxed);
+        s.stalls = stalls.load(std::memory_order_relaxed);
+        s.drains = drains.load(std::memory_order_relaxed);
+        s.drained = drained.load(std::memory_order_relaxed);
+        s.largestBatch = largestBatch.load(std::memory_order_relaxed);
+        s.totalLatency = totalLatency.load(std::memory_order_relaxed);
+        s.worstLatency = worstLatency.load(std::memory_order_relaxed);
+        return s;
+    } // stats()
+
+
+private:
+
+    // An element with the time it was pushed.
+    struct Stamped
+    {
+        TYPE value{};
+        std::uint64_t pushedAt = 0;
+    }; // Stamped
+
+    using Item = std::conditional_t<TRACK_LATENCY, Stamped, TYPE>;
+
+    StagingRing<Item, MULTI_PRODUCER> ring;
+    std::size_t batchSize;
+    PQ pq;
+
+    // the owner's batch, and its values without their times with
+    // TRACK_LATENCY, kept to reuse their memory
+    std::vector<Item> staged;
+    std::vector<TYPE> values;
+
+    // written by producers only on a full ring, the rest by the owner only
+    std::atomic<std::size_t> rejected{ 0 };
+    std::atomic<std::size_t> stalls{ 0 };
+    std::atomic<std::size_t> drains{ 0 };
+    std::atomic<std::size_t> drained{ 0 };
+    std::atomic<std::size_t> largestBatch{ 0 };
+    std::atomic<std::uint64_t> totalLatency{ 0 };
+    std::atomic<std::uint64_t> worstLatency{ 0 };
+
+
+    // Description: Nanoseconds on the steady clock.
+    // Runtime: O(1)
+    static std::uint64_t clock()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    } // clock()
+
+
+    // Description: val as the ring stores it, with the time with
+    //              TRACK_LATENCY.
+    // Runtime: O(1)
+    static Item stamp(const TYPE &val)
+    {
+        if constexpr (TRACK_LATENCY)
+            return Item{ val, clock() };
+        else
+            return val;
+    } // stamp()
+
+
+}; // StagedPQ
+
+#endif // STAGEDPQ_H
@@ -0,0 +1,171 @@
+//  StagingRing.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A bounded lock-free FIFO ring with a single consumer, for handing
+    elements to the one thread that owns a data structure. With
+    MULTI_PRODUCER = false only one thread may push, which saves the
+    compare-and-swap on the tail.
+
+    The ring follows Vyukov's bounded queue: every slot carries a sequence
+    number that says whose turn it is. A slot at position pos is free for
+    the producer of pos while its sequence is pos, and holds an element for
+    the consumer once it is pos + 1. The consumer frees it for the next lap
+    by setting it to pos + capacity. Producers therefore only meet each
+    other on the tail, and never meet the consumer except on a full ring.
+
+    try_push() fails instead of waiting when the ring is full, which leaves
+    the back-pressure policy to the caller. pop_bulk() moves out up to a
+    given number of elements in FIFO order.
+
+*/
+
+#ifndef STAGINGRING_H
+#define STAGINGRING_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// A bounded FIFO of TYPE for one consumer and one or many producers.
+template <typename TYPE, bool MULTI_PRODUCER = true>
+class StagingRing
+{
+public:
+
+    // Description: Construct an empty ring of at least 'capacity' slots,
+    //              rounded up to a power of two.
+    // Runtime: O(capacity)
+    explicit StagingRing(std::size_t capacity = 1024)
+        : mask{ std::bit_ceil(std::max(capacity, std::size_t{ 2 })) - 1 },
+          slots{ std::make_unique<Slot[]>(mask + 1) }
+    {
+        for (std::size_t i = 0; i <= mask; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    } // StagingRing
+
+
+    // The slots cannot be copied.
+    StagingRing(const StagingRing &) = delete;
+    StagingRing &operator=(const StagingRing &) = delete;
+
+
+    // Description: Append val, unless the ring is full. Any thread may call
+    //              this with MULTI_PRODUCER, otherwise only one.
+    // Runtime: O(1), plus retries while other producers win the tail.
+    // Returns: false, leaving the ring alone, if it was full
+    bool try_push(const TYPE &val)
+    {
+        std::size_t pos = tail.value.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;)
+        {
+            slot = &slots[pos & mask];
+            const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t lag = static_cast<std::ptrdiff_t>(sequence - pos);
+            if (lag < 0)
+                return false;
+            if (lag > 0)
+            {
+                // another producer took pos
+                pos = tail.value.load(std::memory_order_relaxed);
+                continue;
+            } // if
+
+            if constexpr (MULTI_PRODUCER)
+            {
+                if (tail.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } // if
+            else
+            {
+                tail.value.store(pos + 1, std::memory_order_relaxed);
+                break;
+            } // else
+        } // for
+
+        slot->value = val;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    } // try_push()
+
+
+    // Description: Move up to max elements, oldest first, to out. Only the
+    //              consumer may call this.
+    // Runtime: O(elements moved)
+    // Returns: the number of elements moved
+    template <typename OutputIterator>
+    std::size_t pop_bulk(OutputIterator out, std::size_t max)
+    {
+        std::size_t pos = head.value.load(std::memory_order_relaxed);
+        std::size_t moved = 0;
+        for (; moved < max; ++moved, ++pos)
+        {
+            Slot &slot = slots[pos & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+                break;
+            *out++ = std::move(slot.value);
+            slot.sequence.store(pos + mask + 1, std::memory_order_release);
+        } // for
+        head.value.store(pos, std::memory_order_relaxed);
+        return moved;
+    } // pop_bulk()
+
+
+    // Description: The number of slots.
+    // Runtime: O(1)
+    std::size_t capacity() const
+    {
+        return mask + 1;
+    } // capacity()
+
+
+    // Description: The number of elements claimed by producers and not yet
+    //              popped, some of which may still be being written.
+    //              Other threads may change it before the caller looks at it.
+    // Runtime: O(1)
+    std::size_t size() const
+    {
+        const std::size_t first = head.value.load(std::memory_order_relaxed);
+        const std::size_t last = tail.value.load(std::memory_order_relaxed);
+        return last > first ? last - first : 0;
+    } // size()
+
+
+    // Description: The number of elements ever claimed by producers.
+    // Runtime: O(1)
+    std::size_t pushed() const
+    {
+        return tail.value.load(std::memory_order_relaxed);
+    } // pushed()
+
+
+private:
+
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence{ 0 };
+        TYPE value{};
+    }; // Slot
+
+    // A position on a cache line of its own, so that producers bumping the
+    // tail do not slow down the consumer reading the head.
+    struct alignas(64) Position
+    {
+        std::atomic<std::size_t> value{ 0 };
+    }; // Position
+
+    std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    Position tail;
+    Position head;
+
+
+}; // StagingRing
+
+#endif // STAGINGRING_H
@@ -0,0 +1,490 @@
+//  TaskScheduler.h
+//  p2b-priority-queues
+//
+
+/*
+
+    A pool of worker threads that runs tasks in priority order, each worker
+    taking tasks from a BinaryPQ of its own instead of all of them sharing
+    one locked queue.
+
+    - submit() from outside the pool pushes onto a global injection queue.
+      submit() from a task, and the dependents a finished task releases, go
+      onto the running worker's own queue, which nobody else touches
+      unless it steals.
+    - A worker runs the better of its own top and the injection queue's.
+      With both empty it steals: it picks a random victim and takes the
+      best half of its queue, so that the most urgent work moves to idle
+      workers first. With nothing to steal anywhere it sleeps.
+    - A task may depend on others, and only becomes ready once they have
+      all finished. Priority inheritance keeps a dependency from holding
+      up a more urgent task: submitting a task raises every unfinished
+      task it waits on, transitively, to its own priority. A task already
+      queued gets a second entry at the raised priority, and whichever
+      entry is popped first runs it; the other is skipped.
+
+    The order is the per-worker order, not a global one: with p workers a
+    task may start while a few more urgent ones wait on other workers.
+    stats() counts the steals that keep those queues level.
+
+    Tasks must not throw, as nothing is there to catch it, and must not
+    call wait() on their own scheduler.
+
+*/
+
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "BinaryPQ.h"
+#include "SpinLock.h"
+
+// A pool of threads running tasks of PRIORITY (defined by 'compare') from
+// per-worker queues, with work stealing and priority inheritance.
+template <typename PRIORITY = int, typename COMP_FUNCTOR = std::less<PRIORITY>>
+class TaskScheduler
+{
+    struct Task;
+
+public:
+
+    // A submitted task, to make later tasks depend on it.
+    using Handle = std::shared_ptr<Task>;
+
+    // What the workers have done so far.
+    struct Stats
+    {
+        std::size_t executed = 0;
+        std::size_t steals = 0;
+        std::size_t stolen = 0;
+        std::size_t boosts = 0;
+    }; // Stats
+
+
+    // Description: Start 'workers' threads, with an optional comparison
+    //              functor for the priorities.
+    // Runtime: O(workers)
+    explicit TaskScheduler(std::size_t workers = std::thread::hardware_concurrency(),
+                           COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : compare{ comp }, injected{ EntryComp{ comp } }
+    {
+        const std::size_t n = std::max(std::size_t{ 1 }, workers);
+        for (std::size_t i = 0; i < n; ++i)
+            pool.push_back(std::make_unique<Worker>(EntryComp{ comp }));
+        for (std::size_t i = 0; i < n; ++i)
+            pool[i]->thread = std::thread{ [this, i]() { workerLoop(i); } };
+    } // TaskScheduler
+
+
+    // The threads cannot be copied.
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+
+    // Description: Run every task submitted so far, then stop the workers.
+    // Runtime: That of the remaining tasks.
+    ~TaskScheduler()
+    {
+        wait();
+        {
+            std::lock_guard<std::mutex> guard{ sleepLock };
+            stopping = true;
+        }
+        sleepCv.notify_all();
+        for (std::unique_ptr<Worker> &worker : pool)
+            worker->thread.join();
+    } // ~TaskScheduler()
+
+
+    // Description: Submit work to run at priority once every task in
+    //              dependsOn has finished, raising those that are less
+    //              urgent to priority.
+    // Runtime: O(log(n)) to queue it, plus O(d) for d dependencies and the
+    //          tasks they in turn wait on.
+    // Returns: the task, for later tasks to depend on
+    Handle submit(const PRIORITY &priority, std::function<void()> work,
+                  const std::vector<Handle> &dependsOn = {})
+    {
+        Handle task = std::make_shared<Task>(priority, std::move(work));
+        unfinished.fetch_add(1);
+        if (dependsOn.empty())
+        {
+            task->state.store(QUEUED);
+            enqueue(task, priority);
+            return task;
+        } // if
+
+        std::vector<std::pair<Handle, PRIORITY>> requeue;
+        {
+            std::lock_guard<std::mutex> guard{ graphLock };
+            for (const Handle &dep : dependsOn)
+            {
+                if (dep->state.load() == DONE)
+                    continue;
+                ++task->pending;
+                dep->dependents.push_back(task);
+                task->waitsOn.push_back(dep);
+                boost(dep, priority, requeue);
+            } // for
+            if (task->pending == 0)
+                task->state.store(QUEUED);
+        } // scope
+
+        for (auto &[dep, raised] : requeue)
+            enqueue(dep, raised);
+        if (task->state.load() == QUEUED)
+            enqueue(task, priority);
+        return task;
+    } // submit()
+
+
+    // Description: Wait until every task submitted so far has finished.
+    //              Must not be called from a task.
+    // Runtime: That of the remaining tasks.
+    void wait()
+    {
+        std::unique_lock<std::mutex> guard{ doneLock };
+        doneCv.wait(guard, [this]() { return unfinished.load() == 0; });
+    } // wait()
+
+
+    // Description: The number of workers.
+    // Runtime: O(1)
+    std::size_t workers() const
+    {
+        return pool.size();
+    } // workers()
+
+
+    // Description: What the workers have done so far.
+    // Runtime: O(1)
+    Stats stats() const
+    {
+        Stats s;
+        s.executed = executed.load(std::memory_order_relaxed);
+        s.steals = steals.load(std::memory_order_relaxed);
+        s.stolen = stolen.load(std::memory_order_relaxed);
+        s.boosts = boosts.load(std::memory_order_relaxed);
+        return s;
+    } // stats()
+
+
+private:
+
+    // WAITING on dependencies, QUEUED in some queue, RUNNING, or DONE.
+    enum : int { WAITING, QUEUED, RUNNING, DONE };
+
+    struct Task
+    {
+        std::function<void()> work;
+        std::atomic<int> state{ WAITING };
+
+        // guarded by graphLock: the priority, raised by inheritance, the
+        // unfinished dependencies, and the tasks waiting on this one
+        PRIORITY priority;
+        std::size_t pending = 0;
+        std::vector<Handle> waitsOn;
+        std::vector<Handle> dependents;
+
+        Task(const PRIORITY &p, std::function<void()> w) : work{ std::move(w) }, priority{ p } {}
+    }; // Task
+
+    // A queue entry: a task at the priority it was queued with. A boosted
+    // task has several; the first one popped runs it.
+    struct Entry
+    {
+        PRIORITY priority;
+        Handle task;
+    }; // Entry
+
+    struct EntryComp
+    {
+        COMP_FUNCTOR compare;
+
+        bool operator()(const Entry &a, const Entry &b) const
+        {
+            return compare(a.priority, b.priority);
+        } // operator()()
+    }; // EntryComp
+
+    using Queue = BinaryPQ<Entry, EntryComp>;
+
+    // A worker's queue, on a cache line of its own so that pushes to one
+    // queue do not slow down the others.
+    struct alignas(64) Worker
+    {
+        SpinLock lock;
+        Queue queue;
+        std::thread thread;
+
+        explicit Worker(const EntryComp &comp) : queue{ comp } {}
+    }; // Worker
+
+    COMP_FUNCTOR compare;
+    std::vector<std::unique_ptr<Worker>> pool;
+
+    // the global injection queue, for tasks submitted from outside
+    std::mutex injectLock;
+    Queue injected;
+
+    // guards every Task's dependency fields
+    std::mutex graphLock;
+
+    // entries in all queues, stale ones included, and idle workers
+    std::atomic<std::size_t> queued{ 0 };
+    std::atomic<std::size_t> sleepers{ 0 };
+    std::mutex sleepLock;
+    std::condition_variable sleepCv;
+    bool stopping = false;
+
+    // tasks submitted but not finished, for wait()
+    std::atomic<std::size_t> unfinished{ 0 };
+    std::mutex doneLock;
+    std::condition_variable doneCv;
+
+    std::atomic<std::size_t> executed{ 0 };
+    std::atomic<std::size_t> steals{ 0 };
+    std::atomic<std::size_t> stolen{ 0 };
+    std::atomic<std::size_t> boosts{ 0 };
+
+
+    // Description: The index of the calling thread's worker, or
+    //              pool.size() if it is not one of this scheduler's.
+    // Runtime: O(1)
+    std::size_t currentWorker() const
+    {
+        return current().owner == this ? current().index : pool.size();
+    } // currentWorker()
+
+
+    // The scheduler and worker the calling thread runs for, if any.
+    struct Current
+    {
+        const TaskScheduler *owner = nullptr;
+        std::size_t index = 0;
+    }; // Current
+
+    static Current &current()
+    {
+        thread_local Current self;
+        return self;
+    } // current()
+
+
+    // Description: Queue task at priority: on the calling worker's own
+    //              queue, or the injection queue from outside the pool.
+    // Runtime: O(log(n))
+    void enqueue(const Handle &task, const PRIORITY &priority)
+    {
+        const std::size_t self = currentWorker();
+        if (self < pool.size())
+        {
+            std::lock_guard<SpinLock> guard{ pool[self]->lock };
+            pool[self]->queue.push(Entry{ priority, task });
+        } // if
+        else
+        {
+            std::lock_guard<std::mutex> guard{ injectLock };
+            injected.push(Entry{ priority, task });
+        } // else
+
+        // a worker about to sleep counts itself before it checks queued, and
+        // this checks sleepers after counting the entry, so one of the two
+        // sees the other
+        queued.fetch_add(1);
+        if (sleepers.load() > 0)
+        {
+            std::lock_guard<std::mutex> guard{ sleepLock };
+            sleepCv.notify_one();
+        } // if
+    } // enqueue()
+
+
+    // Description: Raise task, and every unfinished task it waits on, to
+    //              priority. Queued ones are collected in requeue, to get
+    //              an entry at the new priority. The caller holds graphLock.
+    // Runtime: O(tasks raised)
+    void boost(const Handle &task, const PRIORITY &priority,
+               std::vector<std::pair<Handle, PRIORITY>> &requeue)
+    {
+        std::vector<Handle> stack{ task };
+        while (!stack.empty())
+        {
+            Handle next = std::move(stack.back());
+            stack.pop_back();
+            const int state = next->state.load();
+            if (state == RUNNING || state == DONE || !compare(next->priority, priority))
+                continue;
+
+            next->priority = priority;
+            boosts.fetch_add(1, std::memory_order_relaxed);
+            if (state == QUEUED)
+                requeue.emplace_back(next, priority);
+            for (const Handle &dep : next->waitsOn)
+                stack.push_back(dep);
+        } // while
+    } // boost()
+
+
+    // Description: Pop the better of worker self's top and the injection
+    //              queue's, skipping the injection queue while it is busy.
+    // Runtime: O(log(n))
+    // Returns: false if both were empty
+    bool popLocalOrInjected(std::size_t self, Entry &out)
+    {
+        Worker &worker = *pool[self];
+        std::lock_guard<SpinLock> guard{ worker.lock };
+        std::unique_lock<std::mutex> injectGuard{ injectLock, std::try_to_lock };
+        const bool useInjected = injectGuard.owns_lock() && !injected.empty() &&
+            (worker.queue.empty() || EntryComp{ compare }(worker.queue.top(), injected.top()));
+        Queue &from = useInjected ? injected : worker.queue;
+        if (from.empty())
+            return false;
+        out = from.top();
+        from.pop();
+        return true;
+    } // popLocalOrInjected()
+
+
+    // Description: Move the best half of a random victim's queue into
+    //              worker self's, and pop the best of it into out.
+    // Runtime: O(k log(n)) for k stolen entries
+    // Returns: false if no queue had anything to steal
+    bool steal(std::size_t self, Entry &out)
+    {
+        const std::size_t n = pool.size();
+        std::vector<Entry> loot;
+        std::size_t start = randomIndex(n);
+        for (std::size_t i = 0; i < n && loot.empty(); ++i)
+        {
+            Worker &victim = *pool[(start + i) % n];
+            if (&victim == pool[self].get())
+                continue;
+            std::unique_lock<SpinLock> guard{ victim.lock, std::try_to_lock };
+            if (!guard.owns_lock())
+                continue;
+            for (std::size_t k = (victim.queue.size() + 1) / 2; k > 0; --k)
+            {
+                loot.push_back(victim.queue.top());
+                victim.queue.pop();
+            } // for
+        } // for
+        if (loot.empty())
+            return false;
+
+        steals.fetch_add(1, std::memory_order_relaxed);
+        stolen.fetch_add(loot.size(), std::memory_order_relaxed);
+        out = std::move(loot.front());
+        std::lock_guard<SpinLock> guard{ pool[self]->lock };
+        for (std::size_t k = 1; k < loot.size(); ++k)
+            pool[self]->queue.push(std::move(loot[k]));
+        return true;
+    } // steal()
+
+
+    // Description: A uniformly random index below n, from a generator of
+    //              the calling thread's own.
+    // Runtime: O(1)
+    static std::size_t randomIndex(std::size_t n)
+    {
+        // xorshift64*, seeded from the address of the state itself, which
+        // differs between threads
+        thread_local std::uint64_t state = 0;
+        if (state == 0)
+            state = reinterpret_cast<std::uintptr_t>(&state) | 1;
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        const std::uint64_t bits = (state * 0x2545F4914F6CDD1DULL) >> 32;
+        return static_cast<std::size_t>((bits * n) >> 32);
+    } // randomIndex()
+
+
+    // Description: Run the task of entry, unless another entry of it ran it
+    //              already, then release its dependents.
+    // Runtime: That of the task, plus O(log(n)) per dependent released.
+    void run(Entry &entry)
+    {
+        queued.fetch_sub(1);
+        Handle task = std::move(entry.task);
+        int expected = QUEUED;
+        if (!task->state.compare_exchange_strong(expected, RUNNING))
+            return;
+        task->work();
+        executed.fetch_add(1, std::memory_order_relaxed);
+
+        std::vector<std::pair<Handle, PRIORITY>> ready;
+        {
+            std::lock_guard<std::mutex> guard{ graphLock };
+            task->state.store(DONE);
+            for (Handle &dependent : task->dependents)
+            {
+                if (--dependent->pending == 0)
+                {
+                    dependent->state.store(QUEUED);
+                    dependent->waitsOn.clear();
+                    const PRIORITY priority = dependent->priority;
+                    ready.emplace_back(std::move(dependent), priority);
+                } // if
+            } // for
+            task->dependents.clear();
+            task->waitsOn.clear();
+        } // scope
+
+        for (auto &[next, priority] : ready)
+            enqueue(next, priority);
+        if (unfinished.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> guard{ doneLock };
+            doneCv.notify_all();
+        } // if
+    } // run()
+
+
+    // Description: The body of worker self: run tasks until the scheduler
+    //              stops, sleeping while there is nothing to run.
+    // Runtime: Until the destructor.
+    void workerLoop(std::size_t self)
+    {
+        current() = Current{ this, self };
+        Entry entry;
+        for (;;)
+        {
+            if (popLocalOrInjected(self, entry) || steal(self, entry))
+            {
+                run(entry);
+                continue;
+            } // if
+
+            // entries that are out of reach for now, behind a busy lock or
+            // being run, are not worth sleeping over but leave the core to
+            // whoever holds them
+            if (queued.load() > 0)
+            {
+                std::this_thread::yield();
+                continue;
+            } // if
+
+            std::unique_lock<std::mutex> guard{ sleepLock };
+            sleepers.fetch_add(1);
+            sleepCv.wait(guard, [this]() { return queued.load() > 0 || stopping; });
+            sleepers.fetch_sub(1);
+            if (stopping && queued.load() == 0)
+                return;
+        } // for
+    } // workerLoop()
+
+
+}; // TaskScheduler
+
+#endif // TASKSCHEDULER_H
@@ -0,0 +1,110 @@
+//  TieBreak.h
+//  p2b-priority-queues
+//
+
+/*
+
+    The policy behind the STABLE template flag of the priority queues.
+
+    With STABLE == false the PQs store plain TYPE elements and compare them with
+    'compare' alone, exactly as before: the policy is an empty class and every
+    call inlines away.
+
+    With STABLE == true every element is stored in a Slot next to the sequence
+    number of the push that created it, and elements that compare equal are
+    ordered by that number, so equal priorities come out first-in, first-out
+    (price-time priority). For integral keys under std::less / std::greater the
+    tie-break is folded into one branch-free expression instead of a second
+    call to 'compare'.
+
+*/
+
+#ifndef TIEBREAK_H
+#define TIEBREAK_H
+
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+// Unstable policy: slots are the elements themselves.
+template <typename TYPE, typename COMP_FUNCTOR, bool STABLE>
+class TieBreak
+{
+public:
+
+    using Slot = TYPE;
+
+    // Description: Wrap a newly pushed element for storage.
+    // Runtime: O(1)
+    const TYPE &wrap(const TYPE &val)
+    { return val; }
+    // wrap()
+
+
+    // Description: Access the element stored in a slot.
+    // Runtime: O(1)
+    static const TYPE &elt(const Slot &slot)
+    { return slot; }
+    // elt()
+
+
+    // Description: Is a lower priority than b?
+    // Runtime: O(1)
+    static bool lower(const COMP_FUNCTOR &compare, const Slot &a, const Slot &b)
+    { return compare(a, b); }
+    // lower()
+}; // TieBreak
+
+
+// Stable policy: slots carry the push sequence number, and among equal
+// elements the older one (smaller sequence number) has higher priority.
+template <typename TYPE, typename COMP_FUNCTOR>
+class TieBreak<TYPE, COMP_FUNCTOR, true>
+{
+public:
+
+    struct Slot
+    {
+        TYPE elt;
+        uint64_t seq;
+    };
+
+    // Description: Wrap a newly pushed element with the next sequence number.
+    // Runtime: O(1)
+    Slot wrap(const TYPE &val)
+    { return Slot{val, nextSeq++}; }
+    // wrap()
+
+
+    // Description: Access the element stored in a slot.
+    // Runtime: O(1)
+    static const TYPE &elt(const Slot &slot)
+    { return slot.elt; }
+    // elt()
+
+
+    // Description: Is a lower priority than b? Ties go to the older slot.
+    // Runtime: O(1), at most two calls to 'compare'.
+    static bool lower(const COMP_FUNCTOR &compare, const Slot &a, const Slot &b)
+    {
+        if constexpr (std::is_integral_v<TYPE> &&
+                      std::is_same_v<COMP_FUNCTOR, std::less<TYPE>>)
+            return (a.elt < b.elt) | ((a.elt == b.elt) & (a.seq > b.seq));
+        else if constexpr (std::is_integral_v<TYPE> &&
+                           std::is_same_v<COMP_FUNCTOR, std::greater<TYPE>>)
+            return (a.elt > b.elt) | ((a.elt == b.elt) & (a.seq > b.seq));
+        else
+        {
+            if (compare(a.elt, b.elt))
+                return true;
+            return !compare(b.elt, a.elt) && a.seq > b.seq;
+        }
+    } // lower()
+
+
+private:
+
+    uint64_t nextSeq = 0;
+}; // TieBreak
+
+#endif // TIEBREAK_H
@@ -0,0 +1,276 @@
+//  TieredSortedPQ.h
+//  p2b-priority-queues
+//
+
+/*
+
+    SortedPQ with its single sorted vector replaced by a tiered vector: a
+    vector of sorted blocks of about sqrt(n) elements each, which together
+    hold the elements in sorted order.
+
+    SortedPQ::push() pays an O(n) memmove to open a gap in the middle of the
+    vector. Here push() finds the block with a binary search over the block
+    backs, then opens the gap inside that block only, so the memmove is
+    O(sqrt n). A block that grows past twice its target size is split in two,
+    which moves O(sqrt n) elements plus O(n / sqrt n) block headers.
+
+    The most extreme element is still the last element of the last block,
+    so top() and pop() stay O(1), and iterating the blocks in order visits
+    the elements in sorted order.
+
+*/
+
+#ifndef TIEREDSORTEDPQ_H
+#define TIEREDSORTEDPQ_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include "Eecs281PQ.h"
+#include "SearchKernel.h"
+
+// A specialized version of the 'heap' ADT that is implemented with an
+// underlying tiered vector of sorted blocks.
+// With STABLE = true, elements of equal priority come out in FIFO order,
+// for the same reasons as in SortedPQ, and with the same caveat: after
+// updatePriorities(), new equals keep their old relative order.
+template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+         bool STABLE = false>
+class TieredSortedPQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
+{
+    // This is a way to refer to the base class object.
+    using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
+
+    using Block = std::vector<TYPE>;
+
+public:
+
+    // Forward iterator over the elements in sorted order, i.e. from the
+    // least extreme to the most extreme.
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TYPE;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const TYPE *;
+        using reference = const TYPE &;
+
+        const_iterator() = default;
+
+        reference operator*() const { return (*blocks)[block][offset]; }
+        pointer operator->() const { return &(*blocks)[block][offset]; }
+
+        const_iterator &operator++()
+        {
+            if (++offset == (*blocks)[block].size())
+            {
+                ++block;
+                offset = 0;
+            } // if
+            return *this;
+        } // operator++()
+
+        const_iterator operator++(int)
+        {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        } // operator++()
+
+        bool operator==(const const_iterator &other) const
+        { return block == other.block && offset == other.offset; }
+        bool operator!=(const const_iterator &other) const
+        { return !(*this == other); }
+
+    private:
+        friend class TieredSortedPQ;
+
+        const_iterator(const std::vector<Block> *b, std::size_t blk)
+        : blocks{ b }, block{ blk } {}
+
+        const std::vector<Block> *blocks = nullptr;
+        std::size_t block = 0;
+        std::size_t offset = 0;
+    }; // const_iterator
+
+
+    // Description: Construct an empty heap with an optional comparison functor.
+    // Runtime: O(1)
+    explicit TieredSortedPQ(COMP_FUNCTOR comp = COMP_FUNCTOR()) :
+    BaseClass{ comp }
+        {} // TieredSortedPQ
+
+
+    // Description: Construct a heap out of an iterator range with an optional
+    //              comparison functor.
+    // Runtime: O(n log n) where n is number of elements in range.
+    template<typename InputIterator>
+    TieredSortedPQ(InputIterator start, InputIterator end,
+            COMP_FUNCTOR comp = COMP_FUNCTOR()) :
+            BaseClass{ comp }
+    {
+        Block all{ start, end };
+
+        // the first element of the range is the oldest, so it belongs
+        // nearest the back among its equals
+        if constexpr (STABLE)
+            std::reverse(all.begin(), all.end());
+        rebuild(all);
+    } // TieredSortedPQ
+
+
+    // Description: Destructor doesn't need any code, the blocks will
+    //              be destroyed automatically.
+    virtual ~TieredSortedPQ()
+    {} // ~TieredSortedPQ()
+
+
+    // Description: Add a new element to the heap.
+    // Runtime: O(sqrt(n)) amortized
+    virtual void push(const TYPE &val)
+    {
+        ++numElts;
+        if (blocks.empty())
+        {
+            blocks.emplace_back(1, val);
+            return;
+        } // if
+
+        // The first block whose back is not less than val holds val's lower
+        // bound; if there is none, val goes at the very end.
+        auto blk = std::partition_point(blocks.begin(), blocks.end(),
+            [this, &val](const Block &b) { return this->compare(b.back(), val); });
+        if (blk == blocks.end())
+            --blk;
+
+        // insert val at its lower bound within the block
+        const TYPE *slot = fastLowerBound(blk->data(), blk->data() + blk->size(),
+                                          val, this->compare);
+        blk->insert(blk->begin() + (slot - blk->data()), val);
+
+        if (blk->size() > 2 * targetBlockSize())
+            split(static_cast<std::size_t>(blk - blocks.begin()));
+    } // push()
+
+
+    // Description: Remove the most extreme (defined by 'compare') element from
+    //              the heap.
+    // Runtime: O(1)
+    virtual void pop()
+    {
+        blocks.back().pop_back();
+        if (blocks.back().empty())
+            blocks.pop_back();
+        --numElts;
+    } // pop()
+
+
+    // Description: Return the most extreme (defined by 'compare') element of
+    //              the heap.
+    // Runtime: O(1)
+    virtual const TYPE &top() const
+    {
+        return blocks.back().back();
+    } // top()
+
+
+    // Description: Get the number of elements in the heap.
+    // Runtime: O(1)
+    virtual std::size_t size() const
+    {
+        return numElts;
+    } // size()
+
+
+    // Description: Return true if the heap is empty.
+    // Runtime: O(1)
+    virtual bool empty() const
+    {
+        return numElts == 0;
+    } // empty()
+
+
+    // Description: Assumes that all elements inside the heap are out of order and
+    //              'rebuilds' the heap by fixing the heap invariant.
+    // Runtime: O(n log n)
+    virtual void updatePriorities()
+    {
+        Block all;
+        all.reserve(numElts);
+        for (Block &b : blocks)
+            all.insert(all.end(), b.begin(), b.end());
+        rebuild(all);
+    } // updatePriorities()
+
+
+    // Description: Iterators over the elements in sorted order, least
+    //              extreme first, so the last element is top().
+    // Runtime: O(1)
+    const_iterator begin() const
+    { return const_iterator{ &blocks, 0 }; }
+    const_iterator end() const
+    { return const_iterator{ &blocks, blocks.size() }; }
+
+
+private:
+
+    // Blocks never go below this target size, so small heaps are a handful
+    // of plain vectors.
+    static constexpr std::size_t MIN_BLOCK_SIZE = 64;
+
+    // sorted, non-empty blocks; their concatenation is in sorted order
+    std::vector<Block> blocks;
+    std::size_t numElts = 0;
+
+
+    // Description: The size a block should have for the current n, about
+    //              sqrt(n), which balances the in-block memmove against the
+    //              number of block headers moved by a split.
+    std::size_t targetBlockSize() const
+    {
+        auto root = static_cast<std::size_t>(std::sqrt(static_cast<double>(numElts)));
+        return std::max(MIN_BLOCK_SIZE, root);
+    } // targetBlockSize()
+
+
+    // Description: Split block i into two halves, the upper one right after it.
+    // Runtime: O(sqrt(n))
+    void split(std::size_t i)
+    {
+        Block &full = blocks[i];
+        auto mid = full.begin() + static_cast<std::ptrdiff_t>(full.size() / 2);
+        Block upper{ std::make_move_iterator(mid), std::make_move_iterator(full.end()) };
+        full.erase(mid, full.end());
+        blocks.insert(blocks.begin() + static_cast<std::ptrdiff_t>(i) + 1, std::move(upper));
+    } // split()
+
+
+    // Description: Sort all the elements and cut them into blocks of the
+    //              target size.
+    // Runtime: O(n log n)
+    void rebuild(Block &all)
+    {
+        // sort, keeping the order of equals in stable mode
+        if constexpr (STABLE)
+            std::stable_sort(all.begin(), all.end(), this->compare);
+        else
+            std::sort(all.begin(), all.end(), this->compare);
+
+        blocks.clear();
+        numElts = all.size();
+        const std::size_t target = targetBlockSize();
+        for (std::size_t first = 0; first < all.size(); first += target)
+        {
+            auto from = all.begin() + static_cast<std::ptrdiff_t>(first);
+            auto to = all.begin() + static_cast<std::ptrdiff_t>(std::min(first + target, all.size()));
+            blocks.emplace_back(std::make_move_iterator(from), std::make_move_iterator(to));
+        } // for
+    } // rebuild()
+
+
+}; // TieredSortedPQ
+
+#endif // TIEREDSORTEDPQ_H
@@ -0,0 +1,189 @@
+//  TopK.h
+//  p2b-priority-queues
+//
+
+/*
+
+    The K most extreme elements of an unbounded stream, in O(K) memory and
+    O(n log K) time.
+
+    The tracker is a BoundedPQ ordered the other way round, so its top() is
+    the least extreme element kept, i.e. the K-th best so far. A new element
+    only gets in if it beats that one, and then takes its place in a single
+    O(log K) sift. Every other element is rejected after one comparison, and
+    on a long stream nearly all of them are.
+
+    offer_batch() takes a whole array. For arithmetic keys under std::less /
+    std::greater, each block of BLOCK elements first goes through the SIMD
+    max / min of ArgExtreme.h, and a block whose best element cannot beat
+    the K-th best is skipped without looking at its elements one by one.
+
+    snapshot() copies out the current top K, most extreme first. merge()
+    offers another tracker's elements to this one, so that trackers fed on
+    different threads can be combined at the end.
+
+*/
+
+#ifndef TOPK_H
+#define TOPK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "ArgExtreme.h"
+#include "BoundedPQ.h"
+
+// Tracks the K most extreme (defined by 'compare') elements offered to it.
+// K = 0 takes K as a constructor argument instead.
+template <typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>, std::size_t K = 0>
+class TopK
+{
+    // The kept elements, least extreme on top.
+    using Heap = BoundedPQ<TYPE, bounded::Lowest<TYPE, COMP_FUNCTOR>, K>;
+
+    // Plain arithmetic keys under std::less / std::greater can be filtered
+    // a block at a time with a vectorized max / min.
+    static constexpr bool VECTORIZE = argextreme::IS_SIMD<TYPE, COMP_FUNCTOR>;
+
+public:
+
+    // Description: Construct an empty tracker with a compile-time K and an
+    //              optional comparison functor.
+    // Runtime: O(1)
+    explicit TopK(COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : compare{ comp }, kept{ bounded::lowest<TYPE>(comp) }
+    {} // TopK
+
+
+    // Description: Construct an empty tracker for the k most extreme
+    //              elements, with an optional comparison functor. With
+    //              k = 0 every offer is rejected.
+    // Runtime: O(k)
+    explicit TopK(std::size_t k, COMP_FUNCTOR comp = COMP_FUNCTOR())
+        : compare{ comp }, kept{ k, bounded::lowest<TYPE>(comp) }
+    {} // TopK
+
+
+    // Description: Offer one element.
+    // Runtime: O(1) if it is rejected, O(log(K)) if it gets in
+    // Returns: true if val is now among the top K
+    bool offer(const TYPE &val)
+    {
+        if (!kept.full())
+            return kept.try_push(val);
+        // with K = 0 the tracker is full while empty, and there is no top
+        if (kept.empty() || !compare(kept.top(), val))
+            return false;
+        kept.replace_top(val);
+        return true;
+    } // offer()
+
+
+    // Description: Offer n elements in a row.
+    // Runtime: O(n log(K)) at worst, O(n) once few elements get in
+    void offer_batch(const TYPE *vals, std::size_t n)
+    {
+        if (kept.capacity() == 0)
+            return;
+
+        std::size_t i = 0;
+        if constexpr (VECTORIZE)
+        {
+            // fill up first, so that there is a K-th best to filter against
+            for (; i < n && !kept.full(); ++i)
+                kept.try_push(vals[i]);
+
+            for (; i + BLOCK <= n; i += BLOCK)
+            {
+                TYPE best = argextreme::extremeValue<TYPE, COMP_FUNCTOR>(vals + i, BLOCK);
+                if (!compare(kept.top(), best))
+                    continue;
+                for (std::size_t j = i; j < i + BLOCK; ++j)
+                    offer(vals[j]);
+            } // for
+        } // if
+
+        for (; i < n; ++i)
+            offer(vals[i]);
+    } // offer_batch()
+
+
+    // Description: Offer every element another tracker holds, e.g. one that
+    //              was fed on another thread.
+    // Runtime: O(K log(K))
+    void merge(const TopK &other)
+    {
+        for (const TYPE &val : other.kept.heap_order())
+            offer(val);
+    } // merge()
+
+
+    // Description: Copies of the elements kept, most extreme first.
+    // Runtime: O(K log(K))
+    std::vector<TYPE> snapshot() const
+    {
+        std::span<const TYPE> heap = kept.heap_order();
+        std::vector<TYPE> best(heap.begin(), heap.end());
+        std::sort(best.begin(), best.end(),
+                  [this](const TYPE &a, const TYPE &b) { return compare(b, a); });
+        return best;
+    } // snapshot()
+
+
+    // Description: The least extreme element kept, which a new element has
+    //              to beat once the tracker is full. The tracker must not be
+    //              empty.
+    // Runtime: O(1)
+    const TYPE &threshold() const
+    {
+        return kept.top();
+    } // threshold()
+
+
+    // Description: How many elements are kept, at most K.
+    // Runtime: O(1)
+    std::size_t size() const
+    {
+        return kept.size();
+    } // size()
+
+
+    // Description: Is K, the most elements the tracker keeps.
+    // Runtime: O(1)
+    std::size_t capacity() const
+    {
+        return kept.capacity();
+    } // capacity()
+
+
+    // Description: Return true once K elements are kept.
+    // Runtime: O(1)
+    bool full() const
+    {
+        return kept.full();
+    } // full()
+
+
+    // Description: Forget every element.
+    // Runtime: O(1)
+    void clear()
+    {
+        kept.clear();
+    } // clear()
+
+
+private:
+
+    // Elements per block in the vectorized filter.
+    static constexpr std::size_t BLOCK = 64;
+
+    COMP_FUNCTOR compare;
+    Heap kept;
+
+
+}; // TopK
+
+#endif // TOPK_H
@@ -2,8 +2,16 @@
 #define UNORDEREDFASTPQ_H
 
 #include "Eecs281PQ.h"
+#include "SmallVector.h"
+#include "TieBreak.h"
+#include "ArgExtreme.h"
+#include "Parallel.h"
 
+#include <algorithm>
+#include <functional>
 #include <limits>  // needed for UNKNOWN
+#include <type_traits>
+#include <vector>
 
 static const size_t UNKNOWN = std::numeric_limits<size_t>::max();
 
@@ -16,16 +24,31 @@ static const size_t UNKNOWN = std::numeric_limits<size_t>::max();
 // the most extreme element, it remembers that index so that pop() does
 // does not have to search again.  Note the use of the mutable variable.
 
+// The search actually remembers the CANDIDATES most extreme elements, best
+// first, and every element outside that set is no more extreme than the
+// last candidate. A push only has to compare against the last candidate to
+// keep this true, and a pop just moves on to the next candidate, so the
+// O(n) search runs once every CANDIDATES pops instead of on every pop.
+
 // TODO: Read and understand this priority queue implementation!
 // Pay particular attention to how the constructors and findExtreme()
 // are written, especially the use of this->compare.
 
-template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+// With STABLE = true, elements of equal priority come out in FIFO order.
+// With INLINE > 0, the first INLINE elements are stored inside the object,
+// so a queue that never grows past that never allocates.
+
+template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+         bool STABLE = false, std::size_t INLINE = 0>
 class UnorderedFastPQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
 {
     // This is a way to refer to the base class object.
     using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
 
+    // Tie-break policy, and what the vector stores per element.
+    using Ties = TieBreak<TYPE, COMP_FUNCTOR, STABLE>;
+    using Slot = typename Ties::Slot;
+
 public:
     
     // default ctor
@@ -42,8 +65,11 @@ public:
     // Runtime: O(n) where n is number of elements in range.
     template<typename InputIterator>
     UnorderedFastPQ(InputIterator start, InputIterator end, COMP_FUNCTOR comp = COMP_FUNCTOR()) :
-        BaseClass{ comp }, data{ start, end }, extreme{ UNKNOWN }
-    {} // UnorderedFastPQ()
+        BaseClass{ comp }, extreme{ UNKNOWN }
+    {
+        while (start != end)
+            data.push_back(ties.wrap(*start++));
+    } // UnorderedFastPQ()
 
 
     // Description: Destructor doesn't need any code, the data vector will
@@ -65,11 +91,30 @@ public:
     // Runtime: Amortized O(1)
     virtual void push(const TYPE &val)
     {
-        data.push_back(val);
-
-        // Since a new element has been added, we no longer know where to find
-        // the most extreme element.
-        extreme = UNKNOWN;
+        data.push_back(ties.wrap(val));
+        size_t index = data.size() - 1;
+
+        // The first element is the whole candidate set.
+        if (index == 0)
+        {
+            candidates.assign(1, index);
+            extreme = index;
+            return;
+        } // if
+
+        // If we know the candidates, the new element joins them when it beats
+        // the last one, or when every other element is a candidate already.
+        if (extreme == UNKNOWN)
+            return;
+        if (candidates.size() == index && candidates.size() < CANDIDATES)
+            insertCandidate(index, candidates);
+        else if (isLower(data[candidates.back()], data[index]))
+        {
+            insertCandidate(index, candidates);
+            if (candidates.size() > CANDIDATES)
+                candidates.pop_back();
+        } // else if
+        extreme = candidates.front();
     } // push()
 
 
@@ -78,7 +123,7 @@ public:
     // Note: We will not run tests on your code that would require it to pop an
     // element when the heap is empty. Though you are welcome to if you are
     // familiar with them, you do not need to use exceptions in this project.
-    // Runtime: O(n)
+    // Runtime: O(n / CANDIDATES) amortized
     // Note: If the most extreme element is already known (as would happen if
     //       .top() was called before .pop()), this function is O(1).
     virtual void pop()
@@ -86,16 +131,22 @@ public:
         // If we don't already know the index of the most extreme element, find it.
         if (extreme == UNKNOWN)
             findExtreme();
+        candidates.erase(candidates.begin());
 
         // Replace the most extreme element with the element at the back, then
         // pop_back().  This is much faster than erasing from the middle of a
-        // vector.
-        data[extreme] = data.back();
+        // vector.  A candidate at the back moves along with it.
+        size_t last = data.size() - 1;
+        if (extreme != last)
+        {
+            data[extreme] = data.back();
+            std::replace(candidates.begin(), candidates.end(), last, extreme);
+        } // if
         data.pop_back();
 
-        // Since the most extreme element has been removed, we no longer know
-        // where to find it.
-        extreme = UNKNOWN;
+        // The next candidate is the new most extreme element; once they run
+        // out, we no longer know where to find it.
+        extreme = candidates.empty() ? UNKNOWN : candidates.front();
     } // pop()
 
 
@@ -103,7 +154,7 @@ public:
     //              the vector.  This should be a reference for speed.  It MUST
     //              be const because we cannot allow it to be modified, as that
     //              might make it no longer be the most extreme element.
-    // Runtime: O(n)
+    // Runtime: O(1), O(n) when the candidates have run out
     virtual const TYPE &top() const
     {
         // If we don't already know the index of the most extreme element, find it.
@@ -111,7 +162,7 @@ public:
             findExtreme();
 
         // Return the most extreme element by const reference.
-        return data[extreme];
+        return Ties::elt(data[extreme]);
     } // top()
 
 
@@ -133,27 +184,121 @@ public:
 private:
     
     // Note: This vector *must* be used for your heap implementation.
-    std::vector<TYPE> data;
+    InlineStorage<Slot, INLINE> data;
+
+    // Hands out sequence numbers in stable mode; empty otherwise.
+    [[no_unique_address]] Ties ties;
 
 private:
+
+    // How many of the most extreme elements a search remembers.
+    static constexpr size_t CANDIDATES = 8;
+
+    // Elements per block in the vectorized search.
+    static constexpr size_t BLOCK = 64;
+
+    // Plain arithmetic keys under std::less / std::greater can be searched
+    // a block at a time with a vectorized max / min.
+    static constexpr bool VECTORIZE = !STABLE && std::is_arithmetic_v<TYPE> &&
+        (std::is_same_v<COMP_FUNCTOR, std::less<TYPE>> ||
+         std::is_same_v<COMP_FUNCTOR, std::greater<TYPE>>);
     
     // A member variable that can be changed by a const member function;
     // stores the index of the most extreme element, or UNKNOWN.
     mutable size_t extreme;
 
-    // Description: Find the 'most extreme' element of the data vector, using
-    //              this->compare() to check if one element is 'less than'
-    //              another.
-    // Runtime: O(n)
-    void findExtreme() const
+    // Indices of the most extreme elements, best first; only meaningful
+    // while extreme != UNKNOWN. A push briefly adds one more before the
+    // last is dropped. The set is small and bounded, so it is kept inline.
+    using Candidates = SmallVector<size_t, CANDIDATES + 1>;
+    mutable Candidates candidates;
+
+
+    // Is a lower priority than b? Plain this->compare unless STABLE,
+    // in which case ties go to the element pushed first.
+    bool isLower(const Slot &a, const Slot &b) const
+    {
+        return Ties::lower(this->compare, a, b);
+    } // isLower()
+
+
+    // Description: Insert index into cands, keeping them best first.
+    // Runtime: O(CANDIDATES)
+    void insertCandidate(size_t index, Candidates &cands) const
     {
-        size_t index = 0;
+        auto slot = std::find_if(cands.begin(), cands.end(),
+            [this, index](size_t c) { return isLower(data[c], data[index]); });
+        cands.insert(slot, index);
+    } // insertCandidate()
 
-        for (size_t i = 1; i < data.size(); ++i)
-            if (this->compare(data[index], data[i]))
-                index = i;
 
-        extreme = index;
+    // Description: Offer data[i] to the candidates cands found so far.
+    // Runtime: O(1) unless it gets in, O(CANDIDATES) if it does.
+    void consider(size_t i, Candidates &cands) const
+    {
+        if (cands.size() < CANDIDATES)
+            insertCandidate(i, cands);
+        else if (isLower(data[cands.back()], data[i]))
+        {
+            cands.pop_back();
+            insertCandidate(i, cands);
+        } // else if
+    } // consider()
+
+
+    // Description: Find the CANDIDATES 'most extreme' elements of
+    //              data[first, last) into cands.
+    // Runtime: O(last - first)
+    void searchRange(size_t first, size_t last, Candidates &cands) const
+    {
+        cands.clear();
+        size_t i = first;
+
+        if constexpr (VECTORIZE)
+        {
+            // Once the candidates are full, a block whose best element cannot
+            // beat the last candidate is skipped after a SIMD max/min.
+            for (; i + BLOCK <= last; i += BLOCK)
+            {
+                TYPE best = argextreme::extremeValue<TYPE, COMP_FUNCTOR>(&data[i], BLOCK);
+                if (cands.size() == CANDIDATES && !this->compare(data[cands.back()], best))
+                    continue;
+                for (size_t j = i; j < i + BLOCK; ++j)
+                    consider(j, cands);
+            } // for
+        } // if
+
+        for (; i < last; ++i)
+            consider(i, cands);
+    } // searchRange()
+
+
+    // Description: Find the CANDIDATES 'most extreme' elements of the data
+    //              vector, using this->compare() to check if one element is
+    //              'less than' another, and the most extreme of them. Large
+    //              vectors are split across threads, and the candidates of
+    //              the whole vector are the best of each slice's candidates.
+    // Runtime: O(n)
+    void findExtreme() const
+    {
+        const size_t n = data.size();
+        const size_t threads = parallel::threadsFor(n);
+        if (threads < 2)
+            searchRange(0, n, candidates);
+        else
+        {
+            const size_t slice = (n + threads - 1) / threads;
+            std::vector<Candidates> found(threads);
+            parallel::run(threads, [this, &found, slice, n](size_t t)
+            { searchRange(t * slice, std::min(n, (t + 1) * slice), found[t]); });
+
+            candidates.clear();
+            for (const Candidates &cands : found)
+                for (size_t i : cands)
+                    consider(i, candidates);
+        } // else
+
+        extreme = candidates.front();
     } // findExtreme()
 }; // UnorderedFastPQ
 
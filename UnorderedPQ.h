@@ -200,6 +200,8 @@
 #define UNORDEREDPQ_H
 
 #include "Eecs281PQ.h"
+#include "ArgExtreme.h"
+#include "TieBreak.h"
 
 
 // A specialized version of the 'heap' ADT that is implemented with an
@@ -210,12 +212,19 @@
 // Pay particular attention to how the constructors and findExtreme()
 // are written, especially the use of this->compare.
 
-template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>>
+// With STABLE = true, elements of equal priority come out in FIFO order.
+
+template<typename TYPE, typename COMP_FUNCTOR = std::less<TYPE>,
+         bool STABLE = false>
 class UnorderedPQ : public Eecs281PQ<TYPE, COMP_FUNCTOR>
 {
     // This is a way to refer to the base class object.
     using BaseClass = Eecs281PQ<TYPE, COMP_FUNCTOR>;
 
+    // Tie-break policy, and what the vector stores per element.
+    using Ties = TieBreak<TYPE, COMP_FUNCTOR, STABLE>;
+    using Slot = typename Ties::Slot;
+
 public:
     
     // default ctor
@@ -233,8 +242,11 @@ public:
     template<typename InputIterator>
     UnorderedPQ(InputIterator start, InputIterator end,
                 COMP_FUNCTOR comp = COMP_FUNCTOR()) : 
-        BaseClass{ comp }, data{ start, end }
-    {} // UnorderedPQ()
+        BaseClass{ comp }
+    {
+        while (start != end)
+            data.push_back(ties.wrap(*start++));
+    } // UnorderedPQ()
 
 
     // Description: Destructor doesn't need any code, the data vector will
@@ -254,7 +266,7 @@ public:
     // Runtime: Amortized O(1)
     virtual void push(const TYPE &val)
     {
-        data.push_back(val);
+        data.push_back(ties.wrap(val));
         
         // if this was an ordered pq we would call fixUp(data, data.size()) here to
         // to maintain the sorting invariants, which would be O(log n).
@@ -292,7 +304,7 @@ public:
     virtual const TYPE &top() const
     {
         // Find the most extreme element and return it by const reference.
-        return data[findExtreme()];
+        return Ties::elt(data[findExtreme()]);
     } // top()
 
 
@@ -314,7 +326,10 @@ public:
 private:
     
     // Note: This vector *must* be used for your heap implementation.
-    std::vector<TYPE> data;
+    std::vector<Slot> data;
+
+    // Hands out sequence numbers in stable mode; empty otherwise.
+    [[no_unique_address]] Ties ties;
 
 private:
     
@@ -324,13 +339,14 @@ private:
     // Runtime: O(n)
     size_t findExtreme() const
     {
-        size_t index = 0;
-
-        for (size_t i = 1; i < data.size(); ++i)
-            if (this->compare(data[index], data[i]))
-                index = i;
-
-        return index;
+        // SIMD, multi-chunk or multithreaded, depending on TYPE and n; slots
+        // with sequence numbers always take the multi-chunk scan
+        if constexpr (STABLE)
+            return argExtreme(data.data(), data.size(),
+                              [this](const Slot &a, const Slot &b)
+                              { return Ties::lower(this->compare, a, b); });
+        else
+            return argExtreme(data.data(), data.size(), this->compare);
     } // findExtreme()
 }; // UnorderedPQ
 
@@ -1,21 +1,37 @@
 #ifndef BIN_PQ_H
 #define BIN_PQ_H
 
+#include "Parallel.h"
 #include "SPsPQ.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 /// @brief A binary heap implementation of a priority queue.
 /// @tparam T: The type of the elements in the queue.
 /// @tparam Compare: The comparison functor to use for the priority queue.
+/// @tparam Stable: If true, elements of equal priority are popped in the
+///                 order they were pushed (FIFO).
 /// @note This implementation uses a vector to store the elements, and 
 ///       a heap property to maintain the order of the elements.
 ///       The heap property is maintained by the topDown() and bottomUp() 
 ///       functions.
-template <typename T, typename Compare = std::less<T>>
+template <typename T, typename Compare = std::less<T>, bool Stable = false>
 class BinPQ : public SPsPQ<T, Compare>
 {
     using BaseClass = SPsPQ<T, Compare>;
 
+    /// @brief In stable mode each element is stored with the sequence
+    ///        number of its push, which breaks ties between equal elements.
+    struct Stamped
+    {
+        T value;
+        uint64_t seq;
+    };
+    using Slot = std::conditional_t<Stable, Stamped, T>;
+
 public:
 
     // Default constructor
@@ -29,15 +45,20 @@ public:
     template <typename Iterator>
     BinPQ(Iterator begin, Iterator end, 
         const Compare &comp = Compare())
-            : BaseClass(comp), data(begin, end) 
-    { updatePQ(); }
+            : BaseClass(comp)
+    {
+        while (begin != end)
+            data.push_back(wrap(*begin++));
+        updatePQ();
+    }
     // R-B CTOR
 
 
     // Copy constructor
     BinPQ(const BinPQ& other) 
         : BaseClass(other), 
-        data(other.data) 
+        data(other.data),
+        nextSeq(other.nextSeq)
     {}
     // COPY CTOR
 
@@ -46,7 +67,8 @@ public:
     BinPQ(BinPQ&& other) noexcept
         : BaseClass(
             std::move(other)),      // move the entire base class
-        data(std::move(other.data)) // move the derived class's vector
+        data(std::move(other.data)), // move the derived class's vector
+        nextSeq(other.nextSeq)
     {}
     // MOVE CTOR
 
@@ -60,6 +82,7 @@ public:
             // then assign the derived class's vector.
             BaseClass::operator=(other);
             data = other.data;
+            nextSeq = other.nextSeq;
         }
 
         // Return the current BinPQ object.
@@ -74,6 +97,7 @@ public:
         {
             BaseClass::operator=(std::move(other));
             data = std::move(other.data);
+            nextSeq = other.nextSeq;
         }
 
         return *this;
@@ -85,17 +109,57 @@ public:
 
 
     /// @brief Update the priority queue to maintain the heap property.
+    ///        Large heaps are rebuilt on several threads.
+    void updatePQ() override
+    { 
+        updatePQ(parallel::threadsFor(getSize()));
+    } // updatePQ()
+
+
+    /// @brief updatePQ() on the given number of threads. The subtrees
+    ///        below one level of the heap are heapified in parallel, then
+    ///        the levels above them on this thread. Heapifying disjoint
+    ///        subtrees commutes, so the heap comes out slot for slot the
+    ///        same as the serial rebuild.
+    /// @param threads: Number of threads; 1 rebuilds serially.
     /// @note This function uses a post-decrement approach to overcome 
     ///       unsigned integer overflow and the use of static_cast. 
     ///       Read more about it in the notes!
-    void updatePQ() override
-    { 
+    void updatePQ(std::size_t threads)
+    {
         if (getSize() <= 1) return;
 
-        // Start from last non-leaf node and sift down each node
+        // Split at the first level with four subtrees per thread, so that
+        // uneven bottom levels even out. Counting nodes from 1 there, the
+        // nodes k levels below [first, last) are [first << k, last << k).
+        std::size_t roots = 1;
+        while (roots < 4 * threads)
+            roots *= NUM_CHILDREN;
         const size_t lastParentIdx = getParentIndex(getSize() - 1);
-        for (size_t i = (lastParentIdx + 1); i-- > ROOT;)
-            topDown(i); 
+
+        if (threads < 2 || roots > lastParentIdx + 1)
+        {
+            // Start from last non-leaf node and sift down each node
+            for (size_t i = (lastParentIdx + 1); i-- > ROOT;)
+                topDown(i); 
+            return;
+        }
+
+        parallel::run(threads, [this, roots, threads, lastParentIdx](std::size_t t) {
+            const std::size_t first = roots + roots * t / threads;
+            const std::size_t last = roots + roots * (t + 1) / threads;
+            std::size_t depth = 0;
+            while ((first << (depth + 1)) <= lastParentIdx + 1)
+                ++depth;
+
+            // deepest level first; node i counted from 1 is slot i - 1
+            for (std::size_t k = depth + 1; k-- > 0;)
+                for (std::size_t i = std::min(last << k, lastParentIdx + 2); i-- > (first << k);)
+                    topDown(i - 1);
+        });
+
+        for (size_t i = roots - 1; i-- > ROOT;)
+            topDown(i);
     } // updatePQ()
 
 
@@ -106,7 +170,7 @@ public:
     /// @param value: The value to push into the queue.
     void push(const T &value) override
     {
-        data.push_back(value);
+        data.push_back(wrap(value));
         bottomUp(getSize() - 1); 
     } // push()
 
@@ -125,13 +189,27 @@ public:
 
 
 
+    /// @brief Replace the top element with a new value, and call
+    ///        topDown() once to restore the heap property. This
+    ///        is a pop() followed by a push() in a single sift.
+    /// @param value: The value that replaces the top.
+    void replace_top(const T &value)
+    {
+        if (isEmpty())
+            throw std::runtime_error("Priority queue is empty");
+        data[ROOT] = wrap(value);
+        topDown(ROOT);
+    } // replace_top()
+
+
+
     /// @brief Get the top element (highest priority)
     /// @return The top element of the queue.
     const T &getTop() const override
     {
         if (isEmpty())
             throw std::runtime_error("Priority queue is empty");
-        return data[ROOT]; // Root is always the top in a binary heap
+        return valueOf(data[ROOT]); // Root is always the top in a binary heap
     } // getTop()
 
 
@@ -157,7 +235,34 @@ private:
     static constexpr size_t NUM_CHILDREN = 2;
     
     /// @brief Heap container
-    std::vector<T> data;
+    std::vector<Slot> data;
+
+    /// @brief Next push sequence number (only used in stable mode)
+    uint64_t nextSeq = 0;
+
+
+    /// @brief Wrap a value for storage, stamping it in stable mode.
+    /// @param value: The value being pushed.
+    /// @return The slot to store in the heap.
+    Slot wrap(const T &value)
+    {
+        if constexpr (Stable)
+            return Slot{value, nextSeq++};
+        else
+            return value;
+    } // wrap()
+
+
+    /// @brief The value stored in a slot.
+    /// @param slot: A slot of the heap.
+    /// @return The element held by the slot.
+    static const T &valueOf(const Slot &slot)
+    {
+        if constexpr (Stable)
+            return slot.value;
+        else
+            return slot;
+    } // valueOf()
 
 
     /// @brief Helper to calculate parent index
@@ -185,12 +290,20 @@ private:
 
 
     /// @brief Helper to check if compareFunctor says a < b 
-    ///         (a has lower priority than b)
+    ///         (a has lower priority than b). In stable mode, equal
+    ///         elements are ordered by push, the older one first.
     /// @param a: The first element to compare.
     /// @param b: The second element to compare.
     /// @return True if a has lower priority than b, false otherwise.
-    bool hasLowerPriority(const T& a, const T& b) const {
-        return this->compareFunctor(a, b);
+    bool hasLowerPriority(const Slot& a, const Slot& b) const {
+        if constexpr (Stable)
+        {
+            if (this->compareFunctor(a.value, b.value))
+                return true;
+            return !this->compareFunctor(b.value, a.value) && a.seq > b.seq;
+        }
+        else
+            return this->compareFunctor(a, b);
     } // hasLowerPriority()
 
 
@@ -0,0 +1,205 @@
+#ifndef EPOCH_RECLAIMER_H
+#define EPOCH_RECLAIMER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Epoch-based memory reclamation for lock-free structures.
+/// @note A thread reads shared nodes only inside an epoch::Guard. A node
+///       that has been unlinked, so that no new reader can reach it, is
+///       handed to retire() instead of being deleted, and is freed once
+///       every thread that might still be reading it has left its guard.
+///
+///       The domain keeps a global epoch. Each thread records the epoch it
+///       saw when it entered its guard. The epoch moves from e to e + 1
+///       only when every thread inside a guard has seen e, so a node
+///       retired during epoch r is unreachable by every guard once the
+///       epoch reaches r + 2.
+///
+///       There is one domain for the whole process. Each thread gets a
+///       record on its first guard and gives it back when it exits; a later
+///       thread takes the record over, along with any nodes it still had
+///       to free.
+namespace epoch
+{
+
+/// @brief A node waiting to be freed, and how to free it.
+struct Retired
+{
+    void *ptr;
+    void (*deleter)(void *);
+    std::uint64_t epoch;
+};
+
+
+/// @brief One thread's view of the domain. Records are never freed before
+///        the program ends, so the list of them only grows.
+struct Record
+{
+    std::atomic<std::uint64_t> epoch{ 0 };
+    std::atomic<bool> active{ false };
+    std::atomic<bool> inUse{ true };
+    Record *next = nullptr;
+
+    // Only the owning thread touches these.
+    unsigned depth = 0;
+    std::vector<Retired> limbo;
+    std::size_t sinceScan = 0;
+};
+
+
+/// @brief The process-wide domain: the global epoch and every record.
+class Domain
+{
+public:
+
+    /// @brief Try to advance the epoch after this many retire() calls.
+    static constexpr std::size_t SCAN_INTERVAL = 64;
+
+
+    static Domain &instance()
+    {
+        static Domain domain;
+        return domain;
+    }
+
+
+    // Frees every record, and whatever they still had to free, at exit.
+    ~Domain()
+    {
+        Record *rec = records.load();
+        while (rec)
+        {
+            Record *next = rec->next;
+            for (const Retired &node : rec->limbo)
+                node.deleter(node.ptr);
+            delete rec;
+            rec = next;
+        }
+    }
+
+
+    /// @brief Claim a record for the calling thread: a free one if there is
+    ///        one, otherwise a new one.
+    Record *acquire()
+    {
+        for (Record *rec = records.load(); rec; rec = rec->next)
+        {
+            bool expected = false;
+            if (!rec->inUse.load(std::memory_order_relaxed) &&
+                rec->inUse.compare_exchange_strong(expected, true))
+                return rec;
+        }
+
+        Record *rec = new Record;
+        rec->next = records.load();
+        while (!records.compare_exchange_weak(rec->next, rec))
+        {}
+        return rec;
+    }
+
+
+    /// @brief Give a record back when its thread exits.
+    void release(Record *rec)
+    {
+        scan(*rec);
+        rec->inUse.store(false);
+    }
+
+
+    /// @brief Free what rec retired at least two epochs ago, after trying
+    ///        to advance the epoch.
+    void scan(Record &rec)
+    {
+        tryAdvance();
+        const std::uint64_t now = globalEpoch.load();
+        auto keep = std::partition(rec.limbo.begin(), rec.limbo.end(),
+            [now](const Retired &node) { return node.epoch + 2 > now; });
+        for (auto it = keep; it != rec.limbo.end(); ++it)
+            it->deleter(it->ptr);
+        rec.limbo.erase(keep, rec.limbo.end());
+        rec.sinceScan = 0;
+    }
+
+
+    std::atomic<std::uint64_t> globalEpoch{ 1 };
+
+private:
+
+    std::atomic<Record *> records{ nullptr };
+
+
+    /// @brief Advance the epoch if every thread inside a guard has seen it.
+    void tryAdvance()
+    {
+        std::uint64_t now = globalEpoch.load();
+        for (Record *rec = records.load(); rec; rec = rec->next)
+            if (rec->active.load() && rec->epoch.load() != now)
+                return;
+        globalEpoch.compare_exchange_strong(now, now + 1);
+    }
+}; // class Domain
+
+
+/// @brief The calling thread's record, claimed on first use and given back
+///        when the thread exits.
+inline Record &local()
+{
+    struct Owner
+    {
+        Record *rec = Domain::instance().acquire();
+        ~Owner() { Domain::instance().release(rec); }
+    };
+    thread_local Owner owner;
+    return *owner.rec;
+}
+
+
+/// @brief Marks the calling thread as reading shared nodes for its
+///        lifetime. Guards may nest.
+class Guard
+{
+public:
+
+    Guard() : rec(local())
+    {
+        if (rec.depth++ == 0)
+        {
+            rec.epoch.store(Domain::instance().globalEpoch.load());
+            rec.active.store(true);
+        }
+    }
+
+
+    ~Guard()
+    {
+        if (--rec.depth == 0)
+            rec.active.store(false, std::memory_order_release);
+    }
+
+
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+
+private:
+
+    Record &rec;
+}; // class Guard
+
+
+/// @brief Free node with deleter once no guard can still be reading it.
+///        node must already be unreachable for threads entering a guard.
+inline void retire(void *node, void (*deleter)(void *))
+{
+    Record &rec = local();
+    rec.limbo.push_back({ node, deleter, Domain::instance().globalEpoch.load() });
+    if (++rec.sinceScan >= Domain::SCAN_INTERVAL)
+        Domain::instance().scan(rec);
+}
+
+} // namespace epoch
+
+#endif // EPOCH_RECLAIMER_H
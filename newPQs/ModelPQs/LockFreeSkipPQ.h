@@ -0,0 +1,333 @@
+#ifndef LOCK_FREE_SKIP_PQ_H
+#define LOCK_FREE_SKIP_PQ_H
+
+#include "EpochReclaimer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+/// @brief A linearizable lock-free priority queue: the skiplist of Lindén
+///        and Jonsson, "A Skiplist-Based Concurrent Priority Queue with
+///        Minimal Memory Contention" (2013).
+/// @tparam T: The type of the elements in the queue.
+/// @tparam Compare: The comparison functor to use for the priority queue.
+/// @tparam BoundOffset: How many logically deleted nodes a pop walks past
+///                      before it unlinks them in one batch.
+/// @note The elements sit in a skiplist ordered from most to least extreme,
+///       after the equal elements already in it. A pop deletes the first
+///       live node logically, by setting the mark bit of its predecessor's
+///       level-0 pointer with one fetch_or. The deleted nodes thus form a
+///       prefix of the list, and pushes always link in after it, so pops
+///       and pushes only meet at the front when the queue is nearly empty.
+///
+///       Pops do not unlink nodes one by one. Once a pop has walked past
+///       BoundOffset deleted nodes, it swings the head past the whole
+///       prefix with one CAS, repairs the upper levels of the head, and
+///       retires the prefix to the epoch reclaimer, which frees it once no
+///       thread can still be reading it.
+///
+///       Every call is a lock-free, linearizable operation. top() followed
+///       by pop() would not be one, so the queue offers try_pop() and
+///       try_top(), which report an empty queue instead of throwing.
+template <typename T, typename Compare = std::less<T>, std::size_t BoundOffset = 32>
+class LockFreeSkipPQ
+{
+public:
+
+    // Default constructor
+    explicit LockFreeSkipPQ(const Compare &comp = Compare())
+        : compareFunctor{ comp },
+          tail{ new Node(MaxLevel) },
+          head{ new Node(MaxLevel) }
+    {
+        for (std::size_t i = 0; i < MaxLevel; ++i)
+            head->next[i].store(ref(tail), std::memory_order_relaxed);
+    }
+    // DEFAULT CTOR
+
+
+    // Range-based constructor
+    template <typename Iterator>
+    LockFreeSkipPQ(Iterator begin, Iterator end, const Compare &comp = Compare())
+        : LockFreeSkipPQ(comp)
+    {
+        while (begin != end)
+            push(*begin++);
+    }
+    // R-B CTOR
+
+
+    // The nodes are shared with other threads, so the queue is not copied.
+    LockFreeSkipPQ(const LockFreeSkipPQ &) = delete;
+    LockFreeSkipPQ &operator=(const LockFreeSkipPQ &) = delete;
+
+
+    /// @brief Frees every node still linked. No other thread may be using
+    ///        the queue; nodes already retired are left to the reclaimer.
+    ~LockFreeSkipPQ()
+    {
+        Node *cur = head;
+        while (cur != tail)
+        {
+            Node *next = node(cur->next[0].load(std::memory_order_relaxed));
+            delete cur;
+            cur = next;
+        }
+        delete tail;
+    }
+    // DTOR
+
+
+    /// @brief Insert value after every element at least as extreme.
+    void push(const T &value)
+    {
+        epoch::Guard guard;
+        const std::size_t height = randomLevel();
+        Node *fresh = new Node(height, value);
+        Node *preds[MaxLevel];
+        Node *succs[MaxLevel];
+
+        // level 0 decides membership
+        Node *del;
+        for (;;)
+        {
+            del = locatePreds(value, preds, succs);
+            fresh->next[0].store(ref(succs[0]), std::memory_order_relaxed);
+            std::uintptr_t expected = ref(succs[0]);
+            if (preds[0]->next[0].compare_exchange_strong(expected, ref(fresh)))
+                break;
+        }
+        count.fetch_add(1, std::memory_order_relaxed);
+
+        // the upper levels are only shortcuts; give up on them once the new
+        // node or its successor is being deleted
+        for (std::size_t i = 1; i < height;)
+        {
+            fresh->next[i].store(ref(succs[i]), std::memory_order_relaxed);
+            if (isMarked(fresh->next[0].load()) || isMarked(succs[i]->next[0].load()) ||
+                succs[i] == del)
+                break;
+            std::uintptr_t expected = ref(succs[i]);
+            if (preds[i]->next[i].compare_exchange_strong(expected, ref(fresh)))
+                ++i;
+            else
+            {
+                del = locatePreds(value, preds, succs);
+                if (succs[0] != fresh)
+                    break;
+            }
+        }
+        fresh->inserting.store(false, std::memory_order_release);
+    }
+
+
+    /// @brief Remove the most extreme element and copy it into out.
+    /// @return false, leaving out alone, if the queue was empty.
+    bool try_pop(T &out)
+    {
+        epoch::Guard guard;
+        Node *x = head;
+        Node *newHead = nullptr;
+        const std::uintptr_t observedHead = head->next[0].load();
+        std::size_t offset = 0;
+        std::uintptr_t nxt;
+
+        // walk the deleted prefix, and mark the first live node deleted;
+        // fetch_or returns a marked pointer if another pop got there first
+        for (;;)
+        {
+            nxt = x->next[0].load();
+            if (node(nxt) == tail)
+                return false;
+            if (!newHead && x->inserting.load(std::memory_order_acquire))
+                newHead = x;
+            if (!isMarked(nxt))
+                nxt = x->next[0].fetch_or(MarkBit);
+            ++offset;
+            x = node(nxt);
+            if (!isMarked(nxt))
+                break;
+        }
+
+        out = x->value;
+        count.fetch_sub(1, std::memory_order_relaxed);
+        if (!newHead)
+            newHead = x;
+
+        // unlink the prefix in one batch, once it is long enough
+        if (offset <= BoundOffset || head->next[0].load() != observedHead)
+            return true;
+        std::uintptr_t expected = observedHead;
+        if (head->next[0].compare_exchange_strong(expected, ref(newHead) | MarkBit))
+        {
+            restructure();
+            Node *cur = node(observedHead);
+            while (cur != newHead)
+            {
+                Node *next = node(cur->next[0].load());
+                epoch::retire(cur, [](void *dead) { delete static_cast<Node *>(dead); });
+                cur = next;
+            }
+        }
+        return true;
+    }
+
+
+    /// @brief Copy the most extreme element into out, without removing it.
+    /// @return false, leaving out alone, if the queue was empty.
+    bool try_top(T &out) const
+    {
+        epoch::Guard guard;
+        Node *x = head;
+        std::uintptr_t nxt = x->next[0].load();
+        while (isMarked(nxt))
+        {
+            x = node(nxt);
+            nxt = x->next[0].load();
+        }
+        if (node(nxt) == tail)
+            return false;
+        out = node(nxt)->value;
+        return true;
+    }
+
+
+    /// @brief The number of elements, as of some moment during the call.
+    ///        Only exact when no other thread is pushing or popping.
+    std::size_t getSize() const
+    {
+        const std::ptrdiff_t n = count.load(std::memory_order_relaxed);
+        return n > 0 ? static_cast<std::size_t>(n) : 0;
+    }
+
+
+    /// @brief True if the queue held no live element during the call.
+    bool isEmpty() const
+    {
+        T ignored;
+        return !try_top(ignored);
+    }
+
+
+private:
+
+    /// @brief The most levels a node can have, enough for 2^32 elements.
+    static constexpr std::size_t MaxLevel = 32;
+
+    /// @brief The low bit of a level-0 next pointer: set once the node it
+    ///        points to is deleted.
+    static constexpr std::uintptr_t MarkBit = 1;
+
+    struct Node
+    {
+        T value{};
+        std::unique_ptr<std::atomic<std::uintptr_t>[]> next;
+        std::atomic<bool> inserting;
+
+        // sentinel
+        explicit Node(std::size_t levels)
+            : next{ new std::atomic<std::uintptr_t>[levels] }, inserting{ false }
+        {}
+
+        Node(std::size_t levels, const T &val)
+            : value{ val }, next{ new std::atomic<std::uintptr_t>[levels] }, inserting{ true }
+        {}
+    };
+
+    Compare compareFunctor;
+    Node *tail;
+    Node *head;
+
+    // pushes minus pops; briefly negative when a pop overtakes the count
+    // of the push it undid
+    std::atomic<std::ptrdiff_t> count{ 0 };
+
+
+    static std::uintptr_t ref(Node *n) { return reinterpret_cast<std::uintptr_t>(n); }
+    static Node *node(std::uintptr_t p) { return reinterpret_cast<Node *>(p & ~MarkBit); }
+    static bool isMarked(std::uintptr_t p) { return (p & MarkBit) != 0; }
+
+
+    /// @brief Does a node holding value belong after n?
+    bool before(const Node *n, const T &value) const
+    {
+        return n != tail && !this->compareFunctor(n->value, value);
+    }
+
+
+    /// @brief Find, on every level, the last node a new value goes after,
+    ///        and its successor. Deleted nodes are skipped on every level.
+    /// @return The last deleted node met on level 0, or nullptr.
+    Node *locatePreds(const T &value, Node **preds, Node **succs) const
+    {
+        Node *x = head;
+        Node *del = nullptr;
+        for (std::size_t level = MaxLevel; level-- > 0;)
+        {
+            // the successor and, on level 0, whether it is deleted come from
+            // one load; a push and a pop between two loads would make a
+            // live node look deleted
+            std::uintptr_t link = x->next[level].load();
+            Node *cur = node(link);
+            while (before(cur, value) || (cur != tail && isMarked(cur->next[0].load())) ||
+                   isMarked(link))
+            {
+                if (isMarked(link))
+                    del = cur;
+                x = cur;
+                link = x->next[level].load();
+                cur = node(link);
+            }
+            preds[level] = x;
+            succs[level] = cur;
+        }
+        return del;
+    }
+
+
+    /// @brief Point the upper levels of the head past the deleted prefix.
+    void restructure()
+    {
+        Node *pred = head;
+        for (std::size_t level = MaxLevel - 1; level > 0;)
+        {
+            std::uintptr_t h = head->next[level].load();
+            Node *first = node(h);
+            if (first == tail || !isMarked(first->next[0].load()))
+            {
+                --level;
+                continue;
+            }
+            Node *cur = node(pred->next[level].load());
+            while (cur != tail && isMarked(cur->next[0].load()))
+            {
+                pred = cur;
+                cur = node(pred->next[level].load());
+            }
+            if (head->next[level].compare_exchange_strong(h, pred->next[level].load()))
+                --level;
+        }
+    }
+
+
+    /// @brief A geometric level in [1, MaxLevel], from a generator of the
+    ///        calling thread's own.
+    static std::size_t randomLevel()
+    {
+        thread_local std::uint64_t state = 0;
+        if (state == 0)
+            state = reinterpret_cast<std::uintptr_t>(&state) | 1;
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        const std::uint64_t bits = state * 0x2545F4914F6CDD1DULL;
+        std::size_t level = 1;
+        while (level < MaxLevel && ((bits >> (63 - level)) & 1))
+            ++level;
+        return level;
+    }
+}; // class LockFreeSkipPQ
+
+#endif // LOCK_FREE_SKIP_PQ_H
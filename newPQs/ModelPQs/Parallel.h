@@ -0,0 +1,52 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/// @brief The thread fan-out behind the parallel rebuilds in updatePQ(),
+///        BinPQ's heapify and SortedPQ's sort, and behind argExtreme().
+/// @note  threadsFor() picks one thread below PARALLEL_THRESHOLD elements,
+///        where a job fits in cache and starting threads costs more
+///        than it saves, otherwise up to the number of hardware threads.
+///        run() calls a job once per thread index and returns when all of
+///        them are done. Jobs must touch disjoint elements.
+namespace parallel
+{
+    /// @brief Jobs over at least this many elements use several threads.
+    inline constexpr std::size_t PARALLEL_THRESHOLD = std::size_t{1} << 18;
+
+
+    /// @brief How many threads a job should use.
+    /// @param n: Number of elements the job covers.
+    /// @return 1 below PARALLEL_THRESHOLD, otherwise up to the core count.
+    inline std::size_t threadsFor(std::size_t n)
+    {
+        if (n < PARALLEL_THRESHOLD) return 1;
+
+        // asking the OS for the core count is a system call, so ask once
+        static const std::size_t cores = std::thread::hardware_concurrency();
+        return std::max(std::size_t{1}, std::min(cores, n / (PARALLEL_THRESHOLD / 2)));
+    } // threadsFor()
+
+
+    /// @brief Call job(t) for every t in [0, threads), each on its own
+    ///        thread; the calling thread takes t = 0.
+    /// @param threads: Number of calls.
+    /// @param job: Called with each thread index.
+    template <typename Job>
+    void run(std::size_t threads, const Job &job)
+    {
+        std::vector<std::thread> workers;
+        for (std::size_t t = 1; t < threads; ++t)
+            workers.emplace_back([&job, t]() { job(t); });
+        job(0);
+        for (std::thread &worker : workers)
+            worker.join();
+    } // run()
+
+} // namespace parallel
+
+#endif // PARALLEL_H
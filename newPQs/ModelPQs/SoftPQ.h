@@ -0,0 +1,519 @@
+#ifndef SOFT_PQ_H
+#define SOFT_PQ_H
+
+#include "SPsPQ.h"
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// @brief An approximate priority queue implemented as a soft heap
+///        (Kaplan, Tarjan & Zwick's "soft heaps simplified").
+/// @tparam T: The type of the elements in the queue.
+/// @tparam Compare: The comparison functor to use for the priority queue.
+/// @note A soft heap trades exactness for speed: every node stores a whole
+///       list of elements under one shared "ckey", so some elements are
+///       "corrupted", i.e., they are treated as if they had the (lower)
+///       priority of their node's ckey and may come out of getTop() later
+///       than an exact PQ would return them. At any moment at most
+///       epsilon * (number of pushes) elements are corrupted, and every
+///       operation runs in amortized O(log(1/epsilon)) time, which is
+///       constant in the number of elements.
+///
+///       Uncorrupted elements never jump the line: the element returned by
+///       getTop() is at least as extreme as every uncorrupted element.
+template <typename T, typename Compare = std::less<T>>
+class SoftPQ : public SPsPQ<T, Compare>
+{
+    using BaseClass = SPsPQ<T, Compare>;
+
+public:
+
+    /// @brief Default error rate: at most 1% of the pushes are corrupted.
+    static constexpr double DEFAULT_EPSILON = 0.01;
+
+
+    // Default constructor
+    explicit SoftPQ(double epsilon = DEFAULT_EPSILON,
+                    const Compare &comp = Compare())
+        : BaseClass(comp), errorRate(epsilon), threshold(rankThreshold(epsilon))
+    {}
+    // DEFAULT CTOR
+
+
+    // Range-based constructor
+    template <typename Iterator>
+    SoftPQ(Iterator begin, Iterator end, double epsilon = DEFAULT_EPSILON,
+           const Compare &comp = Compare())
+        : BaseClass(comp), errorRate(epsilon), threshold(rankThreshold(epsilon))
+    {
+        while (begin != end)
+            push(*begin++);
+    }
+    // R-B CTOR
+
+
+    // Copy constructor
+    SoftPQ(const SoftPQ &other)
+        : BaseClass(other), errorRate(other.errorRate), threshold(other.threshold),
+          numElts(other.numElts), numPushes(other.numPushes),
+          numCorrupted(other.numCorrupted), roots(other.roots.size(), nullptr),
+          suffixBest(other.suffixBest)
+    {
+        for (size_t r = 0; r < roots.size(); ++r)
+            roots[r] = cloneTree(other.roots[r]);
+    }
+    // COPY CTOR
+
+
+    // Move constructor
+    SoftPQ(SoftPQ &&other) noexcept
+        : BaseClass(std::move(other)), errorRate(other.errorRate),
+          threshold(other.threshold), numElts(other.numElts),
+          numPushes(other.numPushes), numCorrupted(other.numCorrupted),
+          roots(std::move(other.roots)), suffixBest(std::move(other.suffixBest)),
+          spareCells(other.spareCells)
+    {
+        other.roots.clear();
+        other.suffixBest.clear();
+        other.numElts = 0;
+        other.spareCells = nullptr;
+    }
+    // MOVE CTOR
+
+
+    // Copy assignment (copy-swap)
+    SoftPQ &operator=(const SoftPQ &other)
+    {
+        SoftPQ temp(other);
+        swapWith(temp);
+        return *this;
+    } // COPY ASSIGNMENT
+
+
+    // Move assignment
+    SoftPQ &operator=(SoftPQ &&other) noexcept
+    {
+        if (this != &other)
+            swapWith(other);
+        return *this;
+    } // MOVE ASSIGNMENT
+
+
+    // Destructor
+    virtual ~SoftPQ()
+    {
+        for (Node *root : roots)
+            destroyTree(root);
+        while (spareCells)
+        {
+            Cell *next = spareCells->next;
+            delete spareCells;
+            spareCells = next;
+        }
+    } // ~SoftPQ()
+
+
+    /// @brief Push a new value as a rank-0 root, then link equal-rank
+    ///        roots like a binary counter carry.
+    /// @param value: The value to push into the queue.
+    void push(const T &value) override
+    {
+        Node *carry = new Node(value, makeCell(value));
+        size_t rank = 0;
+        while (rank < roots.size() && roots[rank])
+        {
+            carry = combine(roots[rank], carry);
+            roots[rank] = nullptr;
+            ++rank;
+        }
+
+        if (rank == roots.size())
+        {
+            roots.push_back(nullptr);
+            suffixBest.push_back(NONE);
+        }
+        roots[rank] = carry;
+
+        ++numElts;
+        ++numPushes;
+        updateSuffixBest(rank);
+    } // push()
+
+
+    /// @brief Remove the element returned by getTop(). If that empties its
+    ///        node, the node is refilled from its children (sift), or
+    ///        dropped if it is a leaf. Only then do the roots' suffix
+    ///        minima change; a pop that leaves elements in the node is O(1).
+    void pop() override
+    {
+        if (isEmpty()) return;
+
+        const size_t rank = suffixBest[0];
+        Node *x = roots[rank];
+
+        // Keep the corruption count exact as elements leave.
+        if (isExact(x->elts.front(), x->ckey))
+            --x->numExact;
+        else
+            --numCorrupted;
+        releaseCell(x->elts.popFront());
+        --numElts;
+
+        if (!x->elts.empty())
+            return;
+
+        if (isLeaf(x))
+        {
+            delete x;
+            roots[rank] = nullptr;
+        }
+        else
+            sift(x);
+        updateSuffixBest(rank);
+    } // pop()
+
+
+    /// @brief Get the top element, i.e., an element of the root whose
+    ///        ckey is the most extreme.
+    /// @return The top element of the queue.
+    const T &getTop() const override
+    {
+        if (isEmpty())
+            throw std::runtime_error("Priority queue is empty");
+        return roots[suffixBest[0]]->elts.front();
+    } // getTop()
+
+
+    /// @brief Get the current size
+    /// @return The current size of the queue.
+    size_t getSize() const override {
+        return numElts;
+    } // getSize()
+
+
+    /// @brief Check if the queue is empty
+    /// @return True if the queue is empty, false otherwise.
+    bool isEmpty() const override {
+        return numElts == 0;
+    } // isEmpty()
+
+
+    /// @brief Rebuild the soft heap from scratch by pushing every element
+    ///        again. The push and corruption counts start over, too.
+    void updatePQ() override
+    {
+        std::vector<T> elts;
+        elts.reserve(numElts);
+        for (Node *root : roots)
+            collect(root, elts);
+
+        for (Node *root : roots)
+            destroyTree(root);
+        roots.clear();
+        suffixBest.clear();
+        numElts = 0;
+        numPushes = 0;
+        numCorrupted = 0;
+
+        for (const T &elt : elts)
+            push(elt);
+    } // updatePQ()
+
+
+    /// @brief Number of elements currently stored under a ckey that is less
+    ///        extreme than their own priority.
+    /// @return The corrupted count, always <= epsilon * getPushCount().
+    size_t getCorruptedCount() const {
+        return numCorrupted;
+    } // getCorruptedCount()
+
+
+    /// @brief Number of pushes since construction (or the last updatePQ()),
+    ///        which is the n in the epsilon * n corruption bound.
+    size_t getPushCount() const {
+        return numPushes;
+    } // getPushCount()
+
+
+    /// @brief The error rate this queue was built with.
+    double getErrorRate() const {
+        return errorRate;
+    } // getErrorRate()
+
+
+private:
+
+    /// @brief One element of a node's list, linked through 'next'.
+    struct Cell
+    {
+        T value;
+        Cell *next;
+    };
+
+    /// @brief An intrusive singly linked list of cells with a tail, so that
+    ///        pop_front and appending a whole other list are both O(1).
+    struct CellList
+    {
+        Cell *head = nullptr;
+        Cell *tail = nullptr;
+        size_t count = 0;
+
+        bool empty() const { return !head; }
+        size_t size() const { return count; }
+        const T &front() const { return head->value; }
+
+        void pushBack(Cell *cell)
+        {
+            cell->next = nullptr;
+            (tail ? tail->next : head) = cell;
+            tail = cell;
+            ++count;
+        }
+
+        Cell *popFront()
+        {
+            Cell *cell = head;
+            head = cell->next;
+            if (!head)
+                tail = nullptr;
+            --count;
+            return cell;
+        }
+
+        /// @brief Move every cell of 'other' to the end of this list.
+        void splice(CellList &other)
+        {
+            if (other.empty()) return;
+            (tail ? tail->next : head) = other.head;
+            tail = other.tail;
+            count += other.count;
+            other = CellList{};
+        }
+    };
+
+    /// @brief A node of one of the soft heap's binary trees. All of the
+    ///        elements in 'elts' are ranked as 'ckey'.
+    struct Node
+    {
+        Node(const T &val, Cell *cell)
+            : ckey(val), rank(0), targetSize(1), numExact(1),
+              left(nullptr), right(nullptr)
+        {
+            elts.pushBack(cell);
+        }
+
+        Node(Node *l, Node *r, size_t newRank, size_t newTargetSize)
+            : ckey(l->ckey), rank(newRank), targetSize(newTargetSize),
+              numExact(0), left(l), right(r)
+        {}
+
+        T ckey;             ///< Priority shared by every element in 'elts'
+        CellList elts;      ///< Elements living in this node (O(1) splice)
+        size_t rank;        ///< Rank of the node, the leaf is rank 0
+        size_t targetSize;  ///< Number of elements sift() tries to hold
+        size_t numExact;    ///< Elements in 'elts' that are equivalent to ckey
+        Node *left;
+        Node *right;
+    };
+
+    /// @brief Marks an empty root slot in 'suffixBest'.
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    double errorRate;
+    size_t threshold;   ///< Nodes up to this rank hold a single element
+    size_t numElts = 0;
+    size_t numPushes = 0;
+    size_t numCorrupted = 0;
+
+    /// @brief roots[r] is the tree of rank r, or nullptr.
+    std::vector<Node*> roots;
+
+    /// @brief suffixBest[r] is the rank of the root with the most extreme
+    ///        ckey among roots[r..], so suffixBest[0] locates getTop().
+    std::vector<size_t> suffixBest;
+
+    /// @brief Cells of popped elements, linked through 'next', reused by
+    ///        push() before it allocates.
+    Cell *spareCells = nullptr;
+
+
+    /// @brief The rank threshold r = ceil(log2(3 / epsilon)) + 1. This is
+    ///        one rank above the paper's threshold because pop() only sifts
+    ///        a root once its list is empty, which lets the lists run a bit
+    ///        longer; the extra rank halves the corruptible share and keeps
+    ///        the epsilon * n bound.
+    /// @param epsilon: The error rate, must lie in (0, 1/2].
+    static size_t rankThreshold(double epsilon)
+    {
+        if (!(epsilon > 0.0 && epsilon <= 0.5))
+            throw std::invalid_argument("Error rate must lie in (0, 0.5]");
+        return static_cast<size_t>(std::ceil(std::log2(3.0 / epsilon)) + 1);
+    } // rankThreshold()
+
+
+    /// @brief True if a and b are neither higher nor lower than each other.
+    bool isExact(const T &a, const T &b) const {
+        return !this->compareFunctor(a, b) && !this->compareFunctor(b, a);
+    } // isExact()
+
+
+    bool isLeaf(const Node *x) const {
+        return !x->left && !x->right;
+    } // isLeaf()
+
+
+    /// @brief Link two roots of equal rank under a new, empty node and
+    ///        fill it from below.
+    Node *combine(Node *a, Node *b)
+    {
+        const size_t rank = a->rank + 1;
+        const size_t target = (rank <= threshold)
+            ? 1 : (3 * a->targetSize + 1) / 2; // ceil(3/2 * size)
+
+        Node *z = new Node(a, b, rank, target);
+        sift(z);
+        return z;
+    } // combine()
+
+
+    /// @brief Refill x's element list from its children until it holds
+    ///        targetSize elements or x runs out of children. The child with
+    ///        the more extreme ckey donates its whole list, and x takes over
+    ///        that child's (less extreme) ckey, which is where corruption
+    ///        comes from.
+    void sift(Node *x)
+    {
+        while (x->elts.size() < x->targetSize && !isLeaf(x))
+        {
+            // Make 'left' the child with the more extreme ckey.
+            if (!x->left || (x->right &&
+                this->compareFunctor(x->left->ckey, x->right->ckey)))
+                std::swap(x->left, x->right);
+
+            Node *child = x->left;
+
+            // Elements that matched the old ckey are corrupted now,
+            // unless the new ckey is just as extreme.
+            if (!x->elts.empty() && !isExact(x->ckey, child->ckey))
+            {
+                numCorrupted += x->numExact;
+                x->numExact = 0;
+            }
+            x->numExact += child->numExact;
+            child->numExact = 0;
+
+            x->elts.splice(child->elts);
+            x->ckey = child->ckey;
+
+            if (isLeaf(child))
+            {
+                delete child;
+                x->left = nullptr;
+            }
+            else
+                sift(child);
+        } // while
+    } // sift()
+
+
+    /// @brief Recompute suffixBest for ranks [0, rank] after roots[rank]
+    ///        changed. Slots above rank are unaffected.
+    void updateSuffixBest(size_t rank)
+    {
+        // Drop empty slots at the top so the vectors track the highest rank.
+        while (!roots.empty() && !roots.back())
+        {
+            roots.pop_back();
+            suffixBest.pop_back();
+        }
+        if (rank >= roots.size())
+        {
+            if (roots.empty()) return;
+            rank = roots.size() - 1;
+        }
+
+        for (size_t r = rank + 1; r-- > 0;)
+        {
+            size_t best = (r + 1 < roots.size()) ? suffixBest[r + 1] : NONE;
+            if (roots[r] && (best == NONE ||
+                !this->compareFunctor(roots[r]->ckey, roots[best]->ckey)))
+                best = r;
+            suffixBest[r] = best;
+        }
+    } // updateSuffixBest()
+
+
+    /// @brief Append every element of a tree to 'out'.
+    void collect(const Node *x, std::vector<T> &out) const
+    {
+        if (!x) return;
+        for (const Cell *cell = x->elts.head; cell; cell = cell->next)
+            out.push_back(cell->value);
+        collect(x->left, out);
+        collect(x->right, out);
+    } // collect()
+
+
+    /// @brief Deep copy of a tree. Recursion depth is bounded by the rank.
+    static Node *cloneTree(const Node *x)
+    {
+        if (!x) return nullptr;
+        Node *copy = new Node(*x);
+        copy->elts = CellList{};
+        for (const Cell *cell = x->elts.head; cell; cell = cell->next)
+            copy->elts.pushBack(new Cell{ cell->value, nullptr });
+        copy->left = cloneTree(x->left);
+        copy->right = cloneTree(x->right);
+        return copy;
+    } // cloneTree()
+
+
+    static void destroyTree(Node *x)
+    {
+        if (!x) return;
+        destroyTree(x->left);
+        destroyTree(x->right);
+        while (!x->elts.empty())
+            delete x->elts.popFront();
+        delete x;
+    } // destroyTree()
+
+
+    /// @brief A cell holding value, from 'spareCells' if there is one.
+    Cell *makeCell(const T &value)
+    {
+        if (!spareCells)
+            return new Cell{ value, nullptr };
+        Cell *cell = spareCells;
+        spareCells = cell->next;
+        cell->value = value;
+        return cell;
+    } // makeCell()
+
+
+    /// @brief Keep a popped element's cell for the next push().
+    void releaseCell(Cell *cell)
+    {
+        cell->next = spareCells;
+        spareCells = cell;
+    } // releaseCell()
+
+
+    void swapWith(SoftPQ &other)
+    {
+        std::swap(this->compareFunctor, other.compareFunctor);
+        std::swap(errorRate, other.errorRate);
+        std::swap(threshold, other.threshold);
+        std::swap(numElts, other.numElts);
+        std::swap(numPushes, other.numPushes);
+        std::swap(numCorrupted, other.numCorrupted);
+        roots.swap(other.roots);
+        suffixBest.swap(other.suffixBest);
+        std::swap(spareCells, other.spareCells);
+    } // swapWith()
+
+
+}; // class SoftPQ
+
+#endif // SOFT_PQ_H
@@ -1,6 +1,7 @@
 #ifndef SORTED_PQ_H
 #define SORTED_PQ_H
 
+#include "Parallel.h"
 #include "SPsPQ.h"
 #include <vector>
 #include <algorithm>
@@ -16,7 +17,14 @@ using namespace std;
 /// 'data' container, such that traversing the iterators yields the elements in
 /// sorted order.
 
-template <typename T, typename Compare = std::less<T>>
+/// NOTE: push() inserts in front of its equals and updatePQ() sorts stably,
+/// so equal elements already pop in FIFO order; Stable = true also makes
+/// the range constructor FIFO. The order of equals is their position, not a
+/// push stamp, so after updatePQ() elements that became equal keep the
+/// order their old priorities gave them (BinPQ, UnorderedPQ and
+/// UnorderedPQOptimized go by push order there).
+
+template <typename T, typename Compare = std::less<T>, bool Stable = false>
 class SortedPQ : public SPsPQ<T, Compare>
 {
 
@@ -31,6 +39,10 @@ public:
     template <typename Iterator>
     SortedPQ(Iterator begin, Iterator end, const Compare &comp = Compare())
         : SPsPQ<T, Compare>(comp), data(begin, end) {
+        // the first element of the range is the oldest, so it belongs
+        // nearest the back among its equals
+        if constexpr (Stable)
+            std::reverse(data.begin(), data.end());
         updatePQ();
     }
 
@@ -114,14 +126,54 @@ public:
 
 
     /// @brief Update the priority queue to maintain sorted order.
+    ///        Large queues are sorted on several threads.
     void updatePQ() override 
+    {
+        updatePQ(parallel::threadsFor(getSize()));
+    } // updatePQ()
+
+
+    /// @brief updatePQ() on the given number of threads. Each thread sorts
+    ///        one slice, then neighboring slices are merged, pairs of them
+    ///        in parallel, until one is left.
+    /// @param threads: Number of threads; 1 sorts serially.
+    /// @note Every step is stable, and so is the serial sort, so equal
+    ///       elements keep their relative order and the result is the same
+    ///       for any number of threads.
+    void updatePQ(std::size_t threads)
     {
         if (getSize() <= 1) return;
-        sort(
-            data.begin(), 
-            data.end(), 
-            this->compareFunctor
-        );
+
+        const std::size_t n = getSize();
+        threads = std::min(threads, n / MinSlice);
+        if (threads < 2)
+        {
+            stable_sort(data.begin(), data.end(), this->compareFunctor);
+            return;
+        }
+
+        auto at = [this](std::size_t i) { return data.begin() + static_cast<std::ptrdiff_t>(i); };
+        std::vector<std::size_t> bounds;
+        for (std::size_t t = 0; t <= threads; ++t)
+            bounds.push_back(n * t / threads);
+        parallel::run(threads, [this, &at, &bounds](std::size_t t) {
+            stable_sort(at(bounds[t]), at(bounds[t + 1]), this->compareFunctor);
+        });
+
+        while (bounds.size() > 2)
+        {
+            const std::size_t pairs = (bounds.size() - 1) / 2;
+            parallel::run(pairs, [this, &at, &bounds](std::size_t i) {
+                inplace_merge(at(bounds[2 * i]), at(bounds[2 * i + 1]),
+                              at(bounds[2 * i + 2]), this->compareFunctor);
+            });
+            std::vector<std::size_t> merged;
+            for (std::size_t i = 0; i < bounds.size(); i += 2)
+                merged.push_back(bounds[i]);
+            if (merged.back() != n)
+                merged.push_back(n);
+            bounds.swap(merged);
+        }
     } // updatePQ()
 
 
@@ -168,6 +220,9 @@ public:
     } // getInternalData()
 
 private:
+
+    // Slices shorter than this are not worth a thread of their own
+    static constexpr std::size_t MinSlice = 4096;
     
     // Priority queue's underlying container
     vector<T> data;
@@ -2,12 +2,27 @@
 #define UNORDERED_PQ_OPTIMIZED_H
 
 #include "SPsPQ.h"
+#include "ArgExtreme.h"
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
-template<typename T, typename Compare = std::less<T>>
+// With Stable = true, elements of equal priority are popped in the order
+// they were pushed (FIFO).
+template<typename T, typename Compare = std::less<T>, bool Stable = false>
 class UnorderedPQOptimized : public SPsPQ<T, Compare> 
 {
 
+    /// @brief In stable mode each element is stored with the sequence
+    ///        number of its push, which breaks ties between equal elements.
+    struct Stamped
+    {
+        T value;
+        uint64_t seq;
+    };
+    using Slot = std::conditional_t<Stable, Stamped, T>;
+
+
 public:
 
 
@@ -21,7 +36,9 @@ public:
     template<typename Iterator>
     UnorderedPQOptimized(Iterator begin, Iterator end, 
         const Compare& comp = Compare())
-    : SPsPQ<T, Compare>(comp), data(begin, end), topIdx(0) {
+    : SPsPQ<T, Compare>(comp), topIdx(0) {
+        while (begin != end)
+            data.push_back(wrap(*begin++));
         if (!data.empty()) updateTop();
     }
 
@@ -29,9 +46,9 @@ public:
 
     // Push a new value into the queue
     void push(const T& value) override {
-        data.push_back(value);
+        data.push_back(wrap(value));
         // If empty before push or new value is better than current top, update topIdx
-        if (data.size() == 1 || this->compareFunctor(data[topIdx], value)) {
+        if (data.size() == 1 || hasLowerPriority(data[topIdx], data.back())) {
             topIdx = data.size() - 1;
         }
     }
@@ -61,7 +78,7 @@ public:
         if (isEmpty()) {
             throw std::runtime_error("Priority queue is empty");
         }
-        return data[topIdx];
+        return valueOf(data[topIdx]);
     }
 
 
@@ -82,8 +99,44 @@ public:
     }
 
 private:
-    std::vector<T> data;      // Vector to store elements
+    std::vector<Slot> data;   // Vector to store elements
     std::size_t topIdx;       // Index of current top element
+    uint64_t nextSeq = 0;     // Next push sequence number (stable mode only)
+
+
+    /// @brief Wrap a value for storage, stamping it in stable mode.
+    Slot wrap(const T &value)
+    {
+        if constexpr (Stable)
+            return Slot{value, nextSeq++};
+        else
+            return value;
+    }
+
+
+    /// @brief The value stored in a slot.
+    static const T &valueOf(const Slot &slot)
+    {
+        if constexpr (Stable)
+            return slot.value;
+        else
+            return slot;
+    }
+
+
+    /// @brief Does a have lower priority than b? In stable mode, equal
+    ///        elements are ordered by push, the older one first.
+    bool hasLowerPriority(const Slot &a, const Slot &b) const
+    {
+        if constexpr (Stable)
+        {
+            if (this->compareFunctor(a.value, b.value))
+                return true;
+            return !this->compareFunctor(b.value, a.value) && a.seq > b.seq;
+        }
+        else
+            return this->compareFunctor(a, b);
+    }
 
     // Helper to find and update the top index
     void updateTop() 
@@ -92,12 +145,11 @@ private:
             return;
         }
 
-        topIdx = 0;
-        for (std::size_t i = 1; i < data.size(); ++i) {
-            if (this->compareFunctor(data[topIdx], data[i])) {
-                topIdx = i;
-            }
-        }
+        if constexpr (Stable)
+            topIdx = argExtreme(data.data(), data.size(),
+                [this](const Slot &a, const Slot &b) { return hasLowerPriority(a, b); });
+        else
+            topIdx = argExtreme(data.data(), data.size(), this->compareFunctor);
     }
 };
 
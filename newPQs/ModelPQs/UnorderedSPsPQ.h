@@ -183,31 +183,77 @@
 #define UNORDERED_PQ_VECTOR_H
 
 #include "SPsPQ.h"  // Base class header
+#include "ArgExtreme.h"
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
-template<typename T, typename Compare = std::less<T>>
+// With Stable = true, elements of equal priority are popped in the order
+// they were pushed (FIFO).
+template<typename T, typename Compare = std::less<T>, bool Stable = false>
 class UnorderedPQ : public SPsPQ<T, Compare> 
 {
 
 private:
 
-    std::vector<T> data;  // Vector to store elements
+    /// @brief In stable mode each element is stored with the sequence
+    ///        number of its push, which breaks ties between equal elements.
+    struct Stamped
+    {
+        T value;
+        uint64_t seq;
+    };
+    using Slot = std::conditional_t<Stable, Stamped, T>;
 
+    std::vector<Slot> data;  // Vector to store elements
+    uint64_t nextSeq = 0;    // Next push sequence number (stable mode only)
 
-    // Helper to find the index of the "top" element based on Compare
-    std::size_t findTopIndex() const 
+
+    /// @brief Wrap a value for storage, stamping it in stable mode.
+    Slot wrap(const T &value)
     {
-        // Handled by isEmpty check in getTop/pop
-        if (data.empty()) return 0;  
+        if constexpr (Stable)
+            return Slot{value, nextSeq++};
+        else
+            return value;
+    }
+
+
+    /// @brief The value stored in a slot.
+    static const T &valueOf(const Slot &slot)
+    {
+        if constexpr (Stable)
+            return slot.value;
+        else
+            return slot;
+    }
 
-        std::size_t topIdx = 0;
-        for (std::size_t i = 1; i < data.size(); ++i) 
+
+    /// @brief Does a have lower priority than b? In stable mode, equal
+    ///        elements are ordered by push, the older one first.
+    bool hasLowerPriority(const Slot &a, const Slot &b) const
+    {
+        if constexpr (Stable)
         {
-            if (this->compareFunctor(data[topIdx], data[i])) {
-                topIdx = i;
-            }
+            if (this->compareFunctor(a.value, b.value))
+                return true;
+            return !this->compareFunctor(b.value, a.value) && a.seq > b.seq;
         }
-        return topIdx;
+        else
+            return this->compareFunctor(a, b);
+    }
+
+
+    // Helper to find the index of the "top" element based on Compare.
+    // argExtreme() picks a SIMD, multi-chunk or multithreaded scan.
+    std::size_t findTopIndex() const 
+    {
+        // Handled by isEmpty check in getTop/pop
+        if constexpr (Stable)
+            return argExtreme(data.data(), data.size(),
+                [this](const Slot &a, const Slot &b) { return hasLowerPriority(a, b); });
+        else
+            return argExtreme(data.data(), data.size(), this->compareFunctor);
     }
 
 
@@ -222,12 +268,15 @@ public:
     // Range-based constructor
     template<typename Iterator>
     UnorderedPQ(Iterator begin, Iterator end, const Compare& comp = Compare())
-        : SPsPQ<T, Compare>(comp), data(begin, end) {}
+        : SPsPQ<T, Compare>(comp) {
+        while (begin != end)
+            data.push_back(wrap(*begin++));
+    }
 
 
     // Push a new value into the queue
     void push(const T& value) override {
-        data.push_back(value);
+        data.push_back(wrap(value));
     }
 
 
@@ -245,7 +294,7 @@ public:
         if (isEmpty()) {
             throw std::runtime_error("Priority queue is empty");
         }
-        return data[findTopIndex()];
+        return valueOf(data[findTopIndex()]);
     }
 
 
@@ -0,0 +1,130 @@
+// testBench.cpp
+//
+// Benchmarks for the special-purpose priority queues. Build with
+// 'make testBench' and run './testBench [numElements]'.
+//
+// Each benchmark prints one line per container so that runs can be
+// diffed against each other.
+//
+
+
+#include "SPsPQ.h"
+#include "BinPQ.h"
+#include "SoftPQ.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+
+// Milliseconds elapsed since 'start'.
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+} // elapsedMs()
+
+
+
+// Push every value, then pop the first k elements. Returns the popped
+// elements (in pop order) and the elapsed time in 'ms'.
+vector<int> pushThenPopK(SPsPQ<int> &pq, const vector<int> &values,
+                         size_t k, double &ms)
+{
+    vector<int> popped;
+    popped.reserve(k);
+
+    auto start = chrono::steady_clock::now();
+    for (int val : values)
+        pq.push(val);
+    for (size_t i = 0; i < k && !pq.isEmpty(); ++i)
+    {
+        popped.push_back(pq.getTop());
+        pq.pop();
+    }
+    ms = elapsedMs(start);
+
+    return popped;
+} // pushThenPopK()
+
+
+
+// Fraction of the exact top-k (as a multiset) that the approximate top-k
+// also returned.
+double recall(vector<int> exact, vector<int> approx)
+{
+    if (exact.empty()) return 1.0;
+
+    sort(exact.begin(), exact.end());
+    sort(approx.begin(), approx.end());
+
+    vector<int> common;
+    set_intersection(exact.begin(), exact.end(), approx.begin(), approx.end(),
+                     back_inserter(common));
+    return static_cast<double>(common.size()) / static_cast<double>(exact.size());
+} // recall()
+
+
+
+// Top-1% analytics: push n random events, pop the top 1%, and compare the
+// soft heap's throughput and recall against the exact BinPQ.
+void benchSoftPQ(size_t n)
+{
+    cout << "\n********** Soft heap vs. BinPQ: push " << n
+         << ", pop top 1% **********\n" << endl;
+
+    mt19937 gen(281);
+    uniform_int_distribution<int> dist(0, 1 << 30);
+    vector<int> values(n);
+    for (int &val : values)
+        val = dist(gen);
+
+    const size_t k = max<size_t>(1, n / 100);
+
+    double exactMs = 0;
+    BinPQ<int> exactPQ;
+    vector<int> exactTop = pushThenPopK(exactPQ, values, k, exactMs);
+
+    cout << left << setw(22) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << setw(10) << "recall" << setw(12)
+         << "corrupted" << endl;
+
+    auto report = [&](const string &name, double ms, double rec, size_t corrupted)
+    {
+        double mops = static_cast<double>(n + k) / (ms * 1000.0);
+        cout << left << setw(22) << name << right << fixed << setprecision(2)
+             << setw(12) << ms << setw(14) << mops << setw(10)
+             << setprecision(4) << rec << setw(12) << corrupted << endl;
+    };
+
+    report("BinPQ (exact)", exactMs, 1.0, 0);
+
+    for (double eps : {0.001, 0.01, 0.1, 0.3})
+    {
+        double softMs = 0;
+        SoftPQ<int> softPQ(eps);
+        vector<int> softTop = pushThenPopK(softPQ, values, k, softMs);
+        report("SoftPQ eps=" + to_string(eps).substr(0, 5), softMs,
+               recall(exactTop, softTop), softPQ.getCorruptedCount());
+    }
+} // benchSoftPQ()
+
+
+
+int main(int argc, char *argv[])
+{
+    size_t n = 1000000;
+    if (argc > 1)
+        n = static_cast<size_t>(strtoull(argv[1], nullptr, 10));
+
+    benchSoftPQ(n);
+
+    return 0;
+} // main()
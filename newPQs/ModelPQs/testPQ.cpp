@@ -5,6 +5,8 @@
 #include "UnorderedFastSPsPQ.h"
 #include "BinPQ.h"
 #include "SortedPQ.h"
+#include "SoftPQ.h"
+#include "LockFreeSkipPQ.h"
 // #include "PairingPQ.h"
 
 #include <vector>
@@ -12,6 +14,10 @@
 #include <iostream>
 #include <string>
 #include <chrono>
+#include <climits>
+#include <cmath>
+#include <atomic>
+#include <thread>
 
 using namespace std;
 
@@ -190,6 +196,13 @@ void testHiddenData(const string &pqType)
         pq4 = new PairingPQ<HiddenData, OddFirstComp>;
         pqL = new PairingPQ<HiddenData, decltype(customComp)>;
     }
+    else if (pqType == "Soft")
+    {
+        pq = new SoftPQ<HiddenData, HiddenDataMaxHeap>;
+        pq2 = new SoftPQ<HiddenData, HDAbsComparator>;
+        pq4 = new SoftPQ<HiddenData, OddFirstComp>;
+        pqL = new SoftPQ<HiddenData, decltype(customComp)>;
+    }
 
 
     /// @b Populate: pq
@@ -334,6 +347,58 @@ void testUpdatePQHelper(SPsPQ<int *, IntPtrComp> *pq, const string &pqType)
 
 
 
+/// @brief Scramble the priorities behind a queue of pointers, then rebuild
+///        copies of it serially and on several threads with updatePQ(n).
+///        Priorities repeat, so the copies only pop the same pointers in
+///        the same order if the rebuilds placed equal elements alike.
+/// @param pqType: The name of the queue, for the log.
+template <typename PQ>
+void testParallelUpdatePQHelper(const string &pqType)
+{
+    cout << "Testing parallel updatePQ() of " << pqType << "..." << endl;
+    auto drain = [](PQ &pq) {
+        vector<int *> order;
+        while (!pq.isEmpty())
+        {
+            order.push_back(pq.getTop());
+            pq.pop();
+        }
+        return order;
+    };
+
+    for (size_t n : {1, 2, 31, 64, 65, 1000, 9000, 100003})
+    {
+        vector<int> priorities(n);
+        vector<int *> ptrs;
+        for (size_t i = 0; i < n; ++i)
+        {
+            priorities[i] = static_cast<int>(i * 7919 % 1009);
+            ptrs.push_back(&priorities[i]);
+        }
+        PQ pq(ptrs.begin(), ptrs.end(), IntPtrComp());
+        for (size_t i = 0; i < n; ++i)
+            priorities[i] = static_cast<int>((i * 104729 + 17) % 251);
+
+        PQ serial(pq);
+        serial.updatePQ(1);
+        vector<int *> expected = drain(serial);
+        assert(expected.size() == n);
+        for (size_t i = 1; i < n; ++i)
+            assert(*expected[i] <= *expected[i - 1]);
+
+        for (size_t threads : {2, 3, 4, 7})
+        {
+            PQ parallel(pq);
+            parallel.updatePQ(threads);
+            [[maybe_unused]] vector<int *> drained = drain(parallel);
+            assert(drained == expected);
+        }
+    }
+    cout << "Testing parallel updatePQ() of " << pqType << " passed!\n" << endl;
+} // testParallelUpdatePQHelper()
+
+
+
 /// TODO: Add more code to this function to test if updatePQ()
 /// is working properly.
 /// @note This function calls the testUpdatePQHelper function.
@@ -363,6 +428,10 @@ void testUpdatePQ(const string &pqType)
     {
         pq = new PairingPQ<int *, IntPtrComp>;
     } // else if
+    else if (pqType == "Soft")
+    {
+        pq = new SoftPQ<int *, IntPtrComp>;
+    } // else if
     
     if (!pq)
     {
@@ -1243,6 +1312,23 @@ void testPriorityQueue(const string &pqType)
         // Test 6: Large number of elements
         pq5 = new PairingPQ<int>;
     }
+    else if (pqType == "Soft")
+    {
+        // Test 1: Empty queue
+        pq1 = new SoftPQ<int>;
+
+        // Test 3: Range-based constructor with duplicates
+        pq2 = new SoftPQ<int>(arr, arr + 9);
+
+        // Test 4: All equal elements
+        pq3 = new SoftPQ<int>;
+
+        // Test 5: Push after pop to zero
+        pq4 = new SoftPQ<int>;
+
+        // Test 6: Large number of elements
+        pq5 = new SoftPQ<int>;
+    }
 
 
     // Test 1: Empty queue
@@ -1506,6 +1592,23 @@ void runEdgeTests(const string &pqType)
         // Test 5: Range init with all equal, pop all
         pq5 = new PairingPQ<int>(arr, arr + 4);
     }
+    else if (pqType == "Soft")
+    {
+        // Test 1: Push-pop-push with equal elements
+        pq1 = new SoftPQ<int>();
+
+        // Test 2: Pop all elements then push new max
+        pq2 = new SoftPQ<int>();
+
+        // Test 3: Push lower value after pop, check top
+        pq3 = new SoftPQ<int>();
+
+        // Test 4: Repeated pop with duplicates
+        pq4 = new SoftPQ<int>();
+
+        // Test 5: Range init with all equal, pop all
+        pq5 = new SoftPQ<int>(arr, arr + 4);
+    }
     else
     {
         delete pq1;
@@ -1638,6 +1741,10 @@ void specialTests(const string &pqType)
     {
         pq1 = new PairingPQ<pair<int, int>, PositionAwareCompare>();
     }
+    else if (pqType == "Soft")
+    {
+        pq1 = new SoftPQ<pair<int, int>, PositionAwareCompare>();
+    }
     else
     {
         delete pq1;
@@ -1694,6 +1801,11 @@ void specialTests2(const string &pqType)
         pq1 = new PairingPQ<int>();
         pq2 = new PairingPQ<int>();
     }
+    else if (pqType == "Soft")
+    {
+        pq1 = new SoftPQ<int>();
+        pq2 = new SoftPQ<int>();
+    }
     else
     {
         delete pq1;
@@ -2042,6 +2154,85 @@ void additionalBinPQEdgeTests()
         cout << "Test 9 passed!\n" << endl;
     }
 
+    // Test 10: replace_top() is a pop() + push() in one sift
+    {
+        cout << "Test 10: replace_top() vs. pop() + push()\n";
+        std::vector<int> vals = {15, 3, 22, 8, 41, 16, 4, 30};
+        BinPQ<int> replaced(vals.begin(), vals.end());
+        BinPQ<int> popPushed(vals.begin(), vals.end());
+
+        for (int next : {1, 50, 17, 17, 2})
+        {
+            replaced.replace_top(next);
+            popPushed.pop();
+            popPushed.push(next);
+            assert(replaced.getSize() == popPushed.getSize());
+            assert(replaced.getTop() == popPushed.getTop());
+        }
+
+        while (!replaced.isEmpty())
+        {
+            assert(replaced.getTop() == popPushed.getTop());
+            replaced.pop();
+            popPushed.pop();
+        }
+
+        try {
+            replaced.replace_top(1);
+            assert(false && "replace_top() on an empty queue should throw");
+        } catch (const std::runtime_error&) {}
+
+        cout << "Test 10 passed!\n" << endl;
+    }
+
+    // Test 11: stable mode pops equal priorities in push order
+    {
+        cout << "Test 11: stable mode is FIFO among equals\n";
+        struct ByPriority {
+            bool operator()(const std::pair<int, int> &a,
+                            const std::pair<int, int> &b) const {
+                return a.first < b.first;
+            }
+        };
+
+        std::vector<std::pair<int, int>> orders;
+        for (int i = 0; i < 200; ++i)
+            orders.emplace_back((i * 13) % 5, i);
+
+        using Order = std::pair<int, int>;
+        BinPQ<Order, ByPriority, true> pushed, ranged(orders.begin(), orders.end());
+        SortedPQ<Order, ByPriority, true> sortedPushed, sortedRanged(orders.begin(), orders.end());
+        UnorderedPQ<Order, ByPriority, true> scanPushed, scanRanged(orders.begin(), orders.end());
+        UnorderedPQOptimized<Order, ByPriority, true> fastPushed,
+            fastRanged(orders.begin(), orders.end());
+        for (const auto &order : orders)
+        {
+            pushed.push(order);
+            sortedPushed.push(order);
+            scanPushed.push(order);
+            fastPushed.push(order);
+        }
+
+        std::vector<SPsPQ<Order, ByPriority> *> pqs{ &pushed, &ranged,
+            &sortedPushed, &sortedRanged, &scanPushed, &scanRanged,
+            &fastPushed, &fastRanged };
+        for (auto *pq : pqs)
+        {
+            auto prev = pq->getTop();
+            pq->pop();
+            while (!pq->isEmpty())
+            {
+                auto cur = pq->getTop();
+                assert(cur.first < prev.first ||
+                       (cur.first == prev.first && cur.second > prev.second));
+                prev = cur;
+                pq->pop();
+            }
+        }
+
+        cout << "Test 11 passed!\n" << endl;
+    }
+
     cout << "\n\n********** END: Additional BinPQ Edge Tests **********\n" << endl;
 } // additionalBinPQEdgeTests()
 
@@ -2696,6 +2887,320 @@ void testPairingPQUpdateElt()
 
 
 
+// Test the soft heap's error guarantee: the corrupted count never exceeds
+// epsilon * pushes, every pushed element comes back out exactly once, and
+// the pop order has at most as many inversions as corruption allows.
+/// @brief The plain scalar scan that argExtreme() must agree with.
+template <typename T, typename Compare>
+std::size_t scalarArgExtreme(const std::vector<T> &data, const Compare &comp)
+{
+    std::size_t top = 0;
+    for (std::size_t i = 1; i < data.size(); ++i)
+        if (comp(data[top], data[i]))
+            top = i;
+    return top;
+} // scalarArgExtreme()
+
+
+/// @brief Check every kernel against the scalar scan on sizes around the
+///        lane and chunk widths, with many duplicates so that the first
+///        index among equals matters.
+template <typename T, typename Compare>
+void testArgExtremeHelper([[maybe_unused]] const Compare &comp)
+{
+    std::size_t seed = 99;
+    for (std::size_t n : {1, 2, 3, 4, 5, 15, 16, 17, 31, 33, 64, 100, 1000, 300000})
+    {
+        std::vector<T> data(n);
+        for (T &val : data) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            val = static_cast<T>((seed >> 33) % 97);
+        }
+        assert(argExtreme(data.data(), n, comp) == scalarArgExtreme(data, comp));
+    }
+} // testArgExtremeHelper()
+
+
+void testArgExtreme()
+{
+    cout << "\n\n********** START: Testing argExtreme kernels **********\n" << endl;
+    testArgExtremeHelper<int>(std::less<int>());
+    testArgExtremeHelper<int>(std::greater<int>());
+    testArgExtremeHelper<double>(std::less<double>());
+    testArgExtremeHelper<unsigned char>(std::greater<unsigned char>());
+    testArgExtremeHelper<long>([](long a, long b) { return a % 10 < b % 10; });
+    cout << "\n\n********** END: Testing argExtreme kernels **********\n" << endl;
+} // testArgExtreme()
+
+
+
+void testSoftPQ()
+{
+    cout << "\n\n********** START: Testing SoftPQ error bound **********\n" << endl;
+
+    // Test 1: Invalid error rates are rejected
+    {
+        cout << "Test 1: invalid epsilon throws" << endl;
+        for (double eps : {0.0, -0.1, 0.75})
+        {
+            try {
+                SoftPQ<int> bad(eps);
+                assert(false && "Expected invalid_argument");
+            } catch (const std::invalid_argument&) {}
+        }
+        cout << "Test 1 passed!\n" << endl;
+    }
+
+    // Test 2: Corruption stays within epsilon * pushes under mixed traffic
+    for (double eps : {0.5, 0.1, 0.01})
+    {
+        cout << "Test 2: corruption bound with epsilon = " << eps << endl;
+        SoftPQ<int> soft(eps);
+        vector<int> pushed, popped;
+        size_t maxCorrupted = 0;
+        srand(281);
+
+        for (int i = 0; i < 20000; ++i)
+        {
+            int val = rand() % 5000;
+            soft.push(val);
+            pushed.push_back(val);
+
+            // Pop roughly one element for every three pushes.
+            if (i % 3 == 2)
+            {
+                popped.push_back(soft.getTop());
+                soft.pop();
+            }
+
+            maxCorrupted = max(maxCorrupted, soft.getCorruptedCount());
+            assert(static_cast<double>(soft.getCorruptedCount())
+                   <= eps * static_cast<double>(soft.getPushCount()));
+        }
+
+        while (!soft.isEmpty())
+        {
+            popped.push_back(soft.getTop());
+            soft.pop();
+        }
+        assert(soft.getCorruptedCount() == 0);
+
+        sort(pushed.begin(), pushed.end());
+        sort(popped.begin(), popped.end());
+        assert(pushed == popped);
+        cout << "Test 2 passed! (max corrupted = " << maxCorrupted << ")\n" << endl;
+    }
+
+    // Test 3: With few pushes every node still holds a single element, so
+    // nothing can be corrupted and the soft heap behaves exactly like BinPQ.
+    {
+        cout << "Test 3: exact for small inputs" << endl;
+        SoftPQ<int> soft(0.01);
+        BinPQ<int> exact;
+        for (int i = 0; i < 500; ++i)
+        {
+            int val = (i * 7919) % 1013;
+            soft.push(val);
+            exact.push(val);
+        }
+        assert(soft.getCorruptedCount() == 0);
+        while (!exact.isEmpty())
+        {
+            assert(soft.getTop() == exact.getTop());
+            soft.pop();
+            exact.pop();
+        }
+        assert(soft.isEmpty());
+        cout << "Test 3 passed!\n" << endl;
+    }
+
+    // Test 4: Copies are independent, updatePQ() keeps every element
+    {
+        cout << "Test 4: copy and updatePQ" << endl;
+        SoftPQ<int> soft(0.2);
+        for (int i = 0; i < 3000; ++i)
+            soft.push((i * 31) % 977);
+
+        SoftPQ<int> copy(soft);
+        assert(copy.getSize() == soft.getSize());
+        assert(copy.getCorruptedCount() == soft.getCorruptedCount());
+        while (!copy.isEmpty())
+        {
+            assert(copy.getTop() == soft.getTop());
+            copy.pop();
+            soft.pop();
+        }
+        assert(soft.isEmpty());
+
+        SoftPQ<int> rebuilt(0.2);
+        for (int i = 0; i < 3000; ++i)
+            rebuilt.push(i);
+        rebuilt.updatePQ();
+        assert(rebuilt.getSize() == 3000 && rebuilt.getPushCount() == 3000);
+        assert(static_cast<double>(rebuilt.getCorruptedCount()) <= 0.2 * 3000);
+        cout << "Test 4 passed!\n" << endl;
+    }
+
+    cout << "\n\n********** END: Testing SoftPQ error bound **********\n" << endl;
+} // testSoftPQ()
+
+
+
+// One operation of the linearizability test: its value, and the clock
+// ticks at its invocation and response.
+struct TimedOp
+{
+    long value;
+    uint64_t start;
+    uint64_t end;
+};
+
+
+void testLockFreeSkipPQ()
+{
+    cout << "\n\n********** START: Testing LockFreeSkipPQ **********\n" << endl;
+
+    // Test 1: Sequential order, with both comparators, past several
+    // batched unlinks of the deleted prefix
+    {
+        cout << "Test 1: sequential order" << endl;
+        vector<int> vals;
+        for (int i = 0; i < 5000; ++i)
+            vals.push_back((i * 7919) % 1013);
+
+        LockFreeSkipPQ<int> maxPQ(vals.begin(), vals.end());
+        LockFreeSkipPQ<int, std::greater<int>> minPQ;
+        for (int val : vals)
+            minPQ.push(val);
+        assert(maxPQ.getSize() == vals.size() && !maxPQ.isEmpty());
+
+        vector<int> expected = vals;
+        sort(expected.begin(), expected.end(), std::greater<int>());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            [[maybe_unused]] int top = -1, popped = -1, low = -1;
+            [[maybe_unused]] bool gotTop = maxPQ.try_top(top);
+            assert(gotTop && top == expected[i]);
+            [[maybe_unused]] bool gotMax = maxPQ.try_pop(popped);
+            assert(gotMax && popped == expected[i]);
+            [[maybe_unused]] bool gotMin = minPQ.try_pop(low);
+            assert(gotMin && low == expected[expected.size() - 1 - i]);
+        }
+
+        [[maybe_unused]] int untouched = 42;
+        [[maybe_unused]] bool gotPop = maxPQ.try_pop(untouched);
+        [[maybe_unused]] bool gotTop = maxPQ.try_top(untouched);
+        assert(!gotPop && !gotTop && untouched == 42);
+        assert(maxPQ.isEmpty() && maxPQ.getSize() == 0 && minPQ.isEmpty());
+
+        // refill after the list was emptied
+        maxPQ.push(3);
+        maxPQ.push(8);
+        gotPop = maxPQ.try_pop(untouched);
+        assert(gotPop && untouched == 8 && maxPQ.getSize() == 1);
+        cout << "Test 1 passed!\n" << endl;
+    }
+
+    // Test 2: Concurrent pushes and pops lose and duplicate nothing
+    {
+        cout << "Test 2: no lost elements under contention" << endl;
+        const size_t threads = 8;
+        const long perThread = 10000;
+        LockFreeSkipPQ<long> pq;
+        vector<vector<long>> popped(threads);
+        vector<thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+            workers.emplace_back([&, t] {
+                for (long i = 0; i < perThread; ++i)
+                {
+                    pq.push(static_cast<long>(t) * perThread + i);
+                    long val;
+                    if (i % 3 == 0 && pq.try_pop(val))
+                        popped[t].push_back(val);
+                }
+            });
+        for (thread &worker : workers)
+            worker.join();
+
+        vector<long> all;
+        for (const vector<long> &mine : popped)
+            all.insert(all.end(), mine.begin(), mine.end());
+        assert(pq.getSize() == threads * perThread - all.size());
+        long val;
+        [[maybe_unused]] long last = LONG_MAX;
+        while (pq.try_pop(val))
+        {
+            assert(val < last);
+            last = val;
+            all.push_back(val);
+        }
+        sort(all.begin(), all.end());
+        assert(all.size() == threads * perThread);
+        for (size_t i = 0; i < all.size(); ++i)
+            assert(all[i] == static_cast<long>(i));
+        cout << "Test 2 passed!\n" << endl;
+    }
+
+    // Test 3: Linearizability. Every operation takes a tick of a global
+    // clock before and after it. An element u is certainly in the queue
+    // from the end of its push to the start of its pop, so a pop that
+    // returned v, or nothing, while some more extreme u was certainly in
+    // the queue for the whole pop cannot be ordered.
+    {
+        cout << "Test 3: linearizability" << endl;
+        const size_t threads = 4;
+        const long perThread = 1500;
+        for (int round = 0; round < 4; ++round)
+        {
+            LockFreeSkipPQ<long> pq;
+            atomic<uint64_t> clock{ 0 };
+            const uint64_t never = UINT64_MAX;
+            vector<TimedOp> pushes(threads * perThread);
+            vector<uint64_t> popStart(threads * perThread, never);
+            vector<vector<TimedOp>> pops(threads);
+            vector<thread> workers;
+            for (size_t t = 0; t < threads; ++t)
+                workers.emplace_back([&, t] {
+                    for (long i = 0; i < perThread; ++i)
+                    {
+                        // values interleave across threads, so pops see
+                        // elements of every thread
+                        long val = i * static_cast<long>(threads) + static_cast<long>(t);
+                        uint64_t start = clock.fetch_add(1);
+                        pq.push(val);
+                        pushes[static_cast<size_t>(val)] = { val, start, clock.fetch_add(1) };
+
+                        if ((i + round) % 2 == 0)
+                        {
+                            TimedOp op{ -1, clock.fetch_add(1), 0 };
+                            if (pq.try_pop(op.value))
+                                popStart[static_cast<size_t>(op.value)] = op.start;
+                            op.end = clock.fetch_add(1);
+                            pops[t].push_back(op);
+                        }
+                    }
+                });
+            for (thread &worker : workers)
+                worker.join();
+
+            for (const vector<TimedOp> &mine : pops)
+                for (const TimedOp &pop : mine)
+                {
+                    // a value is only popped after its push began
+                    if (pop.value >= 0)
+                        assert(pushes[static_cast<size_t>(pop.value)].start < pop.end);
+                    for (size_t u = static_cast<size_t>(pop.value + 1); u < pushes.size(); ++u)
+                        assert(!(pushes[u].end < pop.start && popStart[u] > pop.end));
+                }
+        }
+        cout << "Test 3 passed!\n" << endl;
+    }
+
+    cout << "\n\n********** END: Testing LockFreeSkipPQ **********\n" << endl;
+} // testLockFreeSkipPQ()
+
+
+
 void testExceptions() 
 {
     cout << "\n\n********** START: Testing Exception Handling (MA) **********\n" << endl;
@@ -2785,6 +3290,7 @@ int main()
         "Sorted",       // 2
         "Binary",       // 3
         "Pairing",      // 4
+        "Soft",         // 5
     }; // choice types
     
     unsigned int choice;
@@ -2807,12 +3313,14 @@ int main()
     {
         // Test using the default comparator,
         // which organizes in ascending order.
+        testArgExtreme();
         pq1 = new UnorderedPQ<int>;
         pq2 = new UnorderedPQ<int>(start, end);
 
     } // if
     else if (choice == 1)
     {
+        testArgExtreme();
         pq1 = new UnorderedPQOptimized<int>;
         pq2 = new UnorderedPQOptimized<int>(start, end);
     }
@@ -2831,11 +3339,15 @@ int main()
         testSortedPQ(pq2, types[choice]);
 
         runSortedPQEdgeTests(types[choice]);
+        testParallelUpdatePQHelper<SortedPQ<int *, IntPtrComp>>("SortedPQ");
     } // else if
     else if (choice == 3)
     {
         binTests();
         additionalBinPQEdgeTests();
+        testLockFreeSkipPQ();
+        testParallelUpdatePQHelper<BinPQ<int *, IntPtrComp>>("BinPQ");
+        testParallelUpdatePQHelper<BinPQ<int *, IntPtrComp, true>>("stable BinPQ");
         pq1 = new BinPQ<int>;
         pq2 = new BinPQ<int>(start, end);
     }
@@ -2859,6 +3371,12 @@ int main()
         pq1 = new PairingPQ<int>;
         pq2 = new PairingPQ<int>(start, end);
     }
+    else if (choice == 5)
+    {
+        testSoftPQ();
+        pq1 = new SoftPQ<int>;
+        pq2 = new SoftPQ<int>(start, end);
+    }
     else
     {
         cout << "Unknown container!" << endl
@@ -0,0 +1,781 @@
+// testBench.cpp
+//
+// Benchmarks for the priority queues. Build with 'make testBench' and run
+// './testBench [numElements]'.
+//
+// Each benchmark prints one line per container so that runs can be
+// diffed against each other.
+//
+
+
+#include "Eecs281PQ.h"
+#include "BinaryPQ.h"
+#include "PairingPQ.h"
+#include "SortedPQ.h"
+#include "UnorderedPQ.h"
+#include "UnorderedFastPQ.h"
+#include "TieredSortedPQ.h"
+#include "SearchKernel.h"
+#include "ArgExtreme.h"
+#include "TopK.h"
+#include "LockedPQ.h"
+#include "ConcurrentBinaryPQ.h"
+#include "MultiQueue.h"
+#include "BufferedConcurrentPQ.h"
+#include "TaskScheduler.h"
+#include "StagedPQ.h"
+#include "NumaShardedPQ.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+
+// Milliseconds elapsed since 'start'.
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+} // elapsedMs()
+
+
+
+// n uniformly random ints from a fixed seed, so every run sees the same input.
+vector<int> randomValues(size_t n)
+{
+    mt19937 gen(281);
+    uniform_int_distribution<int> dist(0, 1 << 30);
+    vector<int> values(n);
+    for (int &val : values)
+        val = dist(gen);
+    return values;
+} // randomValues()
+
+
+
+// Print one result line: container name, time, and throughput.
+void report(const string &name, double ms, size_t ops)
+{
+    double mops = static_cast<double>(ops) / (ms * 1000.0);
+    cout << left << setw(26) << name << right << fixed << setprecision(2)
+         << setw(12) << ms << setw(14) << mops << endl;
+} // report()
+
+
+
+// Push every value, then pop them all; returns the elapsed time.
+double pushThenPopAll(Eecs281PQ<int> &pq, const vector<int> &values)
+{
+    auto start = chrono::steady_clock::now();
+    for (int val : values)
+        pq.push(val);
+    while (!pq.empty())
+        pq.pop();
+    return elapsedMs(start);
+} // pushThenPopAll()
+
+
+
+// Sorted views of the book: random pushes into a sorted array, where
+// SortedPQ pays an O(n) memmove per push.
+void benchSortedPush(size_t n)
+{
+    cout << "\n********** Sorted arrays: push " << n
+         << " random, pop all **********\n" << endl;
+    cout << left << setw(26) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    vector<int> values = randomValues(n);
+
+    SortedPQ<int> flat;
+    report("SortedPQ", pushThenPopAll(flat, values), 2 * n);
+
+    TieredSortedPQ<int> tiered;
+    report("TieredSortedPQ", pushThenPopAll(tiered, values), 2 * n);
+} // benchSortedPush()
+
+
+
+// Lower bound of random probes in a sorted array of n ints, std::lower_bound
+// against the branchless, prefetching kernel that the sorted PQs use.
+void benchLowerBound(size_t n)
+{
+    cout << "\n********** lower_bound: " << n
+         << " probes into " << n << " sorted ints **********\n" << endl;
+    cout << left << setw(26) << "search" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    vector<int> sorted = randomValues(n);
+    sort(sorted.begin(), sorted.end());
+    vector<int> probes = randomValues(n);
+    reverse(probes.begin(), probes.end());
+
+    // the checksum keeps the searches from being optimized away
+    size_t stdSum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int probe : probes)
+        stdSum += static_cast<size_t>(lower_bound(sorted.begin(), sorted.end(), probe) - sorted.begin());
+    report("std::lower_bound", elapsedMs(start), n);
+
+    size_t fastSum = 0;
+    start = chrono::steady_clock::now();
+    for (int probe : probes)
+        fastSum += static_cast<size_t>(fastLowerBound(sorted.data(), sorted.data() + n,
+                                                      probe, std::less<int>()) - sorted.data());
+    report("fastLowerBound", elapsedMs(start), n);
+
+    if (stdSum != fastSum)
+        cout << "MISMATCH: the two searches disagree!" << endl;
+} // benchLowerBound()
+
+
+
+// Unordered arrays: every pop needs the extreme of everything left, so
+// these run on n / 20 elements. The order book workload is a steady
+// state of one push per pop.
+void benchUnordered(size_t n)
+{
+    size_t m = n / 20;
+    cout << "\n********** Unordered arrays: push " << m << ", then " << m
+         << " x (push, pop), then pop all **********\n" << endl;
+    cout << left << setw(26) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    vector<int> values = randomValues(2 * m);
+    auto run = [&](Eecs281PQ<int> &pq)
+    {
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < m; ++i)
+            pq.push(values[i]);
+        for (size_t i = m; i < 2 * m; ++i)
+        {
+            pq.push(values[i]);
+            pq.pop();
+        }
+        while (!pq.empty())
+            pq.pop();
+        return elapsedMs(start);
+    };
+
+    UnorderedPQ<int> plain;
+    report("UnorderedPQ", run(plain), 4 * m);
+    UnorderedFastPQ<int> fast;
+    report("UnorderedFastPQ", run(fast), 4 * m);
+} // benchUnordered()
+
+
+
+// Many tiny queues, as in one queue per instrument: n / 8 live queues each
+// get 8 pushes, then each is drained. Queues with inline storage for 16
+// elements never allocate.
+template <typename PQ>
+void benchTinyQueues(const string &name, const vector<int> &values)
+{
+    auto start = chrono::steady_clock::now();
+    size_t count = values.size() / 8;
+    vector<PQ> queues(count);
+    for (size_t i = 0; i < values.size(); ++i)
+        queues[i % count].push(values[i]);
+    long long sum = 0;
+    for (PQ &pq : queues)
+        while (!pq.empty())
+        {
+            sum += pq.top();
+            pq.pop();
+        }
+    queues.clear();
+    double ms = elapsedMs(start);
+    report(name + " (" + to_string(sizeof(PQ)) + " B)", ms, 2 * values.size());
+    if (sum == 42)
+        cout << sum << endl;
+} // benchTinyQueues()
+
+
+void benchInline(size_t n)
+{
+    cout << "\n********** " << n / 8 << " queues of 8 elements, vector vs inline storage "
+         << "**********\n" << endl;
+    cout << left << setw(26) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    vector<int> values = randomValues(n);
+    benchTinyQueues<BinaryPQ<int>>("BinaryPQ", values);
+    benchTinyQueues<BinaryPQ<int, less<int>, false, 16>>("BinaryPQ<16>", values);
+    benchTinyQueues<SortedPQ<int>>("SortedPQ", values);
+    benchTinyQueues<SortedPQ<int, less<int>, false, 16>>("SortedPQ<16>", values);
+    benchTinyQueues<UnorderedFastPQ<int>>("UnorderedFastPQ", values);
+    benchTinyQueues<UnorderedFastPQ<int, less<int>, false, 16>>("UnorderedFastPQ<16>", values);
+    benchTinyQueues<PairingPQ<int>>("PairingPQ", values);
+    benchTinyQueues<PairingPQ<int, less<int>, false, 16>>("PairingPQ<16>", values);
+} // benchInline()
+
+
+
+// The 100 largest of 50n random ints: heap everything and pop 100, or
+// stream through TopK one element at a time or in one batch.
+void benchTopK(size_t n)
+{
+    const size_t k = 100;
+    cout << "\n********** Top " << k << " of " << 50 * n << " random **********\n" << endl;
+    cout << left << setw(26) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Melts/s" << endl;
+
+    vector<int> values = randomValues(50 * n);
+
+    auto start = chrono::steady_clock::now();
+    BinaryPQ<int> heap(values.begin(), values.end());
+    vector<int> fromHeap;
+    for (size_t i = 0; i < k; ++i)
+    {
+        fromHeap.push_back(heap.top());
+        heap.pop();
+    } // for
+    report("BinaryPQ range + pop K", elapsedMs(start), values.size());
+
+    start = chrono::steady_clock::now();
+    TopK<int> single(k);
+    for (int val : values)
+        single.offer(val);
+    vector<int> fromSingle = single.snapshot();
+    report("TopK offer", elapsedMs(start), values.size());
+
+    start = chrono::steady_clock::now();
+    TopK<int> batch(k);
+    batch.offer_batch(values.data(), values.size());
+    vector<int> fromBatch = batch.snapshot();
+    report("TopK offer_batch", elapsedMs(start), values.size());
+
+    if (fromHeap != fromSingle || fromHeap != fromBatch)
+        cout << "MISMATCH: the top " << k << " differ!" << endl;
+} // benchTopK()
+
+
+
+// Prefill pq with n values, then let 'threads' threads share 'ops' calls
+// that alternate push() and try_pop(); returns the time of the second part.
+template <typename PQ>
+double sharedPushPop(PQ &pq, const vector<int> &values, size_t ops, size_t threads)
+{
+    for (size_t i = 0; i < values.size() / 2; ++i)
+        pq.push(values[i]);
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&pq, &values, ops, threads, t]() {
+            int out;
+            for (size_t i = t; i < ops; i += threads)
+            {
+                if (i % 2 == 0)
+                    pq.push(values[i % values.size()]);
+                else
+                    pq.try_pop(out);
+            } // for
+        });
+    } // for
+    for (thread &worker : workers)
+        worker.join();
+    return elapsedMs(start);
+} // sharedPushPop()
+
+
+// One BinaryPQ behind a mutex against the per-node locking heap, as the
+// number of threads sharing them grows.
+void benchConcurrent(size_t n)
+{
+    cout << "\n********** " << 4 * n << " mixed push / try_pop on a shared queue of "
+         << n / 2 << ", " << thread::hardware_concurrency() << " hardware threads **********\n"
+         << endl;
+    cout << left << setw(26) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    vector<int> values = randomValues(n);
+    for (size_t threads = 1; threads <= 64; threads *= 2)
+    {
+        LockedPQ<int> locked;
+        report("mutex, " + to_string(threads) + " threads",
+               sharedPushPop(locked, values, 4 * n, threads), 4 * n);
+        ConcurrentBinaryPQ<int> concurrent;
+        report("per-node, " + to_string(threads) + " threads",
+               sharedPushPop(concurrent, values, 4 * n, threads), 4 * n);
+    } // for
+} // benchConcurrent()
+
+
+
+// The relaxed MultiQueue against one locked queue as the number of threads
+// grows, and the rank error that c buys.
+void benchMultiQueue(size_t n)
+{
+    cout << "\n********** MultiQueue: " << 4 * n << " mixed push / try_pop on a queue of "
+         << n / 2 << " **********\n" << endl;
+    cout << left << setw(26) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    vector<int> values = randomValues(n);
+    for (size_t threads = 1; threads <= 64; threads *= 4)
+    {
+        LockedPQ<int> locked;
+        report("mutex, " + to_string(threads) + " threads",
+               sharedPushPop(locked, values, 4 * n, threads), 4 * n);
+        for (size_t c : {size_t{2}, size_t{4}})
+        {
+            MultiQueue<int> relaxed(threads, c);
+            report("c=" + to_string(c) + ", " + to_string(threads) + " threads",
+                   sharedPushPop(relaxed, values, 4 * n, threads), 4 * n);
+        } // for
+    } // for
+
+    // a thread preempted while it holds a shard keeps that shard out of
+    // play, so oversubscribed threads inflate the rank error
+    cout << "\n" << left << setw(26) << "rank error, 8c shards" << right << setw(12) << "mean"
+         << setw(14) << "worst" << endl;
+    for (size_t c : {size_t{1}, size_t{2}, size_t{4}, size_t{8}})
+    {
+        for (size_t threads : {size_t{1}, size_t{8}})
+        {
+            MultiQueue<int, less<int>, BinaryPQ<int>, true> tracked(8, c);
+            sharedPushPop(tracked, values, n, threads);
+            cout << left << setw(26) << "c=" + to_string(c) + ", " + to_string(threads) + " threads"
+                 << right << fixed << setprecision(2) << setw(12) << tracked.rank_stats().mean()
+                 << setw(14) << tracked.rank_stats().worst << endl;
+        } // for
+    } // for
+} // benchMultiQueue()
+
+
+
+// Let 'threads' threads share the pushes of every value; returns their
+// time. The queue is drained afterwards, untimed, to check that every value
+// arrived.
+template <typename PQ>
+double sharedIngest(PQ &pq, const vector<int> &values, size_t threads)
+{
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&pq, &values, threads, t]() {
+            for (size_t i = t; i < values.size(); i += threads)
+                pq.push(values[i]);
+        });
+    } // for
+    for (thread &worker : workers)
+        worker.join();
+    double ms = elapsedMs(start);
+
+    size_t popped = 0;
+    int out;
+    while (pq.try_pop(out))
+        ++popped;
+    if (popped != values.size())
+        cout << "MISMATCH: " << popped << " of " << values.size() << " values came out!" << endl;
+    return ms;
+} // sharedIngest()
+
+
+// Producers pushing into one PairingPQ behind a mutex against the same heap
+// behind per-thread buffers, which take the mutex once per buffer.
+void benchBuffered(size_t n)
+{
+    cout << "\n********** " << n << " pushes into one queue from several threads **********\n"
+         << endl;
+    cout << left << setw(26) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    // draining a queue scatters its nodes over the allocator's free lists,
+    // so drain one before timing any, for every run to start alike
+    vector<int> values = randomValues(n);
+    LockedPQ<int, PairingPQ<int>> warmup;
+    sharedIngest(warmup, values, 1);
+    for (size_t threads : {size_t{1}, size_t{4}, size_t{16}})
+    {
+        LockedPQ<int, PairingPQ<int>> locked;
+        report("mutex, " + to_string(threads) + " threads",
+               sharedIngest(locked, values, threads), n);
+        for (size_t buffer : {size_t{16}, size_t{256}})
+        {
+            BufferedConcurrentPQ<int> buffered(threads, buffer);
+            report("buffer " + to_string(buffer) + ", " + to_string(threads) + " threads",
+                   sharedIngest(buffered, values, threads), n);
+        } // for
+    } // for
+} // benchBuffered()
+
+
+
+// The share of pairs in 'order' where the less urgent (smaller) one comes
+// first, counted by merge sort: 0 for a perfect priority order.
+double invertedShare(vector<int> order)
+{
+    const size_t n = order.size();
+    if (n < 2)
+        return 0.0;
+    vector<int> merged(n);
+    double inverted = 0.0;
+    for (size_t width = 1; width < n; width *= 2)
+    {
+        for (size_t lo = 0; lo < n; lo += 2 * width)
+        {
+            size_t mid = min(lo + width, n), hi = min(lo + 2 * width, n);
+            size_t i = lo, j = mid, out = lo;
+            while (i < mid && j < hi)
+            {
+                // descending merge: a right element beating left ones is an
+                // inversion with each of them
+                if (order[i] >= order[j])
+                    merged[out++] = order[i++];
+                else
+                {
+                    inverted += static_cast<double>(mid - i);
+                    merged[out++] = order[j++];
+                } // else
+            } // while
+            copy(order.begin() + static_cast<ptrdiff_t>(i), order.begin() + static_cast<ptrdiff_t>(mid),
+                 merged.begin() + static_cast<ptrdiff_t>(out));
+            copy(order.begin() + static_cast<ptrdiff_t>(j), order.begin() + static_cast<ptrdiff_t>(hi),
+                 merged.begin() + static_cast<ptrdiff_t>(out + mid - i));
+        } // for
+        swap(order, merged);
+    } // for
+    return inverted / (static_cast<double>(n) * static_cast<double>(n - 1) / 2.0);
+} // invertedShare()
+
+
+// A task body of about 'iterations' dependent steps, that the optimizer
+// cannot drop.
+void spinWork(size_t iterations)
+{
+    static atomic<size_t> sink{ 0 };
+    size_t x = iterations;
+    for (size_t i = 0; i < iterations; ++i)
+        x = x * 2862933555777941757ULL + 3037000493ULL;
+    sink.fetch_add(x & 1, memory_order_relaxed);
+} // spinWork()
+
+
+// n small tasks of random priority, all ready at once: TaskScheduler's
+// per-worker queues against workers that share one LockedPQ, for
+// throughput and for how far the start order strays from priority order.
+void benchScheduler(size_t n)
+{
+    cout << "\n********** " << n << " tasks of random priority, "
+         << thread::hardware_concurrency() << " hardware threads **********\n" << endl;
+    cout << left << setw(26) << "scheduler" << right << setw(12) << "ms"
+         << setw(14) << "Mtasks/s" << setw(12) << "inverted" << endl;
+
+    const vector<int> priorities = randomValues(n);
+    const size_t work = 200;
+
+    for (size_t threads : {size_t{1}, size_t{4}, size_t{16}})
+    {
+        // one worker pushes every task onto a shared queue, that all of
+        // them pop the next task from
+        vector<int> started(n);
+        atomic<size_t> next{ 0 };
+        atomic<bool> seeded{ false };
+        LockedPQ<int> shared;
+        auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]() {
+                if (t == 0)
+                {
+                    for (int priority : priorities)
+                        shared.push(priority);
+                    seeded.store(true);
+                } // if
+                int priority;
+                while (next.load() < n)
+                {
+                    if (shared.try_pop(priority))
+                    {
+                        started[next.fetch_add(1)] = priority;
+                        spinWork(work);
+                    } // if
+                    else if (seeded.load())
+                        break;
+                } // while
+            });
+        } // for
+        for (thread &worker : workers)
+            worker.join();
+        report("one queue, " + to_string(threads) + " threads", elapsedMs(start), n);
+        cout << setw(52) << setprecision(4) << 100.0 * invertedShare(started) << "%" << endl;
+
+        // one task submits every task onto its worker's queue, for the
+        // others to steal from
+        next.store(0);
+        start = chrono::steady_clock::now();
+        {
+            TaskScheduler<int> scheduler(threads);
+            scheduler.submit(INT_MAX, [&]() {
+                for (int priority : priorities)
+                    scheduler.submit(priority, [&started, &next, priority]() {
+                        started[next.fetch_add(1)] = priority;
+                        spinWork(work);
+                    });
+            });
+            scheduler.wait();
+            report("stealing, " + to_string(threads) + " threads", elapsedMs(start), n);
+            TaskScheduler<int>::Stats stats = scheduler.stats();
+            cout << setw(52) << setprecision(4) << 100.0 * invertedShare(started) << "%"
+                 << "  (" << stats.steals << " steals of " << stats.stolen << " tasks)" << endl;
+        } // scope
+    } // for
+} // benchScheduler()
+
+
+
+// Let 'producers' threads share the pushes of every value while one owner
+// thread pops until it has them all; returns the time until it has.
+template <typename PQ>
+double ownerIngest(PQ &pq, const vector<int> &values, size_t producers)
+{
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (size_t t = 0; t < producers; ++t)
+    {
+        workers.emplace_back([&pq, &values, producers, t]() {
+            for (size_t i = t; i < values.size(); i += producers)
+                pq.push(values[i]);
+        });
+    } // for
+
+    size_t popped = 0;
+    int out;
+    while (popped < values.size())
+    {
+        if (pq.try_pop(out))
+            ++popped;
+        else
+            this_thread::yield();
+    } // while
+    double ms = elapsedMs(start);
+    for (thread &worker : workers)
+        worker.join();
+    return ms;
+} // ownerIngest()
+
+
+// A queue owned by one popping thread and fed by several producers: the
+// producers taking its mutex against handing values over a staging ring.
+void benchStaged(size_t n)
+{
+    cout << "\n********** " << n << " values from several producers to one owner **********\n"
+         << endl;
+    cout << left << setw(26) << "hand-off" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    vector<int> values = randomValues(n);
+    for (size_t producers : {size_t{1}, size_t{4}, size_t{16}})
+    {
+        const string threads = to_string(producers) + " producers";
+        LockedPQ<int> locked;
+        report("mutex, " + threads, ownerIngest(locked, values, producers), n);
+
+        StagedPQ<int> staged(1024, 256);
+        report("ring, " + threads, ownerIngest(staged, values, producers), n);
+
+        StagedPQ<int, BinaryPQ<int>, true, true> timed(1024, 256);
+        report("timed ring, " + threads, ownerIngest(timed, values, producers), n);
+        StagedPQ<int, BinaryPQ<int>, true, true>::Stats stats = timed.stats();
+        cout << "  " << stats.drains << " drains, largest batch " << stats.largestBatch
+             << ", " << stats.stalls << " stalls, mean wait " << setprecision(1)
+             << stats.meanLatency() / 1000.0 << " us, worst "
+             << static_cast<double>(stats.worstLatency) / 1000.0 << " us" << endl;
+    } // for
+} // benchStaged()
+
+
+
+// One PairingPQ behind a mutex against NumaShardedPQ, on the machine's own
+// nodes and on two simulated ones. On a single node the difference is the
+// cost of the tournament and the arenas, not remote accesses saved.
+void benchNuma(size_t n)
+{
+    const NumaTopology detected = NumaTopology::detect();
+    cout << "\n********** NUMA shards: " << 4 * n << " mixed push / try_pop on a queue of "
+         << n / 2 << ", " << detected.nodes() << " nodes **********\n" << endl;
+    cout << left << setw(26) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    vector<int> values = randomValues(n);
+    for (size_t threads : {size_t{1}, size_t{4}, size_t{16}})
+    {
+        const string suffix = ", " + to_string(threads) + " threads";
+        LockedPQ<int, PairingPQ<int>> locked;
+        report("mutex" + suffix, sharedPushPop(locked, values, 4 * n, threads), 4 * n);
+        NumaShardedPQ<int> native(detected);
+        report("sharded" + suffix, sharedPushPop(native, values, 4 * n, threads), 4 * n);
+        NumaShardedPQ<int> simulated(NumaTopology::simulate(2));
+        report("2 simulated" + suffix, sharedPushPop(simulated, values, 4 * n, threads), 4 * n);
+    } // for
+} // benchNuma()
+
+
+
+// Drain pq k elements at a time, by k plain pops or by one pop_batch(k);
+// returns the time, after checking both take the same elements.
+template <typename PQ>
+double drainInBatches(PQ pq, size_t k, bool batched)
+{
+    long long sum = 0;
+    auto start = chrono::steady_clock::now();
+    while (!pq.empty())
+    {
+        if (batched)
+        {
+            for (int val : pq.pop_batch(k))
+                sum += val;
+        } // if
+        else
+        {
+            for (size_t i = 0; i < k && !pq.empty(); ++i)
+            {
+                sum += pq.top();
+                pq.pop();
+            } // for
+        } // else
+    } // while
+    const double ms = elapsedMs(start);
+    static long long lastSum = 0;
+    if (!batched)
+        lastSum = sum;
+    else if (sum != lastSum)
+        cout << "MISMATCH: the batches popped other elements!" << endl;
+    return ms;
+} // drainInBatches()
+
+
+// Draining a heap of n in batches of k: k pops against pop_batch(k), on
+// as many threads as pop_batch() picks for itself.
+void benchPopBatch(size_t n)
+{
+    cout << "\n********** draining " << n << " elements in batches of k, "
+         << thread::hardware_concurrency() << " hardware threads **********\n" << endl;
+    cout << left << setw(26) << "container" << right << setw(12) << "ms"
+         << setw(14) << "Mops/s" << endl;
+
+    vector<int> values = randomValues(n);
+    BinaryPQ<int> binary(values.begin(), values.end());
+    PairingPQ<int> pairing(values.begin(), values.end());
+    for (size_t k : {size_t{64}, n / 64, n / 8, n / 4, n / 2})
+    {
+        const string batch = ", k=" + to_string(k);
+        report("BinaryPQ pops" + batch, drainInBatches(binary, k, false), n);
+        report("BinaryPQ batch" + batch, drainInBatches(binary, k, true), n);
+        report("PairingPQ pops" + batch, drainInBatches(pairing, k, false), n);
+        report("PairingPQ batch" + batch, drainInBatches(pairing, k, true), n);
+    } // for
+} // benchPopBatch()
+
+
+
+// The full scan behind the unordered queues' top(): the scalar loop against
+// argExtreme(), for ints and for a functor it cannot vectorize.
+void benchArgExtreme()
+{
+    cout << "\n********** argmax scans, repeated to 64M elements each **********\n" << endl;
+    cout << left << setw(26) << "scan" << right << setw(12) << "ms"
+         << setw(14) << "Melts/s" << endl;
+
+    auto byLastDigit = [](int a, int b) { return a % 10 < b % 10; };
+    for (size_t n : {size_t{1024}, size_t{65536}, size_t{1} << 20})
+    {
+        const vector<int> original = randomValues(n);
+        vector<int> values = original;
+        size_t reps = (size_t{1} << 26) / n;
+
+        // every scan sees the same sequence of arrays: each repetition
+        // flips one low bit, so the answer keeps changing
+
+        // the checksums keep the scans from being optimized away
+        size_t scalarSum = 0, kernelSum = 0, genericSum = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t r = 0; r < reps; ++r)
+        {
+            size_t top = 0;
+            for (size_t i = 1; i < n; ++i)
+                if (values[top] < values[i])
+                    top = i;
+            scalarSum += top;
+            values[r % n] ^= 1;
+        }
+        report("scalar n=" + to_string(n), elapsedMs(start), reps * n);
+
+        values = original;
+        start = chrono::steady_clock::now();
+        for (size_t r = 0; r < reps; ++r)
+        {
+            kernelSum += argExtreme(values.data(), n, std::less<int>());
+            values[r % n] ^= 1;
+        }
+        report("argExtreme n=" + to_string(n), elapsedMs(start), reps * n);
+
+        size_t scalarGenericSum = 0;
+        values = original;
+        start = chrono::steady_clock::now();
+        for (size_t r = 0; r < reps; ++r)
+        {
+            size_t top = 0;
+            for (size_t i = 1; i < n; ++i)
+                if (byLastDigit(values[top], values[i]))
+                    top = i;
+            scalarGenericSum += top;
+            values[r % n] ^= 1;
+        }
+        report("  scalar, custom functor", elapsedMs(start), reps * n);
+
+        values = original;
+        start = chrono::steady_clock::now();
+        for (size_t r = 0; r < reps; ++r)
+        {
+            genericSum += argExtreme(values.data(), n, byLastDigit);
+            values[r % n] ^= 1;
+        }
+        report("  argExtreme, custom", elapsedMs(start), reps * n);
+
+        if (scalarSum != kernelSum)
+            cout << "MISMATCH: the scans disagree!" << endl;
+        if (scalarGenericSum != genericSum)
+            cout << "MISMATCH: the custom functor scans disagree!" << endl;
+    } // for
+} // benchArgExtreme()
+
+
+
+int main(int argc, char *argv[])
+{
+    size_t n = 200000;
+    if (argc > 1)
+        n = static_cast<size_t>(strtoull(argv[1], nullptr, 10));
+
+    benchSortedPush(n);
+    benchLowerBound(n);
+    benchUnordered(n);
+    benchArgExtreme();
+    benchInline(n);
+    benchTopK(n);
+    benchConcurrent(n);
+    benchMultiQueue(n);
+    benchBuffered(n);
+    benchScheduler(n);
+    benchStaged(n);
+    benchNuma(n);
+    benchPopBatch(n);
+
+    return 0;
+} // main()
@@ -29,6 +29,13 @@
 #include <climits> // For INT_MAX and INT_MIN
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <set>
+#include <thread>
 
 #include "Eecs281PQ.h"
 #include "BinaryPQ.h"
@@ -36,6 +43,26 @@
 #include "UnorderedFastPQ.h"
 #include "PairingPQ.h"
 #include "SortedPQ.h"
+#include "LoserTree.h"
+#include "IndexedBinaryPQ.h"
+#include "TieredSortedPQ.h"
+#include "SearchKernel.h"
+#include "ArgExtreme.h"
+#include "IntPQ.h"
+#include "AdaptivePQ.h"
+#include "SmallVector.h"
+#include "BoundedPQ.h"
+#include "TopK.h"
+#include "LockedPQ.h"
+#include "ConcurrentBinaryPQ.h"
+#include "MultiQueue.h"
+#include "BufferedConcurrentPQ.h"
+#include "TaskScheduler.h"
+#include "StagingRing.h"
+#include "StagedPQ.h"
+#include "ConcurrentPairingPQ.h"
+#include "NodeArena.h"
+#include "NumaShardedPQ.h"
 
 using namespace std;
 
@@ -1030,6 +1057,42 @@ void testPairing(vector<int> & vec)
     pq1->pop();
     pq1->pop();
     assert(pq1->top() == 33);
+
+    // addNode() returns the new element's node, not the root
+    PairingPQ<int> nodes;
+    nodes.updatePriorities();
+    [[maybe_unused]] PairingPQ<int>::Node *high = nodes.addNode(50);
+    PairingPQ<int>::Node *low = nodes.addNode(10);
+    assert(high->getElt() == 50 && **low == 10);
+    nodes.updateElt(low, 60);
+    assert(nodes.top() == 60);
+
+    // an empty heap copies to an empty heap
+    PairingPQ<int> none;
+    PairingPQ<int> noneCopy(none);
+    noneCopy = none;
+    assert(noneCopy.empty() && noneCopy.size() == 0);
+
+    // updatePriorities() relinks nodes that have children of their own
+    vector<int> prios(40);
+    PairingPQ<int *, IntPtrComp> ptrs;
+    for (size_t i = 0; i < prios.size(); ++i)
+    {
+        prios[i] = static_cast<int>(i * 7 % 40);
+        ptrs.push(&prios[i]);
+    } // for
+    ptrs.pop();
+    for (size_t i = 0; i < prios.size(); ++i)
+        prios[i] = static_cast<int>(i * 13 % 41);
+    ptrs.updatePriorities();
+    size_t drained = 0;
+    for ([[maybe_unused]] int last = INT_MAX; !ptrs.empty(); ++drained)
+    {
+        assert(*ptrs.top() <= last);
+        last = *ptrs.top();
+        ptrs.pop();
+    } // for
+    assert(drained == prios.size() - 1);
     
     
     cout << "Calling destructors" << endl;
@@ -1724,6 +1787,22 @@ int binTests()
     std::cout << "Test 5 - Top after updatePQ: " << pq5.top() << std::endl; // Should be 20
     assert(pq5.top() == 20);
 
+
+    // Test 6: replace_top (pop + push in a single fixDown)
+    BinaryPQ<int> pq6(vec.begin(), vec.end());
+    pq6.replace_top(4); // 9 out, 4 in
+    std::cout << "Test 6 - Top after replace_top(4): " << pq6.top() << std::endl; // Should be 8
+    assert(pq6.top() == 8 && pq6.size() == vec.size());
+    pq6.replace_top(100);
+    assert(pq6.top() == 100);
+    std::vector<int> drained;
+    while (!pq6.empty())
+    {
+        drained.push_back(pq6.top());
+        pq6.pop();
+    }
+    assert((drained == std::vector<int>{100, 5, 4, 3, 2, 1}));
+
     cout << "\n\n********** END: Testing BinaryPQ **********\n" << endl;
 
     return 0;
@@ -1731,6 +1810,2182 @@ int binTests()
 
 
 
+// Orders (priority, arrival) pairs on priority alone, so pairs with equal
+// priority are ties as far as the PQ can tell.
+struct PriorityOnly
+{
+    bool operator()(const pair<int, int> &a, const pair<int, int> &b) const
+    {
+        return a.first < b.first;
+    }
+}; // PriorityOnly
+
+
+// Check every argExtreme() kernel against the plain scalar scan, on sizes
+// around the lane and chunk widths, with many duplicates so that the first
+// index among equals matters.
+template <typename TYPE, typename COMP>
+void testArgExtremeHelper(const COMP &comp)
+{
+    size_t seed = 99;
+    for (size_t n : {1, 2, 3, 4, 5, 15, 16, 17, 31, 33, 64, 100, 1000, 300000})
+    {
+        vector<TYPE> data(n);
+        for (TYPE &val : data)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            val = static_cast<TYPE>((seed >> 33) % 97);
+        } // for
+
+        size_t expected = 0;
+        for (size_t i = 1; i < n; ++i)
+            if (comp(data[expected], data[i]))
+                expected = i;
+        assert(argExtreme(data.data(), n, comp) == expected);
+    } // for
+} // testArgExtremeHelper()
+
+
+void testArgExtreme()
+{
+    cout << "\n\n********** START: Testing argExtreme kernels **********\n" << endl;
+    testArgExtremeHelper<int>(std::less<int>());
+    testArgExtremeHelper<int>(std::greater<int>());
+    testArgExtremeHelper<double>(std::less<double>());
+    testArgExtremeHelper<unsigned char>(std::greater<unsigned char>());
+    testArgExtremeHelper<long>([](long a, long b) { return a % 10 < b % 10; });
+    cout << "\n\n********** END: Testing argExtreme kernels **********\n" << endl;
+} // testArgExtreme()
+
+
+
+// Test UnorderedFastPQ's candidate cache against BinaryPQ: long runs of pops
+// that use up the candidates, pushes that do and do not get in, and
+// updatePriorities() in between, for vectorized and plain keys.
+template <typename TYPE, typename COMP>
+void testUnorderedFastPQCandidates()
+{
+    UnorderedFastPQ<TYPE, COMP> fast;
+    BinaryPQ<TYPE, COMP> heap;
+    size_t seed = 4242;
+    auto next = [&seed]() { seed = seed * 6364136223846793005ULL + 1442695040888963407ULL; return seed >> 33; };
+
+    for (int step = 0; step < 40000; ++step)
+    {
+        size_t op = next() % 10;
+        if (op < 5 || heap.empty())
+        {
+            TYPE val = static_cast<TYPE>(next() % 3000);
+            fast.push(val);
+            heap.push(val);
+        }
+        else if (op < 9)
+        {
+            assert(fast.top() == heap.top());
+            fast.pop();
+            heap.pop();
+        }
+        else if (next() % 50 == 0)
+            fast.updatePriorities();
+        assert(fast.size() == heap.size());
+        if (!heap.empty())
+            assert(fast.top() == heap.top());
+    } // for
+
+    while (!heap.empty())
+    {
+        assert(fast.top() == heap.top());
+        fast.pop();
+        heap.pop();
+    } // while
+} // testUnorderedFastPQCandidates()
+
+
+void testUnorderedFastPQ()
+{
+    cout << "\n\n********** START: Testing UnorderedFastPQ's candidates **********\n" << endl;
+    testUnorderedFastPQCandidates<int, std::less<int>>();
+    testUnorderedFastPQCandidates<int, std::greater<int>>();
+    testUnorderedFastPQCandidates<double, std::less<double>>();
+    testUnorderedFastPQCandidates<long, std::less<>>();
+
+    // enough elements for the parallel search, where there are cores
+    vector<int> big(600000);
+    for (size_t i = 0; i < big.size(); ++i)
+        big[i] = static_cast<int>((i * 2654435761u) % 1000003);
+    UnorderedFastPQ<int> wide(big.begin(), big.end());
+    sort(big.begin(), big.end());
+    for (size_t i = 0; i < 20; ++i)
+    {
+        assert(wide.top() == big[big.size() - 1 - i]);
+        wide.pop();
+    }
+
+    // a range ctor of more than one block, then pushes while unknown
+    vector<int> vals;
+    for (int i = 0; i < 1000; ++i)
+        vals.push_back((i * 7919) % 997);
+    UnorderedFastPQ<int> pq(vals.begin(), vals.end());
+    pq.push(5000);
+    pq.push(-1);
+    sort(vals.begin(), vals.end());
+    vals.insert(vals.begin(), -1);
+    vals.push_back(5000);
+    for (auto it = vals.rbegin(); it != vals.rend(); ++it)
+    {
+        assert(pq.top() == *it);
+        pq.pop();
+    }
+    assert(pq.empty());
+    cout << "\n\n********** END: Testing UnorderedFastPQ's candidates **********\n" << endl;
+} // testUnorderedFastPQ()
+
+
+
+// Test the integer-key queue against a std::multiset, including erase(),
+// successor() and predecessor(), which the other PQs cannot do cheaply.
+void testIntPQ()
+{
+    cout << "\n\n********** START: Testing IntPQ **********\n" << endl;
+
+    // Test 1: basic max-first and min-first behavior, extreme keys
+    cout << "Test 1: basic push/pop with extreme keys..." << endl;
+    IntPQ<> maxPQ;
+    IntPQ<std::greater<uint32_t>> minPQ;
+    for (uint32_t key : {7u, 0u, UINT32_MAX, 64u, 63u, 4096u, 7u})
+    {
+        maxPQ.push(key);
+        minPQ.push(key);
+    }
+    assert(maxPQ.size() == 7 && minPQ.size() == 7);
+    assert(maxPQ.top() == UINT32_MAX && minPQ.top() == 0);
+    maxPQ.pop();
+    minPQ.pop();
+    assert(maxPQ.top() == 4096 && minPQ.top() == 7);
+    minPQ.pop();
+    assert(minPQ.top() == 7 && "Duplicate key should still be there");
+    minPQ.pop();
+    assert(minPQ.top() == 63);
+    cout << "Test 1 passed!" << endl;
+
+    // Test 2: successor/predecessor/contains/erase on a sparse set
+    cout << "Test 2: successor and predecessor..." << endl;
+    IntPQ<> levels;
+    for (uint32_t key : {100u, 200u, 1u << 20, (1u << 30) + 5, UINT32_MAX})
+        levels.push(key);
+    assert(levels.successor(0) == 100u);
+    assert(levels.successor(100) == 200u);
+    assert(levels.successor(200) == (1u << 20));
+    assert(levels.successor((1u << 20)) == (1u << 30) + 5);
+    assert(levels.successor(UINT32_MAX) == std::nullopt);
+    assert(levels.predecessor(100) == std::nullopt);
+    assert(levels.predecessor(UINT32_MAX) == (1u << 30) + 5);
+    assert(levels.predecessor(150) == 100u);
+    assert(levels.contains(200) && !levels.contains(201));
+    [[maybe_unused]] bool erased = levels.erase(200);
+    [[maybe_unused]] bool erasedAgain = levels.erase(200);
+    assert(erased && !erasedAgain);
+    assert(levels.successor(100) == (1u << 20));
+    erased = levels.erase(UINT32_MAX);
+    assert(erased);
+    assert(levels.top() == (1u << 30) + 5);
+    cout << "Test 2 passed!" << endl;
+
+    // Test 3: random operations cross-checked against std::multiset
+    cout << "Test 3: random operations vs. std::multiset..." << endl;
+    IntPQ<> pq;
+    std::multiset<uint32_t> ref;
+    uint32_t state = 2463534242u;
+    auto next = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+    for (int i = 0; i < 20000; ++i)
+    {
+        // Keep keys clustered sometimes so nodes get shared and freed.
+        uint32_t key = (i % 2) ? next() : (next() % 4096);
+        switch (next() % 5)
+        {
+        case 0:
+        case 1:
+            pq.push(key);
+            ref.insert(key);
+            break;
+        case 2:
+            if (!ref.empty())
+            {
+                assert(pq.top() == *ref.rbegin());
+                pq.pop();
+                ref.erase(std::prev(ref.end()));
+            }
+            break;
+        case 3:
+        {
+            auto it = ref.find(key);
+            [[maybe_unused]] bool erased = pq.erase(key);
+            assert(erased == (it != ref.end()));
+            if (it != ref.end())
+                ref.erase(it);
+            break;
+        }
+        default:
+        {
+            [[maybe_unused]] auto up = ref.upper_bound(key);
+            [[maybe_unused]] auto lo = ref.lower_bound(key);
+            auto succ = pq.successor(key);
+            auto pred = pq.predecessor(key);
+            assert(succ.has_value() == (up != ref.end()));
+            if (succ) assert(*succ == *up);
+            assert(pred.has_value() == (lo != ref.begin()));
+            if (pred) assert(*pred == *std::prev(lo));
+            assert(pq.contains(key) == (ref.count(key) != 0));
+        }
+        } // switch
+        assert(pq.size() == ref.size());
+        if (!ref.empty())
+            assert(pq.top() == *ref.rbegin());
+    }
+    cout << "Test 3 passed!" << endl;
+
+    // Test 4: range ctor and the generic Eecs281PQ interface
+    cout << "Test 4: range ctor..." << endl;
+    vector<uint32_t> keys = {5, 3, 9, 1};
+    IntPQ<std::greater<uint32_t>> fromRange(keys.begin(), keys.end());
+    Eecs281PQ<uint32_t, std::greater<uint32_t>> *base = &fromRange;
+    base->updatePriorities();
+    assert(base->top() == 1 && base->size() == 4);
+    cout << "Test 4 passed!" << endl;
+
+    cout << "\n\n********** END: Testing IntPQ **********\n" << endl;
+} // testIntPQ()
+
+
+
+// Test the tiered sorted array against SortedPQ, with enough elements that
+// blocks get split many times.
+void testTieredSortedPQ()
+{
+    cout << "\n\n********** START: Testing TieredSortedPQ **********\n" << endl;
+
+    // Test 1: random pushes and pops match SortedPQ
+    cout << "Test 1: random pushes and pops vs. SortedPQ..." << endl;
+    TieredSortedPQ<int> tiered;
+    SortedPQ<int> flat;
+    size_t seed = 281;
+    auto next = [&seed]() { seed = seed * 6364136223846793005ULL + 1442695040888963407ULL; return seed >> 33; };
+    for (int step = 0; step < 30000; ++step)
+    {
+        if (next() % 3 != 0 || flat.empty())
+        {
+            int val = static_cast<int>(next() % 5000);
+            tiered.push(val);
+            flat.push(val);
+        }
+        else
+        {
+            assert(tiered.top() == flat.top());
+            tiered.pop();
+            flat.pop();
+        }
+        assert(tiered.size() == flat.size());
+    } // for
+    cout << "Test 1 passed!" << endl;
+
+    // Test 2: iteration is in sorted order, ending at top()
+    cout << "Test 2: sorted iteration..." << endl;
+    assert(is_sorted(tiered.begin(), tiered.end()));
+    assert(static_cast<size_t>(distance(tiered.begin(), tiered.end())) == tiered.size());
+    [[maybe_unused]] int last = 0;
+    for (int val : tiered)
+        last = val;
+    assert(last == tiered.top());
+    cout << "Test 2 passed!" << endl;
+
+    // Test 3: range ctor and updatePriorities with a min-first functor
+    cout << "Test 3: range ctor and updatePriorities..." << endl;
+    vector<int> vals;
+    for (int i = 0; i < 5000; ++i)
+        vals.push_back((i * 7919) % 4999);
+    TieredSortedPQ<int, std::greater<int>> minFirst(vals.begin(), vals.end());
+    minFirst.updatePriorities();
+    sort(vals.begin(), vals.end());
+    for ([[maybe_unused]] int val : vals)
+    {
+        assert(minFirst.top() == val);
+        minFirst.pop();
+    }
+    assert(minFirst.empty() && minFirst.begin() == minFirst.end());
+    cout << "Test 3 passed!" << endl;
+
+    cout << "\n\n********** END: Testing TieredSortedPQ **********\n" << endl;
+} // testTieredSortedPQ()
+
+
+
+// Test SortedPQ's insertion buffer and its run-detecting sort: tops that come
+// from the buffer, pops that force a merge, and rebuilds of inputs with
+// long runs.
+void testSortedPQBuffer()
+{
+    cout << "\n\n********** START: Testing SortedPQ's insertion buffer **********\n" << endl;
+
+    // Test 1: interleaved pushes and pops vs. BinaryPQ
+    cout << "Test 1: interleaved pushes and pops vs. BinaryPQ..." << endl;
+    SortedPQ<int> sorted;
+    BinaryPQ<int> heap;
+    for (int i = 0; i < 20000; ++i)
+    {
+        int val = (i * 7919) % 10007;
+        sorted.push(val);
+        heap.push(val);
+        assert(sorted.top() == heap.top());
+        if (i % 3 == 0)
+        {
+            sorted.pop();
+            heap.pop();
+        }
+        if (i % 1000 == 0)
+            sorted.updatePriorities();
+        assert(sorted.size() == heap.size());
+    } // for
+    while (!heap.empty())
+    {
+        assert(sorted.top() == heap.top());
+        sorted.pop();
+        heap.pop();
+    } // while
+    assert(sorted.empty());
+    cout << "Test 1 passed!" << endl;
+
+    // Test 2: range ctor on ascending, descending, sawtooth and random input
+    cout << "Test 2: run-detecting sort..." << endl;
+    vector<vector<int>> inputs(4);
+    for (int i = 0; i < 3000; ++i)
+    {
+        inputs[0].push_back(i);
+        inputs[1].push_back(3000 - i);
+        inputs[2].push_back(i % 250);
+        inputs[3].push_back((i * 104729) % 3001);
+    }
+    for (const vector<int> &in : inputs)
+    {
+        SortedPQ<int, std::greater<int>> minFirst(in.begin(), in.end());
+        vector<int> expected = in;
+        sort(expected.begin(), expected.end());
+        for ([[maybe_unused]] int val : expected)
+        {
+            assert(minFirst.top() == val);
+            minFirst.pop();
+        }
+    } // for
+    cout << "Test 2 passed!" << endl;
+
+    cout << "\n\n********** END: Testing SortedPQ's insertion buffer **********\n" << endl;
+} // testSortedPQBuffer()
+
+
+
+// Test fastLowerBound() against std::lower_bound on every size up to past
+// the linear tail, with duplicates, and with each kind of comparator.
+template <typename TYPE, typename COMP>
+void testFastLowerBoundHelper(COMP comp)
+{
+    for (size_t n = 0; n < 200; n += (n < 80 ? 1 : 17))
+    {
+        vector<TYPE> vals;
+        for (size_t i = 0; i < n; ++i)
+            vals.push_back(static_cast<TYPE>((i * 37) % 50));
+        sort(vals.begin(), vals.end(), comp);
+
+        for (int probe = -1; probe <= 51; ++probe)
+        {
+            TYPE val = static_cast<TYPE>(probe);
+            [[maybe_unused]] auto expected = lower_bound(vals.begin(), vals.end(), val, comp) - vals.begin();
+            [[maybe_unused]] auto actual = fastLowerBound(vals.data(), vals.data() + vals.size(), val, comp) - vals.data();
+            assert(expected == actual);
+        } // for
+    } // for
+} // testFastLowerBoundHelper()
+
+
+void testFastLowerBound()
+{
+    cout << "\n\n********** START: Testing fastLowerBound **********\n" << endl;
+    testFastLowerBoundHelper<int>(std::less<int>());
+    testFastLowerBoundHelper<int>(std::greater<int>());
+    testFastLowerBoundHelper<double>(std::less<double>());
+    testFastLowerBoundHelper<int>([](int a, int b) { return a % 50 < b % 50; });
+    cout << "\n\n********** END: Testing fastLowerBound **********\n" << endl;
+} // testFastLowerBound()
+
+
+
+// Test SortedPQ's read-only views: iteration, top_n, rank, select and
+// count_between, over pushes that sorted_view() merged out of the buffer.
+void testSortedPQViews()
+{
+    cout << "\n\n********** START: Testing SortedPQ's views **********\n" << endl;
+
+    SortedPQ<int> book;
+    vector<int> prices = {101, 99, 103, 100, 99, 105, 102, 99};
+    for (int price : prices)
+        book.push(price);
+    const SortedPQ<int> &view = book.sorted_view();
+
+    // Test 1: iteration is sorted and leaves the PQ intact
+    cout << "Test 1: sorted iteration..." << endl;
+    vector<int> expected = prices;
+    sort(expected.begin(), expected.end());
+    assert(vector<int>(view.begin(), view.end()) == expected);
+    assert(view.size() == prices.size() && view.top() == 105);
+    cout << "Test 1 passed!" << endl;
+
+    // Test 2: top_n is most extreme first, and clamps to size()
+    cout << "Test 2: top_n..." << endl;
+    vector<int> top3(view.top_n(3).begin(), view.top_n(3).end());
+    assert((top3 == vector<int>{105, 103, 102}));
+    assert(static_cast<size_t>(std::ranges::distance(view.top_n(100))) == view.size());
+    assert(std::ranges::empty(view.top_n(0)));
+    cout << "Test 2 passed!" << endl;
+
+    // Test 3: rank, select and count_between agree with the sorted order
+    cout << "Test 3: rank, select and count_between..." << endl;
+    assert(view.rank(105) == 0 && view.rank(106) == 0 && view.rank(99) == 5);
+    assert(view.rank(98) == view.size());
+    for (size_t i = 0; i < view.size(); ++i)
+        assert(view.select(i) == expected[expected.size() - 1 - i]);
+    assert(view.count_between(99, 101) == 5);
+    assert(view.count_between(100, 100) == 1);
+    assert(view.count_between(104, 104) == 0);
+    assert(view.count_between(0, 1000) == view.size());
+    assert(view.count_between(103, 100) == 0);
+    cout << "Test 3 passed!" << endl;
+
+    // Test 4: views after pops and fresh pushes
+    cout << "Test 4: views after more pushes and pops..." << endl;
+    book.pop();
+    book.push(104);
+    book.push(98);
+    book.sorted_view();
+    assert(view.select(0) == 104 && view.rank(98) == view.size() - 1);
+    assert(is_sorted(view.begin(), view.end()));
+    cout << "Test 4 passed!" << endl;
+
+    // Test 5: the views only read, so threads may share them
+    cout << "Test 5: concurrent readers..." << endl;
+    vector<thread> readers;
+    for (int t = 0; t < 4; ++t)
+        readers.emplace_back([&]()
+        {
+            for (int i = 0; i < 100; ++i)
+                assert(view.rank(view.select(2)) == 2 && view.count_between(0, 1000) == view.size());
+        });
+    for (thread &reader : readers)
+        reader.join();
+    cout << "Test 5 passed!" << endl;
+
+    cout << "\n\n********** END: Testing SortedPQ's views **********\n" << endl;
+} // testSortedPQViews()
+
+
+
+// Scramble the priorities behind a queue of pointers, then rebuild copies
+// of it serially and on several threads: each must hold the same pointers
+// in the same slots. Priorities repeat, so equal elements only agree if the
+// rebuilds order them alike, and the sizes straddle the points where the
+// rebuild stays serial.
+template <typename PQ, typename CONTENTS>
+void testParallelRebuildHelper(const string &pqType, const CONTENTS &contents)
+{
+    cout << "Testing parallel updatePriorities() of " << pqType << "..." << endl;
+    for (size_t n : {0, 1, 2, 31, 64, 65, 1000, 4097, 100003})
+    {
+        vector<int> priorities(n);
+        vector<int *> ptrs;
+        for (size_t i = 0; i < n; ++i)
+        {
+            priorities[i] = static_cast<int>(i * 7919 % 1009);
+            ptrs.push_back(&priorities[i]);
+        } // for
+        PQ pq(ptrs.begin(), ptrs.end(), IntPtrComp());
+        for (size_t i = 0; i < n; ++i)
+            priorities[i] = static_cast<int>((i * 104729 + 17) % 251);
+        int extra[3] = {250, 3, 100};
+        for (int &val : extra)
+            pq.push(&val);
+
+        PQ serial(pq);
+        serial.updatePriorities(1);
+        vector<int *> expected = contents(serial);
+        assert(expected.size() == n + 3);
+        for (size_t threads : {2, 3, 4, 7})
+        {
+            PQ parallel(pq);
+            parallel.updatePriorities(threads);
+            assert(contents(parallel) == expected);
+        } // for
+
+        [[maybe_unused]] int last = INT_MAX;
+        while (!serial.empty())
+        {
+            assert(*serial.top() <= last);
+            last = *serial.top();
+            serial.pop();
+        } // while
+    } // for
+} // testParallelRebuildHelper()
+
+
+// Test BinaryPQ's heap-order view and its partial-sort top_n.
+void testBinaryPQViews()
+{
+    cout << "\n\n********** START: Testing BinaryPQ's views **********\n" << endl;
+
+    vector<int> vals;
+    for (int i = 0; i < 1000; ++i)
+        vals.push_back((i * 7919) % 997);
+    BinaryPQ<int> pq(vals.begin(), vals.end());
+
+    // heap_order() holds every element, with top() first
+    vector<int> inHeap(pq.heap_order().begin(), pq.heap_order().end());
+    assert(inHeap.size() == vals.size() && inHeap.front() == pq.top());
+    sort(inHeap.begin(), inHeap.end());
+    vector<int> sorted = vals;
+    sort(sorted.begin(), sorted.end());
+    assert(inHeap == sorted);
+
+    // top_n(k) is the k largest, most extreme first
+    for (size_t k : {size_t{0}, size_t{1}, size_t{10}, size_t{999}, size_t{1000}, size_t{5000}})
+    {
+        vector<int> best = pq.top_n(k);
+        assert(best.size() == min(k, vals.size()));
+        assert(equal(best.begin(), best.end(), sorted.rbegin()));
+    } // for
+    assert(pq.size() == vals.size());
+
+    // stable mode returns elements, ties in FIFO order
+    BinaryPQ<pair<int, int>, PriorityOnly, true> fifo;
+    for (int i = 0; i < 6; ++i)
+        fifo.push({i % 2, i});
+    vector<pair<int, int>> first4 = fifo.top_n(4);
+    assert(first4[0].second == 1 && first4[1].second == 3 && first4[2].second == 5 && first4[3].second == 0);
+
+    cout << "\n\n********** END: Testing BinaryPQ's views **********\n" << endl;
+} // testBinaryPQViews()
+
+
+
+// Pop batches of k from copies of pq, on 1 to 4 threads, and check each
+// batch against k plain pops: the same elements in the same order, and the
+// same elements left behind. Priorities repeat, and ties carry their push
+// order, so in stable mode ties must also come out in FIFO order.
+template <typename PQ>
+void testPopBatchHelper(const PQ &pq, const vector<size_t> &ks)
+{
+    for (size_t k : ks)
+    {
+        PQ popped(pq);
+        vector<pair<int, int>> expected;
+        while (expected.size() < k && !popped.empty())
+        {
+            expected.push_back(popped.top());
+            popped.pop();
+        } // while
+
+        for (size_t threads : {1, 2, 4})
+        {
+            PQ batched(pq);
+            vector<pair<int, int>> batch = batched.pop_batch(k, threads);
+            assert(batch == expected);
+            assert(batched.size() == popped.size());
+            PQ rest(popped);
+            while (!rest.empty())
+            {
+                assert(batched.top() == rest.top());
+                batched.pop();
+                rest.pop();
+            } // while
+            assert(batched.empty());
+        } // for
+    } // for
+} // testPopBatchHelper()
+
+
+// Test pop_batch() on BinaryPQ and PairingPQ, stable and not, across the
+// batch sizes where BinaryPQ stops popping one by one and where its sort
+// and PairingPQ's child lists are split across threads; and the one-by-one
+// pop_batch() every PQ gets from Eecs281PQ.
+void testPopBatch()
+{
+    cout << "\n\n********** START: Testing pop_batch() **********\n" << endl;
+
+    // Test 1: BinaryPQ, from tiny heaps to ones whose batches split
+    cout << "Test 1: BinaryPQ..." << endl;
+    for (size_t n : {0, 1, 63, 64, 65, 1000, 100003})
+    {
+        BinaryPQ<pair<int, int>, PriorityOnly> unstable;
+        BinaryPQ<pair<int, int>, PriorityOnly, true> stable;
+        for (size_t i = 0; i < n; ++i)
+        {
+            pair<int, int> val{ static_cast<int>(i * 7919 % 1009), static_cast<int>(i) };
+            unstable.push(val);
+            stable.push(val);
+        } // for
+        vector<size_t> ks = { 0, 1, 63, 64, 65, n / 2, n, n + 5 };
+        testPopBatchHelper(stable, ks);
+
+        // without stable mode, ties may come out in any order, so only
+        // priorities are compared
+        for (size_t k : ks)
+        {
+            BinaryPQ<pair<int, int>, PriorityOnly> serial(unstable), parallel(unstable);
+            vector<pair<int, int>> one = serial.pop_batch(k, 1), four = parallel.pop_batch(k, 4);
+            assert(one.size() == min(k, n) && one == four);
+            assert(is_sorted(one.rbegin(), one.rend(), PriorityOnly()));
+            assert(serial.size() == n - one.size());
+            assert(one.empty() || serial.empty() || !PriorityOnly()(one.back(), serial.top()));
+            assert(ranges::equal(serial.heap_order(), parallel.heap_order()));
+        } // for
+    } // for
+
+    // Test 2: PairingPQ; pushing in falling order leaves the root with
+    // every other node as a child, which is long enough to split
+    cout << "Test 2: PairingPQ..." << endl;
+    PairingPQ<pair<int, int>, PriorityOnly, true> pairing;
+    for (int i = 40000; i > 0; --i)
+        pairing.push({ i / 3, i });
+    for (int i = 0; i < 1000; ++i)
+        pairing.push({ i * 7919 % 1009, i });
+    testPopBatchHelper(pairing, { 0, 1, 100, 41000, 50000 });
+    PairingPQ<pair<int, int>, PriorityOnly, true> emptyPairing;
+    [[maybe_unused]] vector<pair<int, int>> none = emptyPairing.pop_batch(10);
+    assert(none.empty());
+
+    // Test 3: the one-by-one pop_batch() through the base class
+    cout << "Test 3: Eecs281PQ..." << endl;
+    SortedPQ<int> sorted;
+    for (int i : { 5, 1, 4, 2, 3 })
+        sorted.push(i);
+    Eecs281PQ<int> &base = sorted;
+    [[maybe_unused]] vector<int> first = base.pop_batch(3);
+    assert((first == vector<int>{ 5, 4, 3 }));
+    [[maybe_unused]] vector<int> rest = base.pop_batch(3);
+    assert((rest == vector<int>{ 2, 1 }) && base.empty());
+
+    cout << "\n\n********** END: Testing pop_batch() **********\n" << endl;
+} // testPopBatch()
+
+
+
+// Test the loser tree and the k-way merge driver built on top of it.
+void testLoserTree()
+{
+    cout << "\n\n********** START: Testing LoserTree **********\n" << endl;
+
+    // Test 1: top() and replace_top() on a tree built from a range
+    cout << "Test 1: range ctor and replace_top..." << endl;
+    vector<int> heads = {7, 3, 9, 1, 5};
+    LoserTree<int> tree(heads.begin(), heads.end());
+    assert(tree.size() == 5);
+    assert(tree.top() == 9 && tree.topIndex() == 2);
+    tree.replace_top(4);
+    assert(tree.top() == 7 && tree.topIndex() == 0);
+    tree.exhaustTop();
+    assert(tree.top() == 5 && tree.size() == 4);
+    cout << "Test 1 passed!" << endl;
+
+    // Test 2: single leaf and empty streams
+    cout << "Test 2: single leaf..." << endl;
+    LoserTree<int> one(1);
+    assert(one.empty());
+    one.setLeaf(0, 42);
+    one.build();
+    assert(!one.empty() && one.top() == 42);
+    one.exhaustTop();
+    assert(one.empty());
+    cout << "Test 2 passed!" << endl;
+
+    // Test 3: merge ascending streams (min-first) of uneven lengths
+    cout << "Test 3: kway_merge of ascending streams..." << endl;
+    vector<vector<int>> streams = {
+        {1, 4, 9, 12}, {}, {2, 3, 10}, {5}, {0, 6, 7, 8, 11, 13}, {}
+    };
+    vector<pair<vector<int>::const_iterator, vector<int>::const_iterator>> ranges;
+    vector<int> expected;
+    for (const auto &s : streams)
+    {
+        ranges.emplace_back(s.cbegin(), s.cend());
+        expected.insert(expected.end(), s.begin(), s.end());
+    }
+    sort(expected.begin(), expected.end());
+
+    vector<int> merged;
+    kway_merge(ranges, back_inserter(merged), std::greater<int>());
+    assert(merged == expected);
+    cout << "Test 3 passed!" << endl;
+
+    // Test 4: merge descending streams with the default functor,
+    // cross-checked against popping a BinaryPQ of every element.
+    cout << "Test 4: kway_merge of descending streams vs. BinaryPQ..." << endl;
+    vector<vector<int>> desc(37);
+    BinaryPQ<int> reference;
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        int val = static_cast<int>((i * 7919) % 1009);
+        desc[i % desc.size()].push_back(val);
+        reference.push(val);
+    }
+    ranges.clear();
+    for (auto &s : desc)
+    {
+        sort(s.begin(), s.end(), std::greater<int>());
+        ranges.emplace_back(s.cbegin(), s.cend());
+    }
+    merged.clear();
+    kway_merge(ranges, back_inserter(merged));
+    assert(merged.size() == reference.size());
+    for ([[maybe_unused]] int val : merged)
+    {
+        assert(val == reference.top());
+        reference.pop();
+    }
+    cout << "Test 4 passed!" << endl;
+
+    cout << "\n\n********** END: Testing LoserTree **********\n" << endl;
+} // testLoserTree()
+
+
+
+// Test the ID-addressed heap against a brute-force map from ID to value,
+// for a binary and a 4-ary layout.
+template <size_t ARITY>
+void testIndexedBinaryPQHelper()
+{
+    cout << "Testing IndexedBinaryPQ with arity " << ARITY << "..." << endl;
+
+    // Test 1: range ctor assigns IDs in order; update in both directions
+    vector<int> prices = {40, 10, 30, 20, 50};
+    IndexedBinaryPQ<int, std::less<int>, ARITY> book(prices.begin(), prices.end());
+    assert(book.top() == 50 && book.topId() == 4);
+    book.update(1, 60);
+    assert(book.top() == 60 && book.topId() == 1);
+    book.update(1, 0);
+    assert(book.top() == 50 && book.get(1) == 0);
+    [[maybe_unused]] bool erased = book.erase(4);
+    [[maybe_unused]] bool erasedAgain = book.erase(4);
+    assert(erased && !book.contains(4) && !erasedAgain);
+    assert(book.top() == 40 && book.topId() == 0 && book.size() == 4);
+    book.push(4, 45);
+    assert(book.top() == 45 && book.contains(4));
+    book.push(4, 5);
+    assert(book.size() == 5 && book.top() == 40);
+
+    // Test 2: random pushes, updates and erases against a reference
+    vector<int> ref(300, -1); // -1 = not in the heap
+    IndexedBinaryPQ<int, std::less<int>, ARITY> pq;
+    size_t seed = 12345;
+    auto next = [&seed]() { seed = seed * 6364136223846793005ULL + 1442695040888963407ULL; return seed >> 33; };
+    for (int step = 0; step < 20000; ++step)
+    {
+        size_t id = next() % ref.size();
+        int val = static_cast<int>(next() % 1000);
+        switch (next() % 4)
+        {
+            case 0:
+            case 1:
+                pq.push(id, val);
+                ref[id] = val;
+                break;
+            case 2:
+            {
+                [[maybe_unused]] bool erased = pq.erase(id);
+                assert(erased == (ref[id] != -1));
+                ref[id] = -1;
+                break;
+            }
+            default:
+                if (!pq.empty())
+                {
+                    assert(ref[pq.topId()] == pq.top());
+                    ref[pq.topId()] = -1;
+                    pq.pop();
+                }
+        } // switch
+
+        [[maybe_unused]] int best = *max_element(ref.begin(), ref.end());
+        size_t live = static_cast<size_t>(count_if(ref.begin(), ref.end(), [](int v) { return v != -1; }));
+        assert(pq.size() == live);
+        if (live != 0)
+            assert(pq.top() == best && ref[pq.topId()] == best);
+        assert(pq.contains(id) == (ref[id] != -1));
+    } // for
+} // testIndexedBinaryPQHelper()
+
+
+void testIndexedBinaryPQ()
+{
+    cout << "\n\n********** START: Testing IndexedBinaryPQ **********\n" << endl;
+    testIndexedBinaryPQHelper<2>();
+    testIndexedBinaryPQHelper<4>();
+    cout << "\n\n********** END: Testing IndexedBinaryPQ **********\n" << endl;
+} // testIndexedBinaryPQ()
+
+
+// Random pushes and pops on a PQ with inline storage, growing past the
+// inline capacity and shrinking back, checked against a std::multiset; then
+// copies and assignments, which must not share inline storage.
+template <typename PQ>
+void testInlineStorageHelper(const string &pqType)
+{
+    cout << "Testing inline " << pqType << "..." << endl;
+
+    PQ pq;
+    multiset<int> ref;
+    uint32_t state = 88172645u;
+    for (int i = 0; i < 20000; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        // drift between empty and about three times the inline capacity
+        size_t cap = (i / 1000) % 2 ? 48 : 8;
+        if (ref.size() < cap && (ref.empty() || state % 3))
+        {
+            int val = static_cast<int>(state % 100);
+            pq.push(val);
+            ref.insert(val);
+        } // if
+        else
+        {
+            assert(pq.top() == *ref.rbegin());
+            pq.pop();
+            ref.erase(prev(ref.end()));
+        } // else
+        assert(pq.size() == ref.size());
+    } // for
+
+    while (!pq.empty())
+        pq.pop();
+    for (int val : {5, 1, 9, 7})
+        pq.push(val);
+    PQ copy(pq);
+    PQ assigned(pq);
+    if constexpr (std::is_copy_assignable_v<PQ>)
+    {
+        assigned.push(100);
+        assigned = copy;
+    } // if
+    pq.pop();
+    assert(pq.top() == 7);
+    for (PQ *other : {&copy, &assigned})
+        for ([[maybe_unused]] int expect : {9, 7, 5, 1})
+        {
+            assert(other->top() == expect);
+            other->pop();
+        } // for
+    assert(copy.empty() && assigned.empty() && pq.size() == 3);
+} // testInlineStorageHelper()
+
+
+// Test SmallVector on its own, with a type that owns memory so that a
+// missed destructor or a double one shows up, then every PQ with an
+// INLINE parameter.
+void testInlineStorage()
+{
+    cout << "\n\n********** START: Testing inline storage **********\n" << endl;
+
+    cout << "Testing SmallVector..." << endl;
+    SmallVector<string, 4> small;
+    for (int i = 0; i < 4; ++i)
+        small.push_back(string(40, static_cast<char>('a' + i)));
+    assert(small.is_inline() && small.size() == 4);
+
+    // moving an inline vector moves the elements; a spilled one its block
+    SmallVector<string, 4> moved{ std::move(small) };
+    assert(moved.is_inline() && moved.back() == string(40, 'd') && small.empty());
+    moved.push_back(string(40, 'e'));
+    assert(!moved.is_inline() && moved.front() == string(40, 'a'));
+    [[maybe_unused]] const string *block = moved.data();
+    SmallVector<string, 4> stolen{ std::move(moved) };
+    assert(stolen.data() == block && stolen.size() == 5);
+
+    // insert and erase keep the order, spilled or not
+    stolen.insert(stolen.begin() + 1, "x");
+    stolen.erase(stolen.begin());
+    assert(stolen.front() == "x" && stolen.size() == 5);
+    vector<string> more{ "p", "q" };
+    stolen.insert(stolen.begin(), more.begin(), more.end());
+    assert(stolen[0] == "p" && stolen[1] == "q" && stolen[2] == "x");
+
+    // swap between a spilled and an inline vector, both ways
+    SmallVector<string, 4> two;
+    two.push_back("only");
+    two.swap(stolen);
+    assert(two.size() == 7 && stolen.size() == 1 && stolen.is_inline());
+    stolen.swap(two);
+    assert(two.size() == 1 && two.front() == "only" && stolen.size() == 7);
+    SmallVector<string, 4> copied = stolen;
+    copied = two;
+    assert(copied.size() == 1 && copied.front() == "only");
+
+    testInlineStorageHelper<BinaryPQ<int, std::less<int>, false, 16>>("BinaryPQ");
+    testInlineStorageHelper<UnorderedFastPQ<int, std::less<int>, false, 16>>("UnorderedFastPQ");
+    testInlineStorageHelper<SortedPQ<int, std::less<int>, false, 16>>("SortedPQ");
+    testInlineStorageHelper<PairingPQ<int, std::less<int>, false, 16>>("PairingPQ");
+
+    // updateElt() on an inline node, and the range ctors
+    PairingPQ<int, std::less<int>, false, 4> pairing;
+    auto *node = pairing.addNode(1);
+    pairing.push(5);
+    pairing.updateElt(node, 10);
+    assert(pairing.top() == 10);
+    vector<int> vals{ 3, 1, 4, 1, 5, 9, 2, 6 };
+    SortedPQ<int, std::less<int>, false, 4> sorted(vals.begin(), vals.end());
+    BinaryPQ<int, std::less<int>, false, 32> binary(vals.begin(), vals.end());
+    for ([[maybe_unused]] int expect : {9, 6, 5, 4})
+    {
+        assert(sorted.top() == expect && binary.top() == expect);
+        sorted.pop();
+        binary.pop();
+    } // for
+
+    cout << "\n\n********** END: Testing inline storage **********\n" << endl;
+} // testInlineStorage()
+
+
+// Drive an AdaptivePQ through workload phases, checking every top() against
+// a std::multiset and the representation at the end of each phase.
+void testAdaptivePQ()
+{
+    cout << "\n\n********** START: Testing AdaptivePQ **********\n" << endl;
+    using Rep [[maybe_unused]] = AdaptivePQ<int>::Representation;
+
+    AdaptivePQ<int> pq;
+    multiset<int> ref;
+    int next = 0;
+    auto push = [&]() {
+        int val = (next++ * 7919) % 10007;
+        pq.push(val);
+        ref.insert(val);
+    };
+    auto pop = [&]() {
+        assert(pq.top() == *ref.rbegin());
+        pq.pop();
+        ref.erase(prev(ref.end()));
+    };
+
+    // Test 1: a few elements stay unordered
+    cout << "Test 1: small queue..." << endl;
+    for (int i = 0; i < 500; ++i)
+    {
+        push();
+        if (ref.size() > 20)
+            pop();
+    } // for
+    assert(pq.representation() == Rep::UNORDERED && pq.migrations() == 0);
+
+    // Test 2: growing under a push/pop mix moves to the binary heap
+    cout << "Test 2: growing queue..." << endl;
+    for (int i = 0; i < 6000; ++i)
+    {
+        push();
+        push();
+        pop();
+    } // for
+    assert(pq.representation() == Rep::BINARY && pq.migrations() == 1);
+
+    // Test 3: a long run of pops moves to the sorted array
+    cout << "Test 3: draining phase..." << endl;
+    while (ref.size() > 1000)
+        pop();
+    assert(pq.representation() == Rep::SORTED && pq.migrations() == 2);
+
+    // Test 4: no two windows in a row with a push, so no flapping
+    cout << "Test 4: hysteresis..." << endl;
+    for (int i = 1; i <= 900; ++i)
+    {
+        if (i % 150 == 0)
+            push();
+        pop();
+    } // for
+    assert(pq.representation() == Rep::SORTED && pq.migrations() == 2);
+
+    // Test 5: shrinking back down returns to the unordered array
+    cout << "Test 5: shrinking queue..." << endl;
+    while (ref.size() > 10)
+        pop();
+    for (int i = 0; i < 500; ++i)
+    {
+        push();
+        pop();
+    } // for
+    assert(pq.representation() == Rep::UNORDERED && pq.migrations() == 3);
+    assert(pq.size() == ref.size());
+    while (!ref.empty())
+        pop();
+    assert(pq.empty());
+
+    // Test 6: updatePriorities() is forwarded and the range ctor picks by size
+    cout << "Test 6: updatePriorities() and range ctor..." << endl;
+    vector<int> vals(1000);
+    for (size_t i = 0; i < vals.size(); ++i)
+        vals[i] = static_cast<int>((i * 31) % 1000);
+    AdaptivePQ<int> ranged(vals.begin(), vals.end());
+    assert(ranged.representation() == Rep::BINARY && ranged.top() == 999);
+    ranged.updatePriorities();
+    assert(ranged.counters().updates == 1 && ranged.counters().pops == 0);
+    for (int expect = 999; expect >= 0; --expect)
+    {
+        assert(ranged.top() == expect);
+        ranged.pop();
+    } // for
+
+    cout << "\n\n********** END: Testing AdaptivePQ **********\n" << endl;
+} // testAdaptivePQ()
+
+
+
+// Every call to the global operator new in this program, so that a test
+// can check that a block of code does not allocate. Atomic, since some
+// tests allocate on several threads. Every form of new and delete is
+// replaced, plain, array, nothrow and aligned, so that whatever the library
+// allocates with is freed by the matching replacement.
+static atomic<size_t> allocationCount{ 0 };
+
+// Description: The allocation behind every replaced operator new; nullptr
+//              if there is no memory.
+static void *countedAlloc(size_t size, size_t align = alignof(max_align_t)) noexcept
+{
+    ++allocationCount;
+    size = size ? size : 1;
+    if (align <= alignof(max_align_t))
+        return malloc(size);
+    // aligned_alloc() wants a size that is a multiple of the alignment
+    return aligned_alloc(align, (size + align - 1) / align * align);
+} // countedAlloc()
+
+void *operator new(size_t size)
+{
+    if (void *block = countedAlloc(size))
+        return block;
+    throw std::bad_alloc{};
+} // operator new()
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+} // operator new[]()
+
+void *operator new(size_t size, align_val_t align)
+{
+    if (void *block = countedAlloc(size, static_cast<size_t>(align)))
+        return block;
+    throw std::bad_alloc{};
+} // operator new()
+
+void *operator new[](size_t size, align_val_t align)
+{
+    return operator new(size, align);
+} // operator new[]()
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+} // operator new()
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+} // operator new[]()
+
+void *operator new(size_t size, align_val_t align, const nothrow_t &) noexcept
+{
+    return countedAlloc(size, static_cast<size_t>(align));
+} // operator new()
+
+void *operator new[](size_t size, align_val_t align, const nothrow_t &) noexcept
+{
+    return countedAlloc(size, static_cast<size_t>(align));
+} // operator new[]()
+
+// Description: The release behind every replaced operator delete. Every
+//              replaced new hands out malloc() or aligned_alloc() memory,
+//              which free() releases. Kept out of line, since GCC flags a
+//              free() inlined into code that got its block from new.
+[[gnu::noinline]] static void countedFree(void *block) noexcept
+{
+    free(block);
+} // countedFree()
+
+void operator delete(void *block) noexcept { countedFree(block); }
+void operator delete[](void *block) noexcept { countedFree(block); }
+void operator delete(void *block, size_t) noexcept { countedFree(block); }
+void operator delete[](void *block, size_t) noexcept { countedFree(block); }
+void operator delete(void *block, align_val_t) noexcept { countedFree(block); }
+void operator delete[](void *block, align_val_t) noexcept { countedFree(block); }
+void operator delete(void *block, size_t, align_val_t) noexcept { countedFree(block); }
+void operator delete[](void *block, size_t, align_val_t) noexcept { countedFree(block); }
+void operator delete(void *block, const nothrow_t &) noexcept { countedFree(block); }
+void operator delete[](void *block, const nothrow_t &) noexcept { countedFree(block); }
+void operator delete(void *block, align_val_t, const nothrow_t &) noexcept { countedFree(block); }
+void operator delete[](void *block, align_val_t, const nothrow_t &) noexcept { countedFree(block); }
+
+
+// Keep-best-N: stream values through PQ and check that it holds exactly the
+// n most extreme of them, without a single allocation after construction.
+template <typename PQ, typename COMP>
+void testKeepBestHelper(PQ &pq, size_t n, COMP comp)
+{
+    vector<int> stream;
+    uint32_t state = 2463534242u;
+    for (int i = 0; i < 5000; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        stream.push_back(static_cast<int>(state % 100000));
+    } // for
+
+    vector<int> kept;
+    kept.reserve(n);
+    [[maybe_unused]] size_t before = allocationCount;
+    for (int val : stream)
+    {
+        [[maybe_unused]] bool full = pq.full();
+        [[maybe_unused]] bool pushed = pq.try_push(val);
+        assert(pushed || full);
+    } // for
+    while (!pq.empty())
+    {
+        kept.push_back(pq.top());
+        pq.pop();
+    } // while
+    assert(allocationCount == before);
+
+    // the n most extreme, most extreme first
+    sort(stream.begin(), stream.end(), [&comp](int a, int b) { return comp(b, a); });
+    stream.resize(n);
+    assert(kept == stream);
+} // testKeepBestHelper()
+
+
+// Random pushes, pops, updateElt() and erase() on a BoundedPairingPQ,
+// checked against a std::multiset.
+void testBoundedPairingOps()
+{
+    BoundedPairingPQ<int, std::less<int>, 64> pq;
+    using Node = BoundedPairingPQ<int, std::less<int>, 64>::Node;
+    multiset<int> ref;
+    vector<Node *> handles;
+    uint32_t state = 88172645u;
+
+    // the low 15 bits of every value are unique, so a value names its node
+    for (int i = 0; i < 20000; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        int val = static_cast<int>(state % 1000) * 32768 + i;
+
+        switch (state % 5)
+        {
+        case 0:
+        case 1:
+            if (Node *node = pq.try_addNode(val))
+            {
+                ref.insert(val);
+                handles.push_back(node);
+            } // if
+            else
+                assert(pq.full() && ref.size() == 64);
+            break;
+        case 2:
+            if (!ref.empty())
+            {
+                assert(pq.top() == *ref.rbegin());
+                auto top = find_if(handles.begin(), handles.end(),
+                                   [&pq](Node *node) { return **node == pq.top(); });
+                pq.pop();
+                ref.erase(prev(ref.end()));
+                handles.erase(top);
+            } // if
+            break;
+        case 3:
+            if (!handles.empty())
+            {
+                // raise a random element
+                Node *node = handles[state % handles.size()];
+                ref.erase(ref.find(**node));
+                int raised = **node + static_cast<int>(state % 50) * 32768;
+                pq.updateElt(node, raised);
+                ref.insert(raised);
+            } // if
+            break;
+        default:
+            if (!handles.empty())
+            {
+                size_t at = state % handles.size();
+                ref.erase(ref.find(**handles[at]));
+                pq.erase(handles[at]);
+                handles.erase(handles.begin() + static_cast<ptrdiff_t>(at));
+            } // if
+        } // switch
+
+        assert(pq.size() == ref.size());
+        if (!ref.empty())
+            assert(pq.top() == *ref.rbegin());
+    } // for
+} // testBoundedPairingOps()
+
+
+// Run 'threads' threads that each push 'perThread' distinct values and pop
+// after every other push, then drain the queue alone. Every value must come
+// out exactly once and, unless the queue is relaxed, the drain in order.
+template <typename PQ>
+void testSharedQueueHelper(PQ &pq, size_t threads, int perThread, [[maybe_unused]] bool relaxed = false)
+{
+    vector<vector<int>> popped(threads);
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&pq, &popped, t, threads, perThread]() {
+            int val;
+            for (int i = 0; i < perThread; ++i)
+            {
+                pq.push(static_cast<int>(static_cast<size_t>(i) * threads + t) * 7919 % 100003);
+                if (i % 2 == 1 && pq.try_pop(val))
+                    popped[t].push_back(val);
+            } // for
+        });
+    } // for
+    for (thread &worker : workers)
+        worker.join();
+
+    vector<int> all;
+    for (const vector<int> &some : popped)
+        all.insert(all.end(), some.begin(), some.end());
+    vector<int> drained;
+    int val;
+    while (pq.try_pop(val))
+        drained.push_back(val);
+    [[maybe_unused]] bool poppedMore = pq.try_pop(val);
+    assert(pq.empty() && !poppedMore);
+    assert(relaxed || is_sorted(drained.rbegin(), drained.rend()));
+
+    all.insert(all.end(), drained.begin(), drained.end());
+    sort(all.begin(), all.end());
+    vector<int> expected;
+    for (size_t n = 0; n < threads * static_cast<size_t>(perThread); ++n)
+        expected.push_back(static_cast<int>(n) * 7919 % 100003);
+    sort(expected.begin(), expected.end());
+    assert(all == expected);
+} // testSharedQueueHelper()
+
+
+// Test ConcurrentBinaryPQ and LockedPQ: heap order on one thread, and no
+// lost or repeated elements under concurrent pushes and pops.
+void testConcurrentPQs()
+{
+    cout << "\n\n********** START: Testing concurrent PQs **********\n" << endl;
+
+    // Test 1: one thread, against sorting, both directions
+    cout << "Test 1: one thread..." << endl;
+    vector<int> vals;
+    for (int i = 0; i < 5000; ++i)
+        vals.push_back((i * 7919) % 997);
+    ConcurrentBinaryPQ<int> maxHeap(vals.begin(), vals.end());
+    ConcurrentBinaryPQ<int, std::greater<int>> minHeap;
+    for (int val : vals)
+        minHeap.push(val);
+    assert(maxHeap.size() == vals.size() && minHeap.size() == vals.size());
+    vector<int> sorted = vals;
+    sort(sorted.begin(), sorted.end());
+    [[maybe_unused]] int top;
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        [[maybe_unused]] bool poppedMax = maxHeap.try_pop(top);
+        assert(poppedMax && top == sorted[sorted.size() - 1 - i]);
+        [[maybe_unused]] bool poppedMin = minHeap.try_pop(top);
+        assert(poppedMin && top == sorted[i]);
+    } // for
+    [[maybe_unused]] bool poppedMore = maxHeap.try_pop(top);
+    assert(maxHeap.empty() && !poppedMore);
+
+    // Test 2: pushes and pops from several threads at once
+    cout << "Test 2: concurrent pushes and pops..." << endl;
+    ConcurrentBinaryPQ<int> shared;
+    testSharedQueueHelper(shared, 8, 4000);
+    testSharedQueueHelper(shared, 3, 10000);
+    LockedPQ<int> locked;
+    testSharedQueueHelper(locked, 8, 4000);
+
+    // Test 3: LockedPQ over another queue, and its try_lock variants
+    cout << "Test 3: LockedPQ..." << endl;
+    LockedPQ<int, PairingPQ<int, std::greater<int>>> lockedPairing;
+    [[maybe_unused]] bool pushed3 = lockedPairing.try_lock_push(3);
+    [[maybe_unused]] bool pushed1 = lockedPairing.try_lock_push(1);
+    assert(pushed3 && pushed1);
+    lockedPairing.push(2);
+    assert(lockedPairing.size() == 3);
+    [[maybe_unused]] bool popped = lockedPairing.try_lock_pop(top);
+    assert(popped && top == 1);
+    popped = lockedPairing.try_pop(top);
+    assert(popped && top == 2);
+
+    cout << "\n\n********** END: Testing concurrent PQs **********\n" << endl;
+} // testConcurrentPQs()
+
+
+
+// Test MultiQueue: exact with one shard, near the top with many, and no
+// lost or repeated elements under concurrent pushes and pops.
+void testMultiQueue()
+{
+    cout << "\n\n********** START: Testing MultiQueue **********\n" << endl;
+
+    vector<int> vals;
+    for (int i = 0; i < 10000; ++i)
+        vals.push_back((i * 7919) % 10007);
+    vector<int> sorted = vals;
+    sort(sorted.begin(), sorted.end());
+
+    // Test 1: a single shard is an exact priority queue
+    cout << "Test 1: one shard..." << endl;
+    MultiQueue<int, std::less<int>, BinaryPQ<int>, true> single(1, 1);
+    for (int val : vals)
+        single.push(val);
+    assert(single.shard_count() == 1 && single.size() == vals.size());
+    int top;
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        [[maybe_unused]] bool popped = single.try_pop(top);
+        assert(popped && top == sorted[sorted.size() - 1 - i]);
+    } // for
+    [[maybe_unused]] bool poppedMore = single.try_pop(top);
+    assert(single.empty() && !poppedMore);
+    assert(single.rank_stats().pops == vals.size() && single.rank_stats().worst == 0);
+
+    // Test 2: many shards lose no element and pop near the top
+    cout << "Test 2: rank error over 16 shards..." << endl;
+    MultiQueue<int, std::greater<int>, BinaryPQ<int, std::greater<int>>, true> relaxed(8, 2);
+    for (int val : vals)
+        relaxed.push(val);
+    vector<int> popped;
+    while (relaxed.try_pop(top))
+        popped.push_back(top);
+    sort(popped.begin(), popped.end());
+    assert(popped == sorted);
+    [[maybe_unused]] MultiQueue<int, std::greater<int>, BinaryPQ<int, std::greater<int>>, true>::RankStats stats
+        = relaxed.rank_stats();
+    assert(stats.pops == vals.size() && stats.worst > 0);
+    assert(stats.mean() < static_cast<double>(relaxed.shard_count()));
+
+    // Test 3: pushes and pops from several threads, and other shard types
+    cout << "Test 3: concurrent pushes and pops..." << endl;
+    MultiQueue<int> shared(4, 2);
+    testSharedQueueHelper(shared, 4, 5000, true);
+    MultiQueue<int, std::less<int>, PairingPQ<int>> pairingShards(8, 1);
+    testSharedQueueHelper(pairingShards, 8, 2000, true);
+
+    cout << "\n\n********** END: Testing MultiQueue **********\n" << endl;
+} // testMultiQueue()
+
+
+// Run order of one gated TaskScheduler worker: every task submitted while
+// the gate task runs waits in the injection queue, so once the gate opens
+// the rest run strictly by priority.
+template <typename SUBMIT>
+vector<int> gatedRunOrder(const SUBMIT &submit)
+{
+    TaskScheduler<int> scheduler(1);
+    std::atomic<bool> open{ false };
+    scheduler.submit(INT_MAX, [&open]() { while (!open.load()) std::this_thread::yield(); });
+    vector<int> order;
+    submit(scheduler, order);
+    open.store(true);
+    scheduler.wait();
+    return order;
+} // gatedRunOrder()
+
+
+// Test TaskScheduler: priority order, dependencies, priority inheritance,
+// and every task running exactly once on many workers.
+void testTaskScheduler()
+{
+    cout << "\n\n********** START: Testing TaskScheduler **********\n" << endl;
+    using Scheduler = TaskScheduler<int>;
+
+    // Test 1: one worker runs ready tasks by priority
+    cout << "Test 1: priority order..." << endl;
+    vector<int> order = gatedRunOrder([](Scheduler &scheduler, vector<int> &ran)
+    {
+        for (int i = 0; i < 50; ++i)
+        {
+            const int priority = (i * 37) % 50;
+            scheduler.submit(priority, [&ran, priority]() { ran.push_back(priority); });
+        } // for
+    });
+    assert(order.size() == 50);
+    for (size_t i = 0; i < order.size(); ++i)
+        assert(order[i] == static_cast<int>(order.size() - 1 - i));
+
+    // Test 2: a task runs after its dependencies, whatever their priority
+    cout << "Test 2: dependencies..." << endl;
+    order = gatedRunOrder([](Scheduler &scheduler, vector<int> &ran)
+    {
+        Scheduler::Handle a = scheduler.submit(1, [&ran]() { ran.push_back(1); });
+        Scheduler::Handle b = scheduler.submit(2, [&ran]() { ran.push_back(2); });
+        Scheduler::Handle c = scheduler.submit(3, [&ran]() { ran.push_back(3); }, { a, b });
+        scheduler.submit(4, [&ran]() { ran.push_back(4); }, { c });
+        scheduler.submit(0, [&ran]() { ran.push_back(0); });
+    });
+    // a and b both inherit 4 from the task after c, so either may go first
+    assert(order.size() == 5 && min(order[0], order[1]) == 1 && max(order[0], order[1]) == 2);
+    assert(order[2] == 3 && order[3] == 4 && order[4] == 0);
+
+    // Test 3: a low task that an urgent one waits on runs before the middle
+    // ones, whether it is queued already or waiting itself
+    cout << "Test 3: priority inheritance..." << endl;
+    order = gatedRunOrder([](Scheduler &scheduler, vector<int> &ran)
+    {
+        Scheduler::Handle low = scheduler.submit(1, [&ran]() { ran.push_back(1); });
+        for (int i = 0; i < 3; ++i)
+            scheduler.submit(5, [&ran]() { ran.push_back(5); });
+        scheduler.submit(10, [&ran]() { ran.push_back(10); }, { low });
+    });
+    assert((order == vector<int>{ 1, 10, 5, 5, 5 }));
+    order = gatedRunOrder([](Scheduler &scheduler, vector<int> &ran)
+    {
+        Scheduler::Handle lowest = scheduler.submit(0, [&ran]() { ran.push_back(0); });
+        Scheduler::Handle low = scheduler.submit(1, [&ran]() { ran.push_back(1); }, { lowest });
+        for (int i = 0; i < 3; ++i)
+            scheduler.submit(5, [&ran]() { ran.push_back(5); });
+        scheduler.submit(10, [&ran]() { ran.push_back(10); }, { low });
+    });
+    assert((order == vector<int>{ 0, 1, 10, 5, 5, 5 }));
+
+    // Test 4: on many workers, with random dependencies and tasks that
+    // submit more tasks, each runs once and after its dependencies
+    cout << "Test 4: many workers..." << endl;
+    const size_t tasks = 2000;
+    vector<std::atomic<int>> runs(tasks * 2);
+    {
+        Scheduler scheduler(4);
+        vector<Scheduler::Handle> handles;
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < tasks; ++i)
+        {
+            vector<size_t> deps;
+            vector<Scheduler::Handle> depHandles;
+            for (int d = 0; i > 0 && d < 3; ++d)
+            {
+                seed = seed * 1664525 + 1013904223;
+                if (seed % 3 == 0)
+                    continue;
+                deps.push_back(seed % i);
+                depHandles.push_back(handles[deps.back()]);
+            } // for
+            const int priority = static_cast<int>(seed % 100);
+            handles.push_back(scheduler.submit(priority, [&runs, &scheduler, deps, i, tasks]()
+            {
+                for ([[maybe_unused]] size_t dep : deps)
+                    assert(runs[dep].load() == 1);
+                runs[i].fetch_add(1);
+                if (i % 2 == 0)
+                    scheduler.submit(static_cast<int>(i % 7), [&runs, i, tasks]() { runs[tasks + i].fetch_add(1); });
+            }, depHandles));
+        } // for
+        scheduler.wait();
+        [[maybe_unused]] Scheduler::Stats stats = scheduler.stats();
+        assert(stats.executed == tasks + tasks / 2);
+    } // scope
+    for (size_t i = 0; i < runs.size(); ++i)
+        assert(runs[i].load() == (i < tasks || i % 2 == 0 ? 1 : 0));
+
+    cout << "\n\n********** END: Testing TaskScheduler **********\n" << endl;
+} // testTaskScheduler()
+
+
+// Feed a StagedPQ from 'producers' threads while its owner pops, and check
+// that every value comes out exactly once.
+template <typename STAGED>
+void testStagedPQHelper(STAGED &staged, size_t producers, int perProducer)
+{
+    vector<thread> threads;
+    for (size_t t = 0; t < producers; ++t)
+    {
+        threads.emplace_back([&staged, t, perProducer]() {
+            for (int i = 0; i < perProducer; ++i)
+                staged.push(static_cast<int>(t) * perProducer + i);
+        });
+    } // for
+
+    const size_t total = producers * static_cast<size_t>(perProducer);
+    vector<int> popped;
+    int out;
+    while (popped.size() < total)
+    {
+        if (staged.try_pop(out))
+            popped.push_back(out);
+        else
+            this_thread::yield();
+    } // while
+    for (thread &producer : threads)
+        producer.join();
+
+    [[maybe_unused]] bool poppedMore = staged.try_pop(out);
+    assert(!poppedMore && staged.pending() == 0);
+    sort(popped.begin(), popped.end());
+    for (size_t i = 0; i < total; ++i)
+        assert(popped[i] == static_cast<int>(i));
+    assert(staged.stats().pushed == total && staged.stats().drained == total);
+} // testStagedPQHelper()
+
+
+// Test BinaryPQ::push_range(), StagingRing, and StagedPQ: FIFO hand-off,
+// back-pressure, and no lost or repeated elements between threads.
+void testStagedPQ()
+{
+    cout << "\n\n********** START: Testing StagedPQ **********\n" << endl;
+
+    // Test 1: batches of any size keep the heap valid
+    cout << "Test 1: BinaryPQ::push_range()..." << endl;
+    for (size_t before : {0, 1, 2, 5, 100})
+    {
+        for (size_t batch : {0, 1, 2, 3, 64, 1000})
+        {
+            vector<int> vals;
+            for (size_t i = 0; i < before + batch; ++i)
+                vals.push_back(static_cast<int>((i * 7919) % 1009));
+            BinaryPQ<int> pq;
+            for (size_t i = 0; i < before; ++i)
+                pq.push(vals[i]);
+            pq.push_range(vals.begin() + static_cast<ptrdiff_t>(before), vals.end());
+            assert(pq.size() == vals.size());
+            sort(vals.begin(), vals.end());
+            for (size_t i = vals.size(); i-- > 0;)
+            {
+                assert(pq.top() == vals[i]);
+                pq.pop();
+            } // for
+        } // for
+    } // for
+
+    // Test 2: the ring rounds its capacity up, refuses to overfill, and
+    // keeps FIFO order over many laps
+    cout << "Test 2: StagingRing..." << endl;
+    StagingRing<int, false> ring(5);
+    assert(ring.capacity() == 8 && ring.size() == 0);
+    for (int i = 0; i < 8; ++i)
+    {
+        [[maybe_unused]] bool pushed = ring.try_push(i);
+        assert(pushed);
+    } // for
+    [[maybe_unused]] bool pushed = ring.try_push(8);
+    assert(!pushed && ring.size() == 8);
+    vector<int> out;
+    [[maybe_unused]] size_t moved = ring.pop_bulk(back_inserter(out), 3);
+    assert(moved == 3 && (out == vector<int>{ 0, 1, 2 }));
+    int next = 8;
+    for (int lap = 0; lap < 100; ++lap)
+    {
+        while (ring.try_push(next))
+            ++next;
+        ring.pop_bulk(back_inserter(out), static_cast<size_t>(lap % 7 + 1));
+    } // for
+    ring.pop_bulk(back_inserter(out), 100);
+    assert(ring.size() == 0 && out.size() == static_cast<size_t>(next));
+    for (size_t i = 0; i < out.size(); ++i)
+        assert(out[i] == static_cast<int>(i));
+
+    // Test 3: a full ring rejects try_push() until the owner drains it
+    cout << "Test 3: back-pressure..." << endl;
+    StagedPQ<int, BinaryPQ<int>, true, true> small(4, 2);
+    for (int i = 0; i < 4; ++i)
+    {
+        [[maybe_unused]] bool accepted = small.try_push(i);
+        assert(accepted);
+    } // for
+    [[maybe_unused]] bool accepted = small.try_push(4);
+    assert(!accepted && small.pending() == 4 && small.queue().empty());
+    [[maybe_unused]] size_t drained = small.drain();
+    assert(drained == 4 && small.queue().size() == 4);
+    accepted = small.try_push(4);
+    assert(accepted);
+    [[maybe_unused]] int top;
+    [[maybe_unused]] bool popped = small.try_pop(top);
+    assert(popped && top == 4);
+    [[maybe_unused]] StagedPQ<int, BinaryPQ<int>, true, true>::Stats stats = small.stats();
+    assert(stats.pushed == 5 && stats.rejected == 1 && stats.drained == 5);
+    assert(stats.drains == 2 && stats.largestBatch == 2 && stats.meanLatency() > 0.0);
+
+    // Test 4: producers on several threads, and other owner queues
+    cout << "Test 4: concurrent producers..." << endl;
+    StagedPQ<int> binary(64, 16);
+    testStagedPQHelper(binary, 4, 5000);
+    StagedPQ<int, PairingPQ<int>> pairing(16, 4);
+    testStagedPQHelper(pairing, 8, 2000);
+    StagedPQ<int, SortedPQ<int, std::greater<int>>, true, true> sorted(128, 128, std::greater<int>());
+    testStagedPQHelper(sorted, 3, 5000);
+    StagedPQ<int, BinaryPQ<int>, false> single(32, 8);
+    testStagedPQHelper(single, 1, 20000);
+
+    cout << "\n\n********** END: Testing StagedPQ **********\n" << endl;
+} // testStagedPQ()
+
+
+// Test PairingPQ::meld() and BufferedConcurrentPQ: exact order with the
+// buffers in front, and no lost or repeated elements under concurrent
+// pushes and pops.
+void testBufferedConcurrentPQ()
+{
+    cout << "\n\n********** START: Testing BufferedConcurrentPQ **********\n" << endl;
+
+    // Test 1: meld() moves every node and leaves the other heap usable
+    cout << "Test 1: PairingPQ::meld()..." << endl;
+    PairingPQ<int> left, right, empty;
+    for (int i = 0; i < 1000; ++i)
+        (i % 2 ? left : right).push((i * 7919) % 1009);
+    PairingPQ<int>::Node *kept = right.addNode(5000);
+    left.meld(right);
+    left.meld(empty);
+    left.meld(left);
+    empty.meld(left);
+    assert(empty.size() == 1001 && left.empty() && right.empty());
+    right.push(7);
+    assert(right.size() == 1 && right.top() == 7);
+    assert(empty.top() == 5000);
+    empty.updateElt(kept, 6000);
+    assert(empty.top() == 6000);
+    [[maybe_unused]] int last = INT_MAX;
+    while (!empty.empty())
+    {
+        assert(empty.top() <= last);
+        last = empty.top();
+        empty.pop();
+    } // while
+
+    // Test 2: one thread sees an exact queue, buffered elements included
+    cout << "Test 2: one thread..." << endl;
+    BufferedConcurrentPQ<int, std::greater<int>> buffered(2, 8);
+    vector<int> vals;
+    for (int i = 0; i < 5000; ++i)
+        vals.push_back((i * 7919) % 997);
+    for (size_t i = 0; i < vals.size(); ++i)
+    {
+        buffered.push(vals[i]);
+        assert(buffered.size() == i + 1);
+    } // for
+    vector<int> sorted = vals;
+    sort(sorted.begin(), sorted.end());
+    [[maybe_unused]] int top;
+    [[maybe_unused]] bool gotTop = buffered.try_top(top);
+    assert(gotTop && top == sorted[0]);
+    for ([[maybe_unused]] int expect : sorted)
+    {
+        [[maybe_unused]] bool popped = buffered.try_pop(top);
+        assert(popped && top == expect);
+    } // for
+    [[maybe_unused]] bool popped = buffered.try_pop(top);
+    gotTop = buffered.try_top(top);
+    assert(buffered.empty() && !popped && !gotTop);
+    buffered.push(3);
+    buffered.flush();
+    assert(buffered.size() == 1);
+    popped = buffered.try_pop(top);
+    assert(popped && top == 3);
+
+    // Test 3: pushes and pops from several threads, with a buffer each and
+    // with more threads than buffers
+    cout << "Test 3: concurrent pushes and pops..." << endl;
+    BufferedConcurrentPQ<int> ownBuffers(8, 16);
+    testSharedQueueHelper(ownBuffers, 8, 4000);
+    BufferedConcurrentPQ<int> sharedBuffers(3, 64);
+    testSharedQueueHelper(sharedBuffers, 8, 4000);
+
+    cout << "\n\n********** END: Testing BufferedConcurrentPQ **********\n" << endl;
+} // testBufferedConcurrentPQ()
+
+
+// Test PairingPQ::erase() and ConcurrentPairingPQ: handles, commands in
+// posting order, and foreign threads repricing and erasing while the
+// owner pops.
+void testConcurrentPairingPQ()
+{
+    cout << "\n\n********** START: Testing ConcurrentPairingPQ **********\n" << endl;
+
+    // Test 1: addNode() returns the new node, and erase() and updateElt()
+    // on any node keep the heap valid, as does a later updatePriorities()
+    cout << "Test 1: PairingPQ::erase()..." << endl;
+    PairingPQ<int> pairing;
+    multiset<int> expect;
+    vector<PairingPQ<int>::Node *> nodes;
+    for (int i = 0; i < 500; ++i)
+    {
+        const int val = (i * 7919) % 1009;
+        nodes.push_back(pairing.addNode(val));
+        assert(**nodes.back() == val);
+        expect.insert(val);
+    } // for
+    // the popped node is gone, so skip it from here on
+    const size_t popped = static_cast<size_t>(max_element(nodes.begin(), nodes.end(),
+        [](PairingPQ<int>::Node *x, PairingPQ<int>::Node *y) { return **x < **y; }) - nodes.begin());
+    pairing.pop();
+    expect.erase(prev(expect.end()));
+    for (size_t i = 0; i < nodes.size(); i += 7)
+    {
+        if (i == popped)
+            continue;
+        expect.erase(expect.find(**nodes[i]));
+        pairing.erase(nodes[i]);
+    } // for
+    for (size_t i = 3; i < nodes.size(); i += 7)
+    {
+        if (i == popped)
+            continue;
+        expect.erase(expect.find(**nodes[i]));
+        pairing.updateElt(nodes[i], **nodes[i] + 500);
+        expect.insert(**nodes[i]);
+    } // for
+    pairing.updatePriorities();
+    assert(pairing.size() == expect.size());
+    while (!pairing.empty())
+    {
+        assert(pairing.top() == *prev(expect.end()));
+        expect.erase(prev(expect.end()));
+        pairing.pop();
+    } // while
+    PairingPQ<int> empty;
+    empty.updatePriorities();
+    assert(empty.empty());
+
+    // Test 2: commands apply at the next top() or pop(), in posting order,
+    // and not at all once the element is gone
+    cout << "Test 2: commands..." << endl;
+    ConcurrentPairingPQ<int> owned;
+    ConcurrentPairingPQ<int>::Handle a = owned.push(10), b = owned.push(20), c = owned.push(30);
+    owned.update(a, 40);
+    assert(owned.top() == 40);
+    owned.update(a, 5);
+    owned.update(c, 1);
+    owned.update(c, 25);
+    assert(owned.top() == 25);
+    owned.erase(c);
+    owned.update(c, 100);
+    assert(owned.top() == 20 && owned.size() == 2 && !c->live());
+    owned.pop();
+    assert(!b->live() && a->live());
+    owned.update(b, 50);
+    assert(owned.top() == 5);
+    int top;
+    [[maybe_unused]] bool gotTop = owned.try_pop(top);
+    assert(gotTop && top == 5 && !a->live());
+    gotTop = owned.try_pop(top);
+    assert(owned.empty() && !gotTop);
+
+    // Test 3: foreign threads reprice and erase while the owner pops. Each
+    // value keeps its element's id in the low bits, so every popped id
+    // must be distinct, and every id never popped must have been erased.
+    cout << "Test 3: concurrent commands..." << endl;
+    const int elements = 4000, threads = 4;
+    ConcurrentPairingPQ<int> book;
+    vector<ConcurrentPairingPQ<int>::Handle> handles;
+    for (int id = 0; id < elements; ++id)
+        handles.push_back(book.push(((id * 7919) % 1009) << 12 | id));
+
+    std::atomic<bool> go{ false };
+    vector<thread> risk;
+    for (int t = 0; t < threads; ++t)
+    {
+        risk.emplace_back([&handles, &book, &go, t]() {
+            while (!go.load())
+                this_thread::yield();
+            uint32_t seed = static_cast<uint32_t>(t + 1);
+            for (int round = 0; round < 3; ++round)
+            {
+                for (int id = t; id < elements; id += threads)
+                {
+                    seed = seed * 1664525 + 1013904223;
+                    if (id % 10 == 0 && round == 2)
+                        book.erase(handles[static_cast<size_t>(id)]);
+                    else
+                        book.update(handles[static_cast<size_t>(id)],
+                                    static_cast<int>(seed >> 22) << 12 | id);
+                } // for
+            } // for
+        });
+    } // for
+
+    vector<bool> seen(elements, false);
+    go.store(true);
+    for (int i = 0; i < elements / 2 && book.try_pop(top); ++i)
+    {
+        assert(!seen[static_cast<size_t>(top & 4095)]);
+        seen[static_cast<size_t>(top & 4095)] = true;
+    } // for
+    for (thread &worker : risk)
+        worker.join();
+    [[maybe_unused]] int last = INT_MAX;
+    while (book.try_pop(top))
+    {
+        assert(top <= last && !seen[static_cast<size_t>(top & 4095)]);
+        last = top;
+        seen[static_cast<size_t>(top & 4095)] = true;
+    } // while
+    for (int id = 0; id < elements; ++id)
+    {
+        assert(seen[static_cast<size_t>(id)] || id % 10 == 0);
+        assert(!handles[static_cast<size_t>(id)]->live());
+    } // for
+
+    cout << "\n\n********** END: Testing ConcurrentPairingPQ **********\n" << endl;
+} // testConcurrentPairingPQ()
+
+
+// Test NumaTopology, NodeArena and NumaShardedPQ: list parsing, block
+// reuse, a PairingPQ on an arena, and an exact queue over simulated and
+// detected nodes, alone and shared between threads.
+void testNumaShardedPQ()
+{
+    cout << "\n\n********** START: Testing NumaShardedPQ **********\n" << endl;
+
+    // Test 1: topologies
+    cout << "Test 1: topologies..." << endl;
+    assert((NumaTopology::parseList("0-3,8,10-11") == vector<int>{ 0, 1, 2, 3, 8, 10, 11 }));
+    assert(NumaTopology::parseList("").empty() && NumaTopology::parseList("\n").empty());
+    NumaTopology simulated = NumaTopology::simulate(3, 2);
+    assert(simulated.simulated && simulated.nodes() == 3);
+    assert(simulated.nodeOfCpu(0) == 0 && simulated.nodeOfCpu(3) == 1 && simulated.nodeOfCpu(5) == 2);
+    NumaTopology detected = NumaTopology::detect();
+    assert(!detected.simulated && detected.nodes() >= 1);
+    for ([[maybe_unused]] const vector<int> &cpus : detected.cpus)
+        assert(!cpus.empty());
+
+    // Test 2: the arena reuses freed blocks, and holds a whole heap
+    cout << "Test 2: NodeArena..." << endl;
+    {
+        NodeArena arena(-1, 4096);
+        void *first = arena.allocate(24, 8);
+        [[maybe_unused]] void *second = arena.allocate(24, 8);
+        assert(first != second && arena.chunks() == 1 && !arena.bound());
+        arena.deallocate(first, 24, 8);
+        [[maybe_unused]] void *reused = arena.allocate(20, 8);
+        assert(reused == first);
+        void *big = arena.allocate(1000, 8);
+        arena.deallocate(big, 1000, 8);
+
+        using ArenaHeap = PairingPQ<int, std::less<int>, false, 0, ArenaAllocator<int>>;
+        ArenaHeap heap{ std::less<int>{}, ArenaAllocator<int>{ &arena } };
+        for (int i = 0; i < 5000; ++i)
+            heap.push((i * 7919) % 5003);
+        assert(arena.chunks() > 1);
+        ArenaHeap copy(heap);
+        copy = heap;
+        [[maybe_unused]] int last = INT_MAX;
+        while (!heap.empty())
+        {
+            assert(heap.top() <= last && heap.top() == copy.top());
+            last = heap.top();
+            heap.pop();
+            copy.pop();
+        } // while
+    } // scope
+
+    // Test 3: one thread sees an exact queue over every shard
+    cout << "Test 3: exact over simulated shards..." << endl;
+    NumaShardedPQ<int> sharded(NumaTopology::simulate(4));
+    assert(sharded.shard_count() == 4 && !sharded.bound());
+    vector<int> vals;
+    for (int i = 0; i < 4000; ++i)
+        vals.push_back((i * 7919) % 4001);
+    for (size_t i = 0; i < vals.size(); ++i)
+        sharded.push(vals[i], i % 7);
+    assert(sharded.size() == vals.size() && sharded.shard_size(0) > 0 && sharded.shard_size(3) > 0);
+    sort(vals.begin(), vals.end());
+    [[maybe_unused]] int top;
+    [[maybe_unused]] bool gotTop = sharded.try_top(top);
+    assert(gotTop && top == vals.back());
+    for (size_t i = vals.size(); i-- > 0;)
+    {
+        [[maybe_unused]] bool popped = sharded.try_pop(top);
+        assert(popped && top == vals[i]);
+    } // for
+    [[maybe_unused]] bool popped = sharded.try_pop(top);
+    gotTop = sharded.try_top(top);
+    assert(sharded.empty() && !popped && !gotTop);
+
+    // Test 4: pushes and pops from several threads, on simulated nodes and
+    // on the machine's own
+    cout << "Test 4: concurrent pushes and pops..." << endl;
+    NumaShardedPQ<int> shared(NumaTopology::simulate(3));
+    testSharedQueueHelper(shared, 6, 4000);
+    NumaShardedPQ<int> native;
+    assert(native.shard_count() == detected.nodes());
+    testSharedQueueHelper(native, 4, 4000);
+
+    cout << "\n\n********** END: Testing NumaShardedPQ **********\n" << endl;
+} // testNumaShardedPQ()
+
+
+// Test BoundedPQ and BoundedPairingPQ: capacity, try_push(), keep-best-N
+// eviction and updatePriorities(), and that none of them allocate.
+void testBoundedPQ()
+{
+    cout << "\n\n********** START: Testing bounded PQs **********\n" << endl;
+
+    // Test 1: a full queue rejects and stays intact
+    cout << "Test 1: try_push() into a full queue..." << endl;
+    BoundedPQ<int, std::less<int>, 8> heap;
+    BoundedPairingPQ<int, std::less<int>, 0> pairing(8);
+    [[maybe_unused]] size_t before = allocationCount;
+    for (int i = 0; i < 8; ++i)
+    {
+        [[maybe_unused]] bool heapPushed = heap.try_push(i * 3 % 8);
+        [[maybe_unused]] bool pairingPushed = pairing.try_push(i * 5 % 8);
+        assert(heapPushed && pairingPushed);
+    } // for
+    assert(heap.full() && pairing.full() && heap.capacity() == 8 && pairing.capacity() == 8);
+    [[maybe_unused]] bool heapPushed = heap.try_push(100);
+    [[maybe_unused]] bool pairingPushed = pairing.try_push(100);
+    assert(!heapPushed && !pairingPushed);
+    for (int expect = 7; expect >= 0; --expect)
+    {
+        assert(heap.top() == expect && pairing.top() == expect);
+        heap.pop();
+        pairing.pop();
+    } // for
+    assert(heap.empty() && pairing.empty() && !heap.full());
+    assert(allocationCount == before);
+
+    // Test 2: keep-best-N with every layout, capacity and functor kind
+    cout << "Test 2: keep best N..." << endl;
+    BoundedPQ<int, std::less<int>, 16, true> best16;
+    testKeepBestHelper(best16, 16, std::less<int>());
+    BoundedPQ<int, std::greater<int>, 0, true> least100(100);
+    testKeepBestHelper(least100, 100, std::greater<int>());
+    auto byLastDigits = [](int a, int b) { return a % 1000 < b % 1000 || (a % 1000 == b % 1000 && a < b); };
+    BoundedPQ<int, decltype(byLastDigits), 0, true> custom(37, byLastDigits);
+    testKeepBestHelper(custom, 37, byLastDigits);
+    BoundedPairingPQ<int, std::less<int>, 16, true> pairing16;
+    testKeepBestHelper(pairing16, 16, std::less<int>());
+    BoundedPairingPQ<int, std::greater<int>, 0, true> pairing100(100);
+    testKeepBestHelper(pairing100, 100, std::greater<int>());
+
+    // Test 3: handles, updateElt() and erase() on the node pool
+    cout << "Test 3: BoundedPairingPQ handles..." << endl;
+    testBoundedPairingOps();
+
+    // Test 4: updatePriorities() after the priorities change in place
+    cout << "Test 4: updatePriorities()..." << endl;
+    int prios[10] = { 5, 3, 8, 1, 9, 2, 7, 4, 6, 0 };
+    BoundedPQ<int *, IntPtrComp, 10> ptrHeap;
+    BoundedPairingPQ<int *, IntPtrComp, 10> ptrPairing;
+    for (int &prio : prios)
+    {
+        ptrHeap.push(&prio);
+        ptrPairing.push(&prio);
+    } // for
+    for (int &prio : prios)
+        prio = 10 - prio;
+    ptrHeap.updatePriorities();
+    ptrPairing.updatePriorities();
+    for (int expect = 10; expect >= 1; --expect)
+    {
+        assert(*ptrHeap.top() == expect && *ptrPairing.top() == expect);
+        ptrHeap.pop();
+        ptrPairing.pop();
+    } // for
+
+    cout << "\n\n********** END: Testing bounded PQs **********\n" << endl;
+} // testBoundedPQ()
+
+
+
+// Feed a stream to offer() and to offer_batch() of two trackers for k
+// elements, and check both against the first k of the sorted stream.
+template <typename TK, typename COMP>
+void testTopKHelper(TK &one, TK &batch, const vector<int> &stream, size_t k, COMP comp)
+{
+    for (int val : stream)
+        one.offer(val);
+    batch.offer_batch(stream.data(), stream.size());
+
+    vector<int> expected = stream;
+    sort(expected.begin(), expected.end(), [&comp](int a, int b) { return comp(b, a); });
+    expected.resize(min(k, expected.size()));
+    assert(one.snapshot() == expected && batch.snapshot() == expected);
+    assert(one.size() == expected.size() && one.capacity() == k);
+    if (!expected.empty())
+        assert(one.threshold() == expected.back() && batch.threshold() == expected.back());
+} // testTopKHelper()
+
+
+// Test TopK: offer() and offer_batch() against sorting, the fast reject,
+// merging trackers fed on several threads, and clear().
+void testTopK()
+{
+    cout << "\n\n********** START: Testing TopK **********\n" << endl;
+
+    vector<int> stream;
+    unsigned state = 12345;
+    for (int i = 0; i < 100000; ++i)
+    {
+        state = state * 1103515245u + 12345u;
+        stream.push_back(static_cast<int>((state >> 8) % 1000000));
+    } // for
+
+    // Test 1: offer() and offer_batch() keep the same K as a full sort
+    cout << "Test 1: offer() and offer_batch() vs sorting..." << endl;
+    TopK<int, std::less<int>, 10> max10, max10Batch;
+    testTopKHelper(max10, max10Batch, stream, 10, std::less<int>());
+    TopK<int, std::greater<int>> min100(100), min100Batch(100);
+    testTopKHelper(min100, min100Batch, stream, 100, std::greater<int>());
+    auto byLastDigits = [](int a, int b) { return a % 1000 < b % 1000 || (a % 1000 == b % 1000 && a < b); };
+    TopK<int, decltype(byLastDigits)> custom(37, byLastDigits), customBatch(37, byLastDigits);
+    testTopKHelper(custom, customBatch, stream, 37, byLastDigits);
+    vector<int> few(stream.begin(), stream.begin() + 5);
+    TopK<int> notFull(10), notFullBatch(10);
+    testTopKHelper(notFull, notFullBatch, few, 10, std::less<int>());
+
+    // Test 2: an element that cannot beat the K-th best is rejected
+    cout << "Test 2: fast reject..." << endl;
+    TopK<int, std::less<int>, 3> top3;
+    [[maybe_unused]] bool took5 = top3.offer(5);
+    [[maybe_unused]] bool took1 = top3.offer(1);
+    [[maybe_unused]] bool took3 = top3.offer(3);
+    assert(took5 && took1 && took3 && top3.full());
+    assert(top3.threshold() == 1);
+    [[maybe_unused]] bool took0 = top3.offer(0);
+    took1 = top3.offer(1);
+    assert(!took0 && !took1);
+    [[maybe_unused]] bool took4 = top3.offer(4);
+    assert(took4 && top3.threshold() == 3);
+    assert((top3.snapshot() == vector<int>{ 5, 4, 3 }));
+
+    // Test 3: trackers fed on separate threads merge into the global top K
+    cout << "Test 3: merge() per-thread trackers..." << endl;
+    const size_t parts = 4;
+    vector<TopK<int>> partial(parts, TopK<int>(50));
+    vector<thread> workers;
+    const size_t slice = stream.size() / parts;
+    for (size_t t = 0; t < parts; ++t)
+    {
+        workers.emplace_back([&partial, &stream, slice, t]() {
+            partial[t].offer_batch(stream.data() + t * slice, slice);
+        });
+    } // for
+    for (thread &worker : workers)
+        worker.join();
+    TopK<int> merged(50), whole(50);
+    for (const TopK<int> &part : partial)
+        merged.merge(part);
+    whole.offer_batch(stream.data(), stream.size());
+    assert(merged.snapshot() == whole.snapshot());
+
+    // Test 4: a tracker for no elements rejects every offer
+    cout << "Test 4: K = 0..." << endl;
+    TopK<int> none(0);
+    [[maybe_unused]] bool tookAny = none.offer(1);
+    assert(!tookAny && none.size() == 0);
+    none.offer_batch(stream.data(), stream.size());
+    none.merge(whole);
+    assert(none.size() == 0 && none.snapshot().empty());
+
+    // Test 5: clear() forgets everything but K
+    cout << "Test 5: clear()..." << endl;
+    merged.clear();
+    assert(merged.size() == 0 && !merged.full() && merged.capacity() == 50);
+    [[maybe_unused]] bool tookLow = merged.offer(-1);
+    assert(tookLow && merged.threshold() == -1);
+
+    cout << "\n\n********** END: Testing TopK **********\n" << endl;
+} // testTopK()
+
+
+
+// Push orders with few distinct prices and check that equal prices come out
+// in arrival order, for pushes and for the range ctor.
+template <typename PQ>
+void testStableHelper(const string &pqType)
+{
+    cout << "Testing stable " << pqType << "..." << endl;
+
+    vector<pair<int, int>> orders;
+    for (int i = 0; i < 500; ++i)
+        orders.emplace_back((i * 37) % 7, i);
+
+    PQ pushed;
+    for (const auto &order : orders)
+        pushed.push(order);
+    PQ ranged(orders.begin(), orders.end());
+    PQ batched;
+    for (size_t i = 0; i < orders.size(); i += 37)
+        batched.push_range(orders.begin() + static_cast<ptrdiff_t>(i),
+                           orders.begin() + static_cast<ptrdiff_t>(min(i + 37, orders.size())));
+
+    for (PQ *pq : {&pushed, &ranged, &batched})
+    {
+        pair<int, int> prev = pq->top();
+        pq->pop();
+        while (!pq->empty())
+        {
+            pair<int, int> cur = pq->top();
+            assert(cur.first < prev.first ||
+                   (cur.first == prev.first && cur.second > prev.second));
+            prev = cur;
+            pq->pop();
+        } // while
+    } // for
+} // testStableHelper()
+
+
+// Test the STABLE (FIFO among equal priorities) mode of every PQ that has one.
+void testStable()
+{
+    cout << "\n\n********** START: Testing stable mode **********\n" << endl;
+
+    testStableHelper<BinaryPQ<pair<int, int>, PriorityOnly, true>>("BinaryPQ");
+    testStableHelper<PairingPQ<pair<int, int>, PriorityOnly, true>>("PairingPQ");
+    testStableHelper<SortedPQ<pair<int, int>, PriorityOnly, true>>("SortedPQ");
+    testStableHelper<TieredSortedPQ<pair<int, int>, PriorityOnly, true>>("TieredSortedPQ");
+    testStableHelper<UnorderedPQ<pair<int, int>, PriorityOnly, true>>("UnorderedPQ");
+    testStableHelper<UnorderedFastPQ<pair<int, int>, PriorityOnly, true>>("UnorderedFastPQ");
+    testStableHelper<AdaptivePQ<pair<int, int>, PriorityOnly, true>>("AdaptivePQ");
+    testStableHelper<SortedPQ<pair<int, int>, PriorityOnly, true, 16>>("inline SortedPQ");
+    testStableHelper<PairingPQ<pair<int, int>, PriorityOnly, true, 16>>("inline PairingPQ");
+
+    // updateElt() sends a repriced order to the back of its new price level
+    PairingPQ<pair<int, int>, PriorityOnly, true> book;
+    auto *moved = book.addNode({1, 0});
+    book.push({5, 1});
+    book.push({5, 2});
+    book.updateElt(moved, {5, 3});
+    for ([[maybe_unused]] int arrival : {1, 2, 3})
+    {
+        assert(book.top().second == arrival);
+        book.pop();
+    } // for
+
+    // a copy keeps the arrival order of the original
+    BinaryPQ<pair<int, int>, PriorityOnly, true> orig;
+    for (int i = 0; i < 10; ++i)
+        orig.push({i % 2, i});
+    BinaryPQ<pair<int, int>, PriorityOnly, true> copy(orig);
+    copy.push({1, 10});
+    for ([[maybe_unused]] int arrival : {1, 3, 5, 7, 9, 10, 0, 2, 4, 6, 8})
+    {
+        assert(copy.top().second == arrival);
+        copy.pop();
+    } // for
+
+    cout << "\n\n********** END: Testing stable mode **********\n" << endl;
+} // testStable()
+
+
+
 int main()
 {
     // Basic pointer, allocate a new PQ later based on user choice.
@@ -1765,22 +4020,48 @@ int main()
     {
         // Test using the default comparator, 
         // which organizes in ascending order.
+        testArgExtreme();
         pq1 = new UnorderedPQ<int>;
         pq2 = new UnorderedPQ<int>(start, end);
     } // if
     else if (choice == 1)
     {
+        testArgExtreme();
+        testUnorderedFastPQ();
         pq1 = new UnorderedFastPQ<int>;
         pq2 = new UnorderedFastPQ<int>(start, end);
     } // else if
     else if (choice == 2)
     {
+        testIntPQ();
+        testTieredSortedPQ();
+        testSortedPQBuffer();
+        testFastLowerBound();
+        testSortedPQViews();
+        testParallelRebuildHelper<SortedPQ<int *, IntPtrComp>>("SortedPQ",
+            [](const SortedPQ<int *, IntPtrComp> &pq) { return vector<int *>(pq.begin(), pq.end()); });
         pq1 = new SortedPQ<int>;
         pq2 = new SortedPQ<int>(start, end);
     } // else if
     else if (choice == 3)
     {
         binTests();
+        testLoserTree();
+        testIndexedBinaryPQ();
+        testBinaryPQViews();
+        testPopBatch();
+        testParallelRebuildHelper<BinaryPQ<int *, IntPtrComp>>("BinaryPQ",
+            [](const BinaryPQ<int *, IntPtrComp> &pq)
+            { return vector<int *>(pq.heap_order().begin(), pq.heap_order().end()); });
+        testParallelRebuildHelper<BinaryPQ<int *, IntPtrComp, true>>("stable BinaryPQ",
+            [](const BinaryPQ<int *, IntPtrComp, true> &pq)
+            { return vector<int *>(pq.heap_order().begin(), pq.heap_order().end()); });
+        testAdaptivePQ();
+        testInlineStorage();
+        testConcurrentPQs();
+        testMultiQueue();
+        testTaskScheduler();
+        testStagedPQ();
         pq1 = new BinaryPQ<int>;
         pq2 = new BinaryPQ<int>(start, end);
     } // else if
@@ -1790,6 +4071,11 @@ int main()
         vec.push_back(0);
         vec.push_back(1);
         testPairing(vec);
+        testBoundedPQ();
+        testTopK();
+        testBufferedConcurrentPQ();
+        testConcurrentPairingPQ();
+        testNumaShardedPQ();
 
         pq1 = new PairingPQ<int>;
         pq2 = new PairingPQ<int>(start, end);
@@ -1817,6 +4103,8 @@ int main()
 
     specialTests2(types[choice]);
     
+    testStable();
+    
     // Clean up!
     delete pq1;
     delete pq2;